@@ -1,6 +1,15 @@
 #version 450
 
+// Permutations : see 'ShaderFeature' (vk/permutation.hpp), ids must match the bit index
+layout(constant_id = 0) const bool HAS_TANGENT = false;
+layout(constant_id = 1) const bool FOG         = false;
+layout(constant_id = 2) const bool SUN         = false;
+
 layout (location = 0) in vec3 fColor;
+layout (location = 1) in vec3 fNormal;
+layout (location = 2) in vec4 fTangent;
+layout (location = 3) in vec3 fViewDir;
+layout (location = 4) in float fViewDepth;
 
 layout (location = 0) out vec4 FragColor;
 
@@ -14,6 +23,32 @@ layout(set = 0, binding = 1) uniform  SceneData{
 
 void main()
 {
-    FragColor = vec4(fColor, 1.0);
-    FragColor = vec4(fColor + scene.ambientColor.xyz,1.0f);
+	vec3 color = fColor + scene.ambientColor.xyz;
+
+	if (SUN)
+	{
+		vec3 N = normalize(fNormal);
+		vec3 L = normalize(-scene.sunlightDirection.xyz);
+		vec3 V = normalize(fViewDir);
+
+		float light = max(dot(N, L), 0.0);
+
+		// Anisotropic highlight along the authored tangent (Kajiya-Kay)
+		if (HAS_TANGENT)
+		{
+			vec3  T   = normalize(fTangent.xyz);
+			float TdH = dot(T, normalize(L + V));
+			light    += 0.25 * pow(sqrt(max(1.0 - TdH * TdH, 0.0)), 64.0);
+		}
+
+		color += scene.sunlightColor.xyz * scene.sunlightDirection.w * light;
+	}
+
+	if (FOG)
+	{
+		float fog = smoothstep(scene.fogDistances.x, scene.fogDistances.y, fViewDepth);
+		color     = mix(color, scene.fogColor.xyz, pow(fog, scene.fogColor.w));
+	}
+
+	FragColor = vec4(color, 1.0);
 }
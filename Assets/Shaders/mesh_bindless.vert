@@ -0,0 +1,56 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Permutations : see 'ShaderFeature' (vk/permutation.hpp), ids must match the bit index
+layout(constant_id = 0) const bool HAS_TANGENT = false;
+
+layout (location = 0) in vec3 vPosition;
+layout (location = 1) in vec2 vUV0;
+layout (location = 2) in vec3 vNormal;
+layout (location = 3) in vec4 vTanget;
+
+layout (location = 0) out vec3 fColor;
+layout (location = 1) out vec3 fNormal;    // world
+layout (location = 2) out vec4 fTangent;   // world, w : handedness
+layout (location = 3) out vec3 fViewDir;   // world, surface to eye
+layout (location = 4) out float fViewDepth;
+
+layout(set = 0, binding = 0) uniform Camera
+{
+	mat4 view;
+	mat4 proj;
+	mat4 viewproj;
+} uCam;
+
+struct ModelData
+{
+	mat4 normal;
+	mat4 model;
+};
+
+// Bindless table : every storage buffer of the renderer, picked by index
+layout(std430, set = 1, binding = 0) readonly buffer Objects
+{
+	ModelData data[];
+} uObjects[];
+
+layout(push_constant) uniform Constants
+{
+	uint objects;  // slot of this frame's object buffer
+} uConsts;
+
+void main()
+{
+	ModelData object = uObjects[uConsts.objects].data[gl_InstanceIndex];
+
+	vec4 worldPos = object.model * vec4(vPosition, 1.0);
+	vec4 viewPos  = uCam.view * worldPos;
+	vec3 eyePos   = -transpose(mat3(uCam.view)) * uCam.view[3].xyz;
+
+	gl_Position = uCam.proj * viewPos;
+	fColor      = vec3(0.3,0.3,0.3) * vNormal;
+	fNormal     = mat3(object.normal) * vNormal;
+	fTangent    = HAS_TANGENT ? vec4(mat3(object.model) * vTanget.xyz, vTanget.w) : vec4(0.0);
+	fViewDir    = eyePos - worldPos.xyz;
+	fViewDepth  = viewPos.z;
+}
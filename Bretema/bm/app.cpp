@@ -3,7 +3,10 @@
 namespace bm
 {
 
-App::App(std::string name, RenderAPI renderAPI) : mName(std::move(name)), mRenderAPI(renderAPI)
+App::App(std::string name, RenderAPI renderAPI, RendererSettings settings)
+  : mName(std::move(name))
+  , mRenderAPI(renderAPI)
+  , mSettings(settings)
 {
     BM_INFOF("Initializing Bretema Engine #{}.{}", BM_VERSION_MAJOR, BM_VERSION_MINOR);
 
@@ -14,18 +17,25 @@ App::App(std::string name, RenderAPI renderAPI) : mName(std::move(name)), mRende
       BM_STR_PTR(mRenderer));
 
     // Init window
-    mMainWindow = sNew<Window>(1920, 1080, "Default Window", this);
+    if (!mSettings.headless)
+        mMainWindow = sNew<Window>(1920, 1080, "Default Window", this);
 
     // Init renderer
     switch (mRenderAPI)
     {
-        case Vulkan: mRenderer = new vk::Renderer(mMainWindow); break;
+        case Vulkan: mRenderer = new vk::Renderer(mMainWindow, mSettings); break;
         default: BM_ABORT("Selected renderer is not implemented yet!"); break;
     }
 }
 
 void App::runLoop()
 {
+    if (mSettings.headless)
+    {
+        BM_WARN("Headless apps have no window to loop on, use 'runHeadless'");
+        return;
+    }
+
     while (true)
     {
         run();
@@ -43,50 +53,248 @@ void App::runLoop()
 
 void App::run()
 {
+    BM_PROFILE_THREAD("Main");
+
+    mSnapshots    = uNew<ds::TripleBuffer<FrameSnapshot>>();
+    mRenderThread = std::thread([this]() { renderLoop(); });
+
     bool isAnyWindowOpen = true;  // NOTE: In a future we'll support many windows at once
+    bool idle            = false;
 
     while (isAnyWindowOpen)
     {
         isAnyWindowOpen = false;
 
-        for (auto &window : { mMainWindow })
+        BM_PROFILE_FRAME(mSimFrame);
+
+        // Pace on the render thread : it took the previous snapshot, so this one is simulated while that one renders.
+        // Then sample input as late as possible, right before it's consumed
         {
-            //--- FPS
-            std::string et = mETimer.elapsedStr();
-            window->titleInfo(et);
-            mETimer.reset();
-            //---
+            BM_PROFILE_ZONE("WaitConsumed");
+            mSnapshots->waitConsumed();
+        }
 
-            //--- Update
-            mRenderer->update();
+        // Nothing changed last time : sleep until the OS or the renderer has something for us
+        if (idle)
+        {
+            BM_PROFILE_ZONE("WaitEvents");
+            bm::Window::waitEvents(sIdleWait);
+            mFrameStats.restart();  // Sleeping isn't a slow frame
+        }
+        else
+        {
+            BM_PROFILE_ZONE("PollEvents");
+            bm::Window::pollEvents();
+        }
 
+        for (auto &window : { mMainWindow })
+        {
+            //--- Update
             for (auto &camera : mCameras)
             {
+                BM_PROFILE_ZONE("Camera");
                 camera.update(1.77777f, INF3);
             }
             //---
 
-            //--- Draw
-            auto const &mainCamera = mCameras.at(0);
-            mRenderer->draw(mainCamera);
+            //--- Render on demand
+            idle = mSettings.onDemand && !needsRedraw(*window);
             //---
 
+            if (!idle)
+            {
+                //--- FPS
+                mFrameStats.tick();
+                refreshTitle(*window);
+                //---
+
+                //--- Hand-off to the render thread
+                publishSnapshot(*window);
+                //---
+            }
+
             //--- Close
             bool const close = window->isMarkedToClose();
 
             if (close)
             {
-                // WARNING : This should trigger something on 'SelectedRenderer' ??
+                // The render thread must be done with the surface before its window goes away
+                stopRenderThread();
                 window->destroy();
             }
 
             isAnyWindowOpen |= !close;
             //---
         }
+    }
+
+    stopRenderThread();
+
+    BM_PROFILE_DUMP("Bretema.trace.json", bm::prof::Profiler::sMaxFrames);
+}
+
+void App::runHeadless(u32 frames, std::string const &pngPath)
+{
+    BM_ASSERT_X(mSettings.headless, "'runHeadless' requires 'RendererSettings::headless'");
+
+    // No window, no events : simulate and render on this very thread
+    FrameSnapshot snap = {};
+    snap.size          = glm::vec2(mSettings.headlessSize);
+    float const ar     = snap.size.x / snap.size.y;
+
+    for (u32 i = 0; i < frames; ++i)
+    {
+        auto &mainCamera = mCameras.at(0);
+        mainCamera.update(ar, INF3);
+
+        snap.frame = mSimFrame++;
+        snap.view  = mainCamera.V();
+        snap.proj  = mainCamera.P();
+
+        mRenderer->beginFrame();
+        mRenderer->update(snap);
+        mRenderer->draw(snap);
 
-        // bm::Window::waitEvents();  // WARNING: Prefer this one!
-        bm::Window::pollEvents();
+        mFrameStats.tick();
     }
+
+    if (auto const S = mFrameStats.summary(); S.count > 0)
+        BM_INFOF("Headless : {} frames | avg {:.3f} ms | p50 {:.3f} | p95 {:.3f} | p99 {:.3f}", frames, S.avg, S.p50, S.p95, S.p99);
+
+    if (!pngPath.empty() && mRenderer->capture(pngPath))
+        BM_INFOF("Captured frame #{} into {}", mSimFrame, pngPath);
+
+    cleanup();
+}
+
+bool App::loadScene(std::string const &path)
+{
+    SceneFile file;
+
+    if (!mRenderer || !loadSceneFile(path, file))
+        return false;
+
+    // Cameras belong to this thread, the scene to the renderer
+    if (!file.cameras.empty())
+        mCameras = std::move(file.cameras);
+
+    runOnRenderThread(
+      [this, path, file = std::move(file)]()
+      {
+          if (!mRenderer->importScene(sScene, file))
+              BM_ERRF("Load scene {} : couldn't instance it", path);
+      });
+
+    return true;
+}
+
+bool App::saveScene(std::string const &path)
+{
+    if (!mRenderer)
+        return false;
+
+    // Cameras as of now, the scene as of the frame that runs the job
+    runOnRenderThread([this, path, cameras = mCameras]() { mRenderer->saveScene(sScene, path, cameras); });
+    return true;
+}
+
+void App::runOnRenderThread(std::function<void()> job)
+{
+    if (mRenderThread.joinable())
+        mRenderer->queueJob(std::move(job));
+    else
+        job();
+}
+
+void App::renderLoop()
+{
+    BM_PROFILE_THREAD("Render");
+
+    while (true)
+    {
+        {
+            BM_PROFILE_ZONE("BeginFrame");
+            mRenderer->beginFrame();
+        }
+
+        {
+            BM_PROFILE_ZONE("WaitSnapshot");
+            if (!mSnapshots->waitFetch())
+                break;
+        }
+
+        BM_PROFILE_ZONE("Frame");
+        mRenderer->runJobs();
+
+        auto const &snap = mSnapshots->front();
+        mRenderer->update(snap);
+        mRenderer->draw(snap);
+    }
+}
+
+void App::publishSnapshot(Window const &window)
+{
+    BM_PROFILE_ZONE("Publish");
+
+    auto const &mainCamera = mCameras.at(0);
+    auto       &snap       = mSnapshots->back();
+
+    snap.frame     = mSimFrame++;
+    snap.view      = mainCamera.V();
+    snap.proj      = mainCamera.P();
+    snap.size      = window.size();
+    snap.inputTime = mUserInput.lastChange();
+    snap.pick      = true;
+    snap.pickRay   = mainCamera.ray(mUserInput.cursor(), snap.size);
+
+    mPublishedVP   = mainCamera.VP();
+    mPublishedSize = snap.size;
+
+    mSnapshots->publish();
+}
+
+void App::refreshTitle(Window &window)
+{
+    // 'glfwSetWindowTitle' is a round-trip to the window system, per frame it shows up in the frame time
+    auto const now = Clock::now();
+    if (now - mLastTitle < sTitlePeriod)
+        return;
+    mLastTitle = now;
+
+    auto const S = mFrameStats.summary();
+    window.titleInfo(BM_FMT(
+      "{:.0f} fps | avg {:.2f} ms | p50 {:.2f} | p99 {:.2f} | max {:.2f} | gpu {:.2f} ms | input-to-present {:.1f} ms",
+      S.fps(),
+      S.avg,
+      S.p50,
+      S.p99,
+      S.max,
+      mRenderer->gpuTime(),
+      mRenderer->inputLatency()));
+}
+
+bool App::needsRedraw(Window &window)
+{
+    // Every source is consumed, short-circuiting would leave a stale flag for the next check
+    bool dirty = mUserInput.consumeChanged();
+    dirty |= mRenderer->consumeRedraw();
+    dirty |= window.consumeDamage();
+    dirty |= window.isMarkedToClose();
+    dirty |= window.size() != mPublishedSize;
+    dirty |= mCameras.at(0).VP() != mPublishedVP;  // Held keys keep moving it without new events
+
+    return dirty;
+}
+
+void App::stopRenderThread()
+{
+    if (!mRenderThread.joinable())
+        return;
+
+    mSnapshots->close();
+    mRenderThread.join();
+
+    mRenderer->runJobs();  // Queued after its last frame, nobody else would run them
 }
 
 void App::cleanup()
@@ -100,7 +308,7 @@ void App::cleanup()
 
 void App::reset()
 {
-    *this = { mName, mRenderAPI };
+    *this = { mName, mRenderAPI, mSettings };
 }
 
 std::string App::name() const
@@ -6,6 +6,11 @@
 #include "renderer.hpp"
 #include "camera.hpp"
 #include "userInput.hpp"
+#include "tripleBuffer.hpp"
+#include "profiler.hpp"
+#include "frameStats.hpp"
+
+#include <thread>
 
 namespace bm
 {
@@ -22,12 +27,26 @@ enum RenderAPI
 class App
 {
 public:
-    App(std::string name, RenderAPI renderAPI);
+    using Clock = std::chrono::steady_clock;
+
+    App(std::string name, RenderAPI renderAPI, RendererSettings settings = {});
 
     std::string name() const;
     void        runLoop();
+    void        runHeadless(u32 frames, std::string const &pngPath = "");  // Fixed frame count, optional capture
     bool        isMarkedToClose() const;
 
+    inline FrameStats const &frameStats() const { return mFrameStats; }
+
+    // Scene files (see 'SceneFile') for the scene being drawn, cameras included. Safe while running : the file is read
+    // (or the cameras copied) here, what touches the scenes runs on the render thread before its next frame. Then the
+    // result only covers this side, failures over there are logged
+    bool loadScene(std::string const &path);
+    bool saveScene(std::string const &path);
+
+    // What the cursor hovers, answered by the renderer a frame or so after the cursor got there
+    inline PickResult hovered() const { return mRenderer ? mRenderer->picked() : PickResult {}; }
+
 private:
     friend class Window;
 
@@ -36,8 +55,16 @@ private:
     void cleanup();
     void markToClose();
 
-    std::string mName      = "";
-    RenderAPI   mRenderAPI = RenderAPI::Vulkan;
+    void renderLoop();  // Render thread body
+    void publishSnapshot(Window const &window);
+    bool needsRedraw(Window &window);  // Render-on-demand : anything changed since the last published snapshot
+    void refreshTitle(Window &window);  // Throttled to 'sTitlePeriod'
+    void stopRenderThread();
+    void runOnRenderThread(std::function<void()> job);  // Inline when it isn't running
+
+    std::string      mName      = "";
+    RenderAPI        mRenderAPI = RenderAPI::Vulkan;
+    RendererSettings mSettings  = {};
 
     bool mInit  = false;
     bool mClose = false;
@@ -45,14 +72,31 @@ private:
     sPtr<bm::Window>  mMainWindow = nullptr;
     bm::BaseRenderer *mRenderer   = nullptr;
 
+    // Main thread simulates and publishes, render thread records and submits the newest snapshot
+    std::thread                           mRenderThread = {};
+    uPtr<ds::TripleBuffer<FrameSnapshot>> mSnapshots    = nullptr;
+    u64                                   mSimFrame     = 0;
+
+    // What the last published snapshot saw, to detect changes in render-on-demand mode
+    glm::mat4 mPublishedVP   = glm::mat4 { 0.f };
+    glm::vec2 mPublishedSize = ZERO2;
+
+    inline static constexpr double sIdleWait = 0.25;  // Secs, upper bound of an idle sleep on events
+
     std::vector<Camera> mCameras = { sDefaultCamera };
-    bm::Timer_Ms        mETimer  = { "MainLoop" };
+
+    // Frame times of the main loop, the title shows a summary of them a few times per second
+    FrameStats        mFrameStats = {};
+    Clock::time_point mLastTitle  = {};
+
+    inline static constexpr auto sTitlePeriod = std::chrono::milliseconds(250);
 
     // clang-format off
     UserInput mUserInput { [this](UserInput *ui) { if (ui) for (auto &camera : mCameras) camera.onInputChange(*ui); } };
     // clang-format on
 
-    inline static Camera const sDefaultCamera { "Main" };
+    inline static Camera const      sDefaultCamera { "Main" };
+    inline static StrId const sScene = FrameSnapshot {}.scene;  // What every snapshot draws
 };
 
 }  // namespace bm
\ No newline at end of file
@@ -0,0 +1,401 @@
+#include "bvh.hpp"
+
+namespace bm
+{
+
+//-----------------------------------------------------------------------------
+
+static constexpr u32 sMaxDepth = 32;  // Deeper splits go by median, keeping the tree under the traversal stacks
+
+//-----------------------------------------------------------------------------
+
+Bvh::~Bvh()
+{
+    if (mPending.valid())
+        mPending.wait();
+}
+
+//-----------------------------------------------------------------------------
+
+float Bvh::nodeCost(Node const &node)
+{
+    return node.box.area() * (node.isLeaf() ? (float)node.count : 1.f);
+}
+
+//-----------------------------------------------------------------------------
+
+Bvh::Tree Bvh::buildTree(std::vector<math::AABB> const &boxes, std::vector<u8> const &alive)
+{
+    Tree T;
+    T.leafOf.assign(boxes.size(), sNone);
+
+    // Partitioned in place of the item ids so every pass over a node reads memory linearly
+    struct Ref
+    {
+        math::AABB box      = {};
+        glm::vec3  centroid = {};
+        u32        item     = 0;
+    };
+
+    std::vector<Ref> refs;
+
+    for (u32 i = 0; i < (u32)boxes.size(); ++i)
+        if (alive[i] && !boxes[i].empty())
+            refs.push_back({ boxes[i], boxes[i].center(), i });
+
+    if (refs.empty())
+        return T;
+
+    T.nodes.reserve(refs.size() * 2);
+    T.nodes.push_back({ {}, 0, (u32)refs.size(), sNone });
+
+    struct Task
+    {
+        u32 node  = 0;
+        u32 depth = 0;
+    };
+
+    std::vector<Task> tasks = { { 0, 0 } };
+
+    while (!tasks.empty())
+    {
+        auto const task = tasks.back();
+        tasks.pop_back();
+
+        u32 const first = T.nodes[task.node].first;
+        u32 const count = T.nodes[task.node].count;
+
+        math::AABB box, centroidBox;
+        for (u32 i = first; i < first + count; ++i)
+        {
+            box.expand(refs[i].box);
+            centroidBox.expand(refs[i].centroid);
+        }
+        T.nodes[task.node].box = box;
+
+        if (count <= 1)
+            continue;
+
+        //--- Binned SAH : cost of a split relative to testing every item of this node
+
+        float const     parentArea = std::max(box.area(), EPSILON);
+        glm::vec3 const extent     = centroidBox.max - centroidBox.min;
+
+        float bestCost  = INF;
+        i32   bestAxis  = -1;
+        u32   bestSplit = 0;  // Bins [0, bestSplit] go left
+
+        auto const binOf = [&](Ref const &ref, i32 axis)
+        {
+            float const rel = (ref.centroid[axis] - centroidBox.min[axis]) / extent[axis];
+            return std::min(sBins - 1, (u32)(rel * sBins));
+        };
+
+        for (i32 axis = 0; axis < 3 && task.depth < sMaxDepth; ++axis)
+        {
+            if (extent[axis] <= 0.f)
+                continue;
+
+            std::array<math::AABB, sBins> binBox   = {};
+            std::array<u32, sBins>        binCount = {};
+
+            for (u32 i = first; i < first + count; ++i)
+            {
+                u32 const b = binOf(refs[i], axis);
+                binBox[b].expand(refs[i].box);
+                ++binCount[b];
+            }
+
+            // Right-to-left sweep first, then evaluate every plane while sweeping left-to-right
+            std::array<float, sBins> rightArea  = {};
+            std::array<u32, sBins>   rightCount = {};
+            math::AABB               acc        = {};
+            u32                      n          = 0;
+
+            for (u32 b = sBins - 1; b > 0; --b)
+            {
+                acc.expand(binBox[b]);
+                n += binCount[b];
+                rightArea[b - 1]  = acc.area();
+                rightCount[b - 1] = n;
+            }
+
+            acc = {};
+            n   = 0;
+
+            for (u32 b = 0; b < sBins - 1; ++b)
+            {
+                acc.expand(binBox[b]);
+                n += binCount[b];
+
+                if (n == 0 || rightCount[b] == 0)
+                    continue;
+
+                float const cost = 1.f + (acc.area() * n + rightArea[b] * rightCount[b]) / parentArea;
+                if (cost < bestCost)
+                {
+                    bestCost  = cost;
+                    bestAxis  = axis;
+                    bestSplit = b;
+                }
+            }
+        }
+
+        //--- Split, or keep as a leaf when splitting doesn't pay off and the leaf is small enough
+
+        u32 mid = first;
+
+        if (bestAxis >= 0 && (bestCost < (float)count || count > sMaxLeafItems))
+        {
+            auto const begin = refs.begin() + first;
+            auto const it    = std::partition(begin, begin + count, [&](Ref const &ref) { return binOf(ref, bestAxis) <= bestSplit; });
+            mid              = (u32)(it - refs.begin());
+        }
+        else if (count > sMaxLeafItems)
+        {
+            // Nothing to bin (same centroid) or too deep : halve by count along the widest centroid axis
+            i32 const  axis  = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+            auto const begin = refs.begin() + first;
+            mid              = first + count / 2;
+            std::nth_element(begin, refs.begin() + mid, begin + count, [&](Ref const &a, Ref const &b) { return a.centroid[axis] < b.centroid[axis]; });
+        }
+        else
+        {
+            continue;
+        }
+
+        if (mid == first || mid == first + count)
+            mid = first + count / 2;
+
+        u32 const left = (u32)T.nodes.size();
+        T.nodes.push_back({ {}, first, mid - first, task.node });
+        T.nodes.push_back({ {}, mid, first + count - mid, task.node });
+
+        T.nodes[task.node].first = left;
+        T.nodes[task.node].count = 0;
+
+        tasks.push_back({ left + 1, task.depth + 1 });
+        tasks.push_back({ left, task.depth + 1 });
+    }
+
+    T.items.resize(refs.size());
+    for (size_t i = 0; i < refs.size(); ++i) T.items[i] = refs[i].item;
+
+    for (u32 n = 0; n < (u32)T.nodes.size(); ++n)
+    {
+        auto const &node = T.nodes[n];
+        T.cost += nodeCost(node);
+
+        if (node.isLeaf())
+            for (u32 i = node.first; i < node.first + node.count; ++i) T.leafOf[T.items[i]] = n;
+    }
+
+    return T;
+}
+
+//-----------------------------------------------------------------------------
+
+void Bvh::build(std::vector<math::AABB> const &boxes)
+{
+    clear();
+
+    mBoxes = boxes;
+    mIsAlive.resize(boxes.size());
+
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        mIsAlive[i] = !boxes[i].empty();
+        mAlive += mIsAlive[i];
+    }
+
+    adopt(buildTree(mBoxes, mIsAlive));
+}
+
+void Bvh::clear()
+{
+    if (mPending.valid())
+        mPending.wait();
+
+    mTree      = {};
+    mBuildCost = 0.f;
+    mBoxes.clear();
+    mIsAlive.clear();
+    mAlive = 0;
+    mLoose.clear();
+    mDirty.clear();
+    mIsDirty.clear();
+    mPending = {};
+    mChangedSince.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+void Bvh::insert(u32 item, math::AABB const &box)
+{
+    if (alive(item))
+    {
+        update(item, box);
+        return;
+    }
+
+    if (item >= mBoxes.size())
+    {
+        mBoxes.resize(item + 1);
+        mIsAlive.resize(item + 1, 0);
+    }
+
+    mBoxes[item]   = box;
+    mIsAlive[item] = 1;
+    ++mAlive;
+
+    // A recycled id may still sit in a leaf (as dead), refitting it there is cheaper than a loose entry
+    if (item < mTree.leafOf.size() && mTree.leafOf[item] != sNone)
+        markDirty(mTree.leafOf[item]);
+    else
+        mLoose.push_back(item);
+
+    if (rebuilding())
+        mChangedSince.push_back(item);
+}
+
+void Bvh::update(u32 item, math::AABB const &box)
+{
+    BM_ASSERT(alive(item));
+
+    mBoxes[item] = box;
+
+    if (item < mTree.leafOf.size() && mTree.leafOf[item] != sNone)
+        markDirty(mTree.leafOf[item]);
+
+    if (rebuilding())
+        mChangedSince.push_back(item);
+}
+
+void Bvh::remove(u32 item)
+{
+    if (!alive(item))
+        return;
+
+    mIsAlive[item] = 0;
+    --mAlive;
+
+    if (item < mTree.leafOf.size() && mTree.leafOf[item] != sNone)
+    {
+        markDirty(mTree.leafOf[item]);  // Queries skip it already, refitting shrinks the leaf
+    }
+    else if (auto const it = std::find(mLoose.begin(), mLoose.end(), item); it != mLoose.end())
+    {
+        *it = mLoose.back();
+        mLoose.pop_back();
+    }
+
+    if (rebuilding())
+        mChangedSince.push_back(item);
+}
+
+//-----------------------------------------------------------------------------
+
+void Bvh::markDirty(u32 node)
+{
+    if (mIsDirty[node])
+        return;
+
+    mIsDirty[node] = 1;
+    mDirty.push_back(node);
+    std::push_heap(mDirty.begin(), mDirty.end());
+}
+
+void Bvh::refit()
+{
+    if (mPending.valid() && mPending.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        adopt(mPending.get());
+
+    // Max-heap on the node index : children are always refitted before their parents, and parents only when a child
+    // actually changed
+    while (!mDirty.empty())
+    {
+        std::pop_heap(mDirty.begin(), mDirty.end());
+        u32 const n = mDirty.back();
+        mDirty.pop_back();
+        mIsDirty[n] = 0;
+
+        auto &node = mTree.nodes[n];
+
+        math::AABB box;
+        if (node.isLeaf())
+        {
+            for (u32 i = node.first; i < node.first + node.count; ++i)
+                if (u32 const item = mTree.items[i]; alive(item))
+                    box.expand(mBoxes[item]);
+        }
+        else
+        {
+            box.expand(mTree.nodes[node.first].box);
+            box.expand(mTree.nodes[node.first + 1].box);
+        }
+
+        if (box.min == node.box.min && box.max == node.box.max)
+            continue;
+
+        mTree.cost -= nodeCost(node);
+        node.box = box;
+        mTree.cost += nodeCost(node);
+
+        if (node.parent != sNone)
+            markDirty(node.parent);
+    }
+
+    bool const emptyTree = mTree.nodes.empty() && !mLoose.empty();
+
+    if (!rebuilding() && (emptyTree || mLoose.size() > sMaxLoose || quality() > sRebuildRatio))
+        startRebuild();
+}
+
+//-----------------------------------------------------------------------------
+
+float Bvh::quality() const
+{
+    if (mTree.nodes.empty() || mBuildCost <= 0.f)
+        return mLoose.empty() ? 1.f : INF;
+
+    // Loose items are tested by every query, as if they were leaves as big as the root
+    float const rootArea = std::max(mTree.nodes[0].box.area(), EPSILON);
+    return (mTree.cost / rootArea + (float)mLoose.size()) / mBuildCost;
+}
+
+//-----------------------------------------------------------------------------
+
+void Bvh::startRebuild()
+{
+    mChangedSince.clear();
+    mPending = std::async(std::launch::async, [boxes = mBoxes, alive = mIsAlive]() { return buildTree(boxes, alive); });
+}
+
+void Bvh::adopt(Tree tree)
+{
+    mTree = std::move(tree);
+    mTree.leafOf.resize(mBoxes.size(), sNone);
+
+    float const rootArea = mTree.nodes.empty() ? 0.f : std::max(mTree.nodes[0].box.area(), EPSILON);
+    mBuildCost           = rootArea > 0.f ? mTree.cost / rootArea : 0.f;
+
+    mDirty.clear();
+    mIsDirty.assign(mTree.nodes.size(), 0);
+
+    // Inserted after the snapshot : loose again until the next rebuild
+    mLoose.clear();
+    for (u32 i = 0; i < (u32)mBoxes.size(); ++i)
+        if (mIsAlive[i] && mTree.leafOf[i] == sNone)
+            mLoose.push_back(i);
+
+    // Moved or removed after the snapshot : the new tree still has their old boxes
+    for (u32 const item : mChangedSince)
+        if (mTree.leafOf[item] != sNone)
+            markDirty(mTree.leafOf[item]);
+
+    mChangedSince.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm
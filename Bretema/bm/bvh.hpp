@@ -0,0 +1,277 @@
+#pragma once
+
+#include "base.hpp"
+#include "utils.hpp"
+
+#include <future>
+#include <vector>
+
+namespace bm
+{
+
+//=====================================
+// BVH
+//=====================================
+
+// Dynamic bounding volume hierarchy over the boxes of caller-indexed items (entity ids, object indices...).
+//  - Built top-down with binned SAH.
+//  - Moving an item refits its leaf and the ancestors on the next 'refit', touching nothing else.
+//  - Inserted items wait in a small 'loose' list that queries scan linearly.
+//  - Once refits and loose items make the tree noticeably worse than when built, a new one is built on a worker
+//    thread from a snapshot and swapped in when ready, replaying what changed meanwhile.
+class Bvh
+{
+public:
+    static constexpr u32   sNone         = ~0u;
+    static constexpr u32   sBins         = 16;    // SAH candidates per axis
+    static constexpr u32   sMaxLeafItems = 4;     // Leaves are split while it pays off, and always above this
+    static constexpr float sRebuildRatio = 1.5f;  // Quality that triggers a background rebuild
+    static constexpr u32   sMaxLoose     = 64;    // Loose items that trigger a rebuild on their own
+
+    struct Node
+    {
+        math::AABB box    = {};
+        u32        first  = 0;  // Leaf : first entry in 'items' | Inner : left child, the right one is 'first + 1'
+        u32        count  = 0;  // Leaf : item count | Inner : 0
+        u32        parent = sNone;
+
+        inline bool isLeaf() const { return count > 0; }
+    };
+
+    Bvh() = default;
+    ~Bvh();
+
+    Bvh(Bvh const &)            = delete;
+    Bvh &operator=(Bvh const &) = delete;
+
+    // Synchronous build over items [0, boxes.size()), empty boxes are left out
+    void build(std::vector<math::AABB> const &boxes);
+    void clear();
+
+    void insert(u32 item, math::AABB const &box);
+    void update(u32 item, math::AABB const &box);
+    void remove(u32 item);
+
+    // Applies pending updates, swaps in a finished rebuild and starts a new one when quality degraded.
+    // Call it once per frame before querying
+    void refit();
+
+    // SAH cost now over the cost right after building, 1 : as good as it gets
+    float quality() const;
+
+    inline u32               size() const { return mAlive; }
+    inline bool              empty() const { return mAlive == 0; }
+    inline bool              rebuilding() const { return mPending.valid(); }
+    inline math::AABB const &box(u32 item) const { return mBoxes[item]; }
+    inline math::AABB        bounds() const { return mTree.nodes.empty() ? math::AABB {} : mTree.nodes[0].box; }
+
+    //-----
+
+    // 'fn(item)' for every item that is at least partially inside
+    template<typename F>
+    void queryFrustum(math::Frustum const &frustum, F &&fn) const;
+
+    // 'fn(item)' for every item whose box overlaps 'box'
+    template<typename F>
+    void queryOverlap(math::AABB const &box, F &&fn) const;
+
+    // Nearest boxes first, 'fn(item, tBox, tMax)' returns the new 'tMax' (closest exact hit so far) to prune the rest
+    template<typename F>
+    float queryRay(math::Ray const &ray, float tMax, F &&fn) const;
+
+private:
+    struct Tree
+    {
+        std::vector<Node> nodes  = {};
+        std::vector<u32>  items  = {};  // Leaf ranges point here
+        std::vector<u32>  leafOf = {};  // Per item id, sNone when not in the tree
+        float             cost   = 0.f;  // Unnormalized SAH : sum of node areas weighted by traversal / item cost
+    };
+
+    static Tree  buildTree(std::vector<math::AABB> const &boxes, std::vector<u8> const &alive);
+    static float nodeCost(Node const &node);
+
+    void markDirty(u32 node);
+    void startRebuild();
+    void adopt(Tree tree);  // Swaps 'tree' in and replays what changed since its snapshot
+
+    inline bool alive(u32 item) const { return item < mIsAlive.size() && mIsAlive[item]; }
+
+    template<typename Visit, typename Leaf>
+    void traverse(Visit &&visit, Leaf &&leaf) const;
+
+    Tree                    mTree      = {};
+    float                   mBuildCost = 0.f;  // Normalized cost right after the current tree was built
+    std::vector<math::AABB> mBoxes     = {};   // Per item id
+    std::vector<u8>         mIsAlive   = {};
+    u32                     mAlive     = 0;
+    std::vector<u32>        mLoose     = {};  // Alive items the tree doesn't know about yet
+    std::vector<u32>        mDirty     = {};  // Nodes to refit, children always have higher indices than parents
+    std::vector<u8>         mIsDirty   = {};
+
+    std::future<Tree> mPending      = {};  // Background rebuild
+    std::vector<u32>  mChangedSince = {};  // Items touched after the rebuild snapshot was taken
+};
+
+//-----------------------------------------------------------------------------
+
+// 'visit(node) -> bool' decides whether to descend, 'leaf(node)' handles reached leaves
+template<typename Visit, typename Leaf>
+void Bvh::traverse(Visit &&visit, Leaf &&leaf) const
+{
+    if (mTree.nodes.empty())
+        return;
+
+    u32 stack[64];
+    u32 top      = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+        auto const &node = mTree.nodes[stack[--top]];
+
+        if (!visit(node))
+            continue;
+
+        if (node.isLeaf())
+        {
+            leaf(node);
+            continue;
+        }
+
+        BM_ASSERT(top + 2 <= 64);
+        stack[top++] = node.first + 1;
+        stack[top++] = node.first;
+    }
+}
+
+template<typename F>
+void Bvh::queryFrustum(math::Frustum const &frustum, F &&fn) const
+{
+    // Subtrees fully inside are emitted without testing anything else
+    auto const emitAll = [&](Node const &root)
+    {
+        u32 stack[64];
+        u32 top      = 0;
+        stack[top++] = (u32)(&root - mTree.nodes.data());
+
+        while (top > 0)
+        {
+            auto const &node = mTree.nodes[stack[--top]];
+
+            if (!node.isLeaf())
+            {
+                stack[top++] = node.first + 1;
+                stack[top++] = node.first;
+                continue;
+            }
+
+            for (u32 i = node.first; i < node.first + node.count; ++i)
+                if (u32 const item = mTree.items[i]; alive(item))
+                    fn(item);
+        }
+    };
+
+    traverse(
+      [&](Node const &node)
+      {
+          auto const test = frustum.test(node.box);
+
+          if (test == math::Frustum::Inside)
+          {
+              emitAll(node);
+              return false;
+          }
+
+          return test == math::Frustum::Intersects;
+      },
+      [&](Node const &node)
+      {
+          for (u32 i = node.first; i < node.first + node.count; ++i)
+              if (u32 const item = mTree.items[i]; alive(item) && frustum.test(mBoxes[item]) != math::Frustum::Outside)
+                  fn(item);
+      });
+
+    for (u32 const item : mLoose)
+        if (frustum.test(mBoxes[item]) != math::Frustum::Outside)
+            fn(item);
+}
+
+template<typename F>
+void Bvh::queryOverlap(math::AABB const &box, F &&fn) const
+{
+    traverse(
+      [&](Node const &node) { return node.box.overlaps(box); },
+      [&](Node const &node)
+      {
+          for (u32 i = node.first; i < node.first + node.count; ++i)
+              if (u32 const item = mTree.items[i]; alive(item) && mBoxes[item].overlaps(box))
+                  fn(item);
+      });
+
+    for (u32 const item : mLoose)
+        if (mBoxes[item].overlaps(box))
+            fn(item);
+}
+
+template<typename F>
+float Bvh::queryRay(math::Ray const &ray, float tMax, F &&fn) const
+{
+    // Loose items first, a close hit among them prunes the tree
+    for (u32 const item : mLoose)
+        if (float const t = ray.hit(mBoxes[item], tMax); t < INF)
+            tMax = std::min(tMax, fn(item, t, tMax));
+
+    if (mTree.nodes.empty() || ray.hit(mTree.nodes[0].box, tMax) == INF)
+        return tMax;
+
+    // Front-to-back : the nearer child is visited first, entries are re-checked against the shrinking 'tMax'
+    struct Entry
+    {
+        u32   node;
+        float t;
+    };
+
+    Entry stack[64];
+    u32   top    = 0;
+    stack[top++] = { 0, 0.f };
+
+    while (top > 0)
+    {
+        auto const [idx, tEntry] = stack[--top];
+
+        if (tEntry > tMax)
+            continue;
+
+        auto const &node = mTree.nodes[idx];
+
+        if (node.isLeaf())
+        {
+            for (u32 i = node.first; i < node.first + node.count; ++i)
+                if (u32 const item = mTree.items[i]; alive(item))
+                    if (float const t = ray.hit(mBoxes[item], tMax); t < INF)
+                        tMax = std::min(tMax, fn(item, t, tMax));
+            continue;
+        }
+
+        float tL = ray.hit(mTree.nodes[node.first].box, tMax);
+        float tR = ray.hit(mTree.nodes[node.first + 1].box, tMax);
+        u32   nL = node.first, nR = node.first + 1;
+
+        if (tR < tL)
+        {
+            std::swap(tL, tR);
+            std::swap(nL, nR);
+        }
+
+        BM_ASSERT(top + 2 <= 64);
+        if (tR < INF)
+            stack[top++] = { nR, tR };
+        if (tL < INF)
+            stack[top++] = { nL, tL };
+    }
+
+    return tMax;
+}
+
+}  // namespace bm
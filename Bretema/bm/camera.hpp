@@ -17,6 +17,7 @@ class Camera
     static glm::vec3 constexpr sInitEye      = { 2.f, 4.f, 8.f };
     static float constexpr sInitZ            = sInitEye.z;
     static float constexpr sMouseSensitivity = 0.1f;
+    static float constexpr sInitFov          = 75.f;
 
 public:
     enum struct Mode
@@ -26,10 +27,11 @@ public:
         Ortho
     };
 
-    Camera(std::string name, glm::vec3 eye = sInitEye, glm::vec3 lookAt = ZERO3, Mode mode = Mode::Fly)
+    Camera(std::string name, glm::vec3 eye = sInitEye, glm::vec3 lookAt = ZERO3, Mode mode = Mode::Fly, float fov = sInitFov)
       : mName(name)
       , mEye(eye)
       , mLookAt(lookAt)
+      , mFOV(fov)
       , mMode(mode)
       , mOrthoOffset(mEye.z)
     {
@@ -133,11 +135,19 @@ public:
     glm::mat4 P() const { return mP; }
     glm::mat4 VP() const { return mP * mV; }
 
+    // World space ray through 'cursor' (pixels, top-left origin) of a 'size' viewport
+    math::Ray ray(glm::vec2 const &cursor, glm::vec2 const &size) const { return math::unproject(cursor, size, VP()); }
+
     glm::vec3 front() { return mLookAt - mEye; }
     glm::vec3 right() { return Directions(front()).R; }
     glm::vec3 up() { return Directions(front()).U; }
 
-    float fov() { return mFOV; }
+    std::string const &name() const { return mName; }
+    glm::vec3          eye() const { return mEye; }
+    glm::vec3          lookAt() const { return mLookAt; }
+    Mode               mode() const { return mMode; }
+
+    float fov() const { return mFOV; }
     void  fov(float displ) { mFOV = glm::clamp((mFOV + displ * 0.5f), 4.f, 140.f); }
 
     float speed() { return mSpeed * mSpeedMod; }
@@ -189,7 +199,7 @@ private:
     std::string mName   = "";
     glm::vec3   mEye    = FRONT * sInitZ;
     glm::vec3   mLookAt = ZERO3;
-    float       mFOV    = 75.f;
+    float       mFOV    = sInitFov;
     float       mSpeed  = 0.01f;
     Mode        mMode   = Mode::Fly;
 
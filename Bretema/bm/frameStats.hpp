@@ -0,0 +1,110 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <chrono>
+
+namespace bm
+{
+
+//=====================================
+// FRAME STATS
+//=====================================
+
+// Rolling window of frame times with nanosecond resolution.
+// Pushing is O(1) and allocation-free, percentiles are only computed when somebody asks for them.
+class FrameStats
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr u32 sCapacity = 1024;  // Frames in the window
+
+    struct Summary
+    {
+        u32   count = 0;
+        float min   = 0.f;  // All in milliseconds
+        float avg   = 0.f;
+        float p50   = 0.f;
+        float p95   = 0.f;
+        float p99   = 0.f;
+        float max   = 0.f;
+
+        inline float fps() const { return avg > 0.f ? 1000.f / avg : 0.f; }
+    };
+
+    inline void push(u64 ns)
+    {
+        mTimes[mNext] = ns;
+        mNext         = (mNext + 1) % sCapacity;
+        mCount        = std::min(mCount + 1, sCapacity);
+    }
+
+    // Time since the previous 'tick', pushed as a frame (the first one only starts the clock)
+    inline void tick(Clock::time_point now = Clock::now())
+    {
+        if (mLastTick != Clock::time_point {})
+            push((u64)std::chrono::duration_cast<std::chrono::nanoseconds>(now - mLastTick).count());
+        mLastTick = now;
+    }
+
+    // Forget the running tick, e.g. after sleeping on purpose, so the pause isn't counted as a frame
+    inline void restart(Clock::time_point now = Clock::now()) { mLastTick = now; }
+
+    inline void clear() { *this = {}; }
+
+    inline u32 size() const { return mCount; }
+
+    Summary summary() const
+    {
+        Summary S = {};
+        S.count   = mCount;
+
+        if (mCount == 0)
+            return S;
+
+        auto sorted = std::vector<u64>(mTimes.begin(), mTimes.begin() + mCount);
+        std::sort(sorted.begin(), sorted.end());
+
+        auto const ms  = [](u64 ns) { return float(double(ns) * 1e-6); };
+        auto const pct = [&](float p) { return ms(sorted[std::min<size_t>(size_t(p * (mCount - 1) + 0.5f), mCount - 1)]); };
+
+        u64 total = 0;
+        for (auto const t : sorted) total += t;
+
+        S.min = ms(sorted.front());
+        S.max = ms(sorted.back());
+        S.avg = float(double(total) / mCount * 1e-6);
+        S.p50 = pct(0.50f);
+        S.p95 = pct(0.95f);
+        S.p99 = pct(0.99f);
+
+        return S;
+    }
+
+    // 'bins' buckets of equal width over [0, maxMs), the last one also gathers everything slower
+    std::vector<u32> histogram(u32 bins, float maxMs) const
+    {
+        std::vector<u32> H(bins, 0);
+
+        if (bins == 0 || maxMs <= 0.f)
+            return H;
+
+        for (u32 i = 0; i < mCount; ++i)
+        {
+            float const ms  = float(double(mTimes[i]) * 1e-6);
+            auto const  bin = std::min<u32>(u32(ms / maxMs * bins), bins - 1);
+            ++H[bin];
+        }
+
+        return H;
+    }
+
+private:
+    std::array<u64, sCapacity> mTimes    = {};
+    u32                        mNext     = 0;
+    u32                        mCount    = 0;
+    Clock::time_point          mLastTick = {};
+};
+
+}  // namespace bm
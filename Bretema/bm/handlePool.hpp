@@ -0,0 +1,183 @@
+#pragma once
+
+#include "base.hpp"
+#include "strId.hpp"
+
+#include <sole.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bm::ds
+{
+
+//-----------------------------------------------------------------------------
+
+// Reference to an item of a 'HandlePool<T>' : slot index plus the generation the slot had when it was handed out.
+// Removing the item moves the slot's generation on, so a stale handle is told apart instead of aliasing a newer item
+template<typename T>
+struct Handle
+{
+    static constexpr u32 sNone = ~0u;
+
+    u32 index      = sNone;
+    u32 generation = 0;
+
+    inline explicit operator bool() const { return index != sNone; }
+    inline auto     operator<=>(Handle const &) const = default;
+};
+
+// Same key, same id on every run and machine : what code or files name by key keeps its id across sessions
+inline sole::uuid stableId(std::string_view key)
+{
+    // The 'StrId' hash of the key, twice from different offsets, makes the 128 bits
+    return sole::rebuild(StrId::hash(key), StrId::hash(key, 0x84222325cbf29ce4ull));
+}
+
+//-----------------------------------------------------------------------------
+
+// Dense array of T addressed by generational handles.
+//  - 'get' / 'operator[]' are an index plus a generation compare : nothing is hashed once the handle is known.
+//  - Removed slots are reused by later adds, the handles that pointed to them turn stale.
+//  - Every item has a uuid (persistence) and optionally a name, lookups by them are meant for load time.
+// Adds may move the items : keep handles across them, pointers only within a frame.
+template<typename T>
+class HandlePool
+{
+public:
+    using Handle = ds::Handle<T>;
+
+    Handle add(T item, sole::uuid const &id, std::string name = "")
+    {
+        BM_ASSERT_X(!find(id), "Duplicated id on a handle-pool");
+
+        u32 index = (u32)mItems.size();
+
+        if (mFree.empty())
+        {
+            mItems.push_back(std::move(item));
+            mSlots.emplace_back();
+        }
+        else
+        {
+            index = mFree.back();
+            mFree.pop_back();
+            mItems[index] = std::move(item);
+        }
+
+        auto &slot = mSlots[index];
+        slot.alive = true;
+        slot.id    = id;
+        slot.name  = std::move(name);
+
+        Handle const handle { index, slot.generation };
+
+        mById[id] = handle;
+        if (!slot.name.empty())
+            mByName[StrId(slot.name)] = handle;
+
+        ++mAlive;
+        return handle;
+    }
+
+    // False if 'handle' was already stale
+    bool remove(Handle handle)
+    {
+        if (!valid(handle))
+            return false;
+
+        auto &slot = mSlots[handle.index];
+
+        mById.erase(slot.id);
+        if (auto const it = mByName.find(StrId(slot.name)); it != mByName.end() && it->second == handle)
+            mByName.erase(it);
+
+        slot.alive = false;
+        ++slot.generation;
+        slot.name.clear();
+
+        mItems[handle.index] = T {};
+        mFree.push_back(handle.index);
+
+        --mAlive;
+        return true;
+    }
+
+    void clear()
+    {
+        for (u32 i = 0; i < mSlots.size(); ++i)
+            if (mSlots[i].alive)
+                remove({ i, mSlots[i].generation });
+    }
+
+    inline bool valid(Handle handle) const
+    {
+        return handle.index < mSlots.size() && mSlots[handle.index].alive && mSlots[handle.index].generation == handle.generation;
+    }
+
+    // Null when stale
+    inline T       *get(Handle handle) { return valid(handle) ? &mItems[handle.index] : nullptr; }
+    inline T const *get(Handle handle) const { return valid(handle) ? &mItems[handle.index] : nullptr; }
+
+    inline T &operator[](Handle handle)
+    {
+        BM_ASSERT(valid(handle));
+        return mItems[handle.index];
+    }
+
+    inline T const &operator[](Handle handle) const
+    {
+        BM_ASSERT(valid(handle));
+        return mItems[handle.index];
+    }
+
+    // Invalid handle when missing
+    inline Handle find(sole::uuid const &id) const
+    {
+        auto const it = mById.find(id);
+        return it != mById.end() ? it->second : Handle {};
+    }
+
+    inline Handle find(StrId name) const
+    {
+        auto const it = mByName.find(name);
+        return it != mByName.end() ? it->second : Handle {};
+    }
+
+    inline sole::uuid const  &id(Handle handle) const { return mSlots[handle.index].id; }
+    inline std::string const &name(Handle handle) const { return mSlots[handle.index].name; }
+
+    inline u32 size() const { return mAlive; }
+    inline u32 capacity() const { return (u32)mSlots.size(); }  // Upper bound of the indices handed out
+
+    // 'fn(handle, item)' for every live item
+    template<typename F>
+    void each(F &&fn)
+    {
+        for (u32 i = 0; i < mSlots.size(); ++i)
+            if (mSlots[i].alive)
+                fn(Handle { i, mSlots[i].generation }, mItems[i]);
+    }
+
+private:
+    struct Slot
+    {
+        u32         generation = 0;
+        bool        alive      = false;
+        sole::uuid  id         = {};
+        std::string name       = "";
+    };
+
+    std::vector<T>    mItems = {};
+    std::vector<Slot> mSlots = {};
+    std::vector<u32>  mFree  = {};
+    u32               mAlive = 0;
+
+    std::unordered_map<sole::uuid, Handle> mById   = {};
+    std::unordered_map<StrId, Handle>      mByName = {};
+};
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::ds
@@ -0,0 +1,53 @@
+#include "meshBvh.hpp"
+
+namespace bm
+{
+
+//-----------------------------------------------------------------------------
+
+MeshBvh::MeshBvh(std::vector<glm::vec3> positions, std::vector<u32> indices)
+  : mPositions(std::move(positions))
+  , mIndices(std::move(indices))
+{
+    mIndices.resize(mIndices.size() - mIndices.size() % 3);
+
+    std::vector<math::AABB> boxes(triangles());
+
+    for (u32 tri = 0; tri < triangles(); ++tri)
+    {
+        for (u32 corner = 0; corner < 3; ++corner)
+        {
+            BM_ASSERT(mIndices[tri * 3 + corner] < mPositions.size());
+            boxes[tri].expand(vertex(tri, corner));
+        }
+    }
+
+    mBvh.build(boxes);
+}
+
+//-----------------------------------------------------------------------------
+
+MeshBvh::Hit MeshBvh::raycast(math::Ray const &ray, float tMax) const
+{
+    Hit hit;
+
+    mBvh.queryRay(
+      ray,
+      tMax,
+      [&](u32 tri, float, float tLimit)
+      {
+          glm::vec2   bary;
+          float const t = ray.hit(vertex(tri, 0), vertex(tri, 1), vertex(tri, 2), tLimit, &bary);
+
+          if (t < hit.t)
+              hit = { t, tri, bary };
+
+          return std::min(tLimit, hit.t);
+      });
+
+    return hit;
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "base.hpp"
+#include "bvh.hpp"
+#include "utils.hpp"
+
+#include <vector>
+
+namespace bm
+{
+
+//=====================================
+// MESH BVH
+//=====================================
+
+// CPU copy of a mesh's triangles under a static BVH, for exact ray casts (picking) in object space
+class MeshBvh
+{
+public:
+    static constexpr u32 sNone = Bvh::sNone;
+
+    struct Hit
+    {
+        float     t        = INF;
+        u32       triangle = sNone;  // First index of the triangle is '3 * triangle'
+        glm::vec2 bary     = ZERO2;  // Weights of the 2nd and 3rd vertices
+
+        inline explicit operator bool() const { return triangle != sNone; }
+    };
+
+    MeshBvh(std::vector<glm::vec3> positions, std::vector<u32> indices);
+
+    MeshBvh(MeshBvh const &)            = delete;
+    MeshBvh &operator=(MeshBvh const &) = delete;
+
+    // Closest triangle along 'ray' within [0, tMax]
+    Hit raycast(math::Ray const &ray, float tMax = INF) const;
+
+    inline u32                           triangles() const { return (u32)mIndices.size() / 3; }
+    inline std::vector<glm::vec3> const &positions() const { return mPositions; }
+    inline std::vector<u32> const       &indices() const { return mIndices; }
+    inline math::AABB                    bounds() const { return mBvh.bounds(); }
+    inline glm::vec3 const              &vertex(u32 triangle, u32 corner) const { return mPositions[mIndices[triangle * 3 + corner]]; }
+
+private:
+    std::vector<glm::vec3> mPositions = {};
+    std::vector<u32>       mIndices   = {};
+    Bvh                    mBvh       = {};  // Items are triangles
+};
+
+}  // namespace bm
@@ -0,0 +1,263 @@
+#include "occlusion.hpp"
+
+#include "profiler.hpp"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#    include <xmmintrin.h>
+#    define BM_OCCLUSION_SSE 1
+#else
+#    define BM_OCCLUSION_SSE 0
+#endif
+
+namespace bm
+{
+
+//-----------------------------------------------------------------------------
+
+OcclusionBuffer::OcclusionBuffer(u32 width, u32 height)
+{
+    resize(width, height);
+}
+
+void OcclusionBuffer::resize(u32 width, u32 height)
+{
+    mWidth  = std::max(width, 1u);
+    mHeight = std::max(height, 1u);
+    mPitch  = (mWidth + 3) & ~3u;
+    mTilesX = (mWidth + sTile - 1) / sTile;
+    mTilesY = (mHeight + sTile - 1) / sTile;
+
+    mDepth.assign(mPitch * mHeight, 1.f);
+    mTileMax.assign(mTilesX * mTilesY, 1.f);
+    mTris.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+void OcclusionBuffer::begin(glm::mat4 const &viewproj)
+{
+    mViewProj = viewproj;
+
+    std::fill(mDepth.begin(), mDepth.end(), 1.f);
+    std::fill(mTileMax.begin(), mTileMax.end(), 1.f);
+    mTris.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+void OcclusionBuffer::add(glm::mat4 const &world, std::vector<glm::vec3> const &positions, std::vector<u32> const &indices)
+{
+    glm::mat4 const mvp = mViewProj * world;
+    float const     W   = (float)mWidth;
+    float const     H   = (float)mHeight;
+
+    // Vertices are shared by several triangles : project each one once, 'w' flags the ones behind the near plane
+    mProjected.resize(positions.size());
+
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        glm::vec4 const clip = mvp * glm::vec4(positions[i], 1.f);
+
+        if (clip.w <= EPSILON || clip.z < 0.f)
+        {
+            mProjected[i].w = 0.f;
+            continue;
+        }
+
+        glm::vec3 const ndc = glm::vec3(clip) / clip.w;
+        mProjected[i]       = { (ndc.x * 0.5f + 0.5f) * W, (ndc.y * 0.5f + 0.5f) * H, ndc.z, 1.f };
+    }
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        glm::vec4 v0 = mProjected[indices[i]], v1 = mProjected[indices[i + 1]], v2 = mProjected[indices[i + 2]];
+
+        if (v0.w == 0.f || v1.w == 0.f || v2.w == 0.f)
+            continue;
+
+        // Both faces occlude, flip the clockwise ones so 'inside' is always every edge >= 0
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+
+        if (std::abs(area) < EPSILON)
+            continue;
+
+        if (area < 0.f)
+        {
+            std::swap(v1, v2);
+            area = -area;
+        }
+
+        // Pixels whose center falls in the bounding box
+        float const minX = std::max(std::ceil(std::min({ v0.x, v1.x, v2.x }) - 0.5f), 0.f);
+        float const minY = std::max(std::ceil(std::min({ v0.y, v1.y, v2.y }) - 0.5f), 0.f);
+        float const maxX = std::min(std::floor(std::max({ v0.x, v1.x, v2.x }) - 0.5f), W - 1.f);
+        float const maxY = std::min(std::floor(std::max({ v0.y, v1.y, v2.y }) - 0.5f), H - 1.f);
+
+        if (minX > maxX || minY > maxY)
+            continue;
+
+        // Edge 'ab' is positive on the side of the opposite vertex, its value there is 'area'
+        auto const edge = [](glm::vec4 const &a, glm::vec4 const &b) { return glm::vec3(a.y - b.y, b.x - a.x, a.x * b.y - a.y * b.x); };
+
+        glm::vec3 const e12 = edge(v1, v2), e20 = edge(v2, v0), e01 = edge(v0, v1);
+
+        Tri tri;
+        tri.a    = { e12.x, e20.x, e01.x };
+        tri.b    = { e12.y, e20.y, e01.y };
+        tri.c    = { e12.z, e20.z, e01.z };
+        tri.z    = (e12 * v0.z + e20 * v1.z + e01 * v2.z) / area;  // Barycentric weights are edges over area
+        tri.minX = (i32)minX, tri.minY = (i32)minY, tri.maxX = (i32)maxX, tri.maxY = (i32)maxY;
+
+        mTris.push_back(tri);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void OcclusionBuffer::render()
+{
+    BM_PROFILE_ZONE("OcclusionRender");
+
+    // One thread : at this resolution the whole raster is cheaper than waking workers up for it
+    for (auto const &tri : mTris)
+    {
+        i32 const y0 = tri.minY;  // Already clamped to the buffer by 'add'
+        i32 const y1 = tri.maxY;
+        i32 const x0 = tri.minX & ~3;  // Rows are stored 4 pixels at a time, from a multiple of 4
+        i32 const x1 = tri.maxX;
+
+        for (i32 y = y0; y <= y1; ++y)
+        {
+            float const     yc   = (float)y + 0.5f;
+            glm::vec3 const eRow = tri.b * yc + tri.c;
+            float const     zRow = tri.z.y * yc + tri.z.z;
+            float *const    row  = &mDepth[y * mPitch];
+
+#if BM_OCCLUSION_SSE
+            auto const zero = _mm_setzero_ps();
+            auto const half = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+            for (i32 x = x0; x <= x1; x += 4)
+            {
+                auto const xs = _mm_add_ps(_mm_set1_ps((float)x), half);
+                auto const e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.a.x), xs), _mm_set1_ps(eRow.x));
+                auto const e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.a.y), xs), _mm_set1_ps(eRow.y));
+                auto const e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.a.z), xs), _mm_set1_ps(eRow.z));
+
+                auto const inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                if (_mm_movemask_ps(inside) == 0)
+                    continue;
+
+                auto const z   = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.z.x), xs), _mm_set1_ps(zRow));
+                auto const cur = _mm_loadu_ps(row + x);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, _mm_min_ps(cur, z)), _mm_andnot_ps(inside, cur)));
+            }
+#else
+            for (i32 x = x0; x <= x1; ++x)
+            {
+                float const     xc = (float)x + 0.5f;
+                glm::vec3 const e  = tri.a * xc + eRow;
+
+                if (e.x >= 0.f && e.y >= 0.f && e.z >= 0.f)
+                    row[x] = std::min(row[x], tri.z.x * xc + zRow);
+            }
+#endif
+        }
+    }
+
+    //--- Farthest depth per tile
+
+    for (u32 ty = 0; ty < mTilesY; ++ty)
+    {
+        for (u32 tx = 0; tx < mTilesX; ++tx)
+        {
+            float farthest = 0.f;
+
+            for (u32 y = ty * sTile; y < std::min((ty + 1) * sTile, mHeight); ++y)
+                for (u32 x = tx * sTile; x < std::min((tx + 1) * sTile, mWidth); ++x) farthest = std::max(farthest, depth(x, y));
+
+            mTileMax[ty * mTilesX + tx] = farthest;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool OcclusionBuffer::project(math::AABB const &box, Rect &rect) const
+{
+    if (box.empty())
+        return false;
+
+    float const W = (float)mWidth;
+    float const H = (float)mHeight;
+
+    glm::vec2 lo   = INF2;
+    glm::vec2 hi   = -INF2;
+    float     minZ = INF;
+
+    for (u32 i = 0; i < 8; ++i)
+    {
+        glm::vec3 const corner = { i & 1 ? box.max.x : box.min.x, i & 2 ? box.max.y : box.min.y, i & 4 ? box.max.z : box.min.z };
+        glm::vec4 const clip   = mViewProj * glm::vec4(corner, 1.f);
+
+        if (clip.w <= EPSILON || clip.z < 0.f)
+            return false;
+
+        glm::vec3 const ndc = glm::vec3(clip) / clip.w;
+        glm::vec2 const px  = { (ndc.x * 0.5f + 0.5f) * W, (ndc.y * 0.5f + 0.5f) * H };
+
+        lo   = glm::min(lo, px);
+        hi   = glm::max(hi, px);
+        minZ = std::min(minZ, ndc.z);
+    }
+
+    // Every pixel the rect touches
+    rect.minX = (i32)std::clamp(std::floor(lo.x), 0.f, W - 1.f);
+    rect.minY = (i32)std::clamp(std::floor(lo.y), 0.f, H - 1.f);
+    rect.maxX = (i32)std::clamp(std::floor(hi.x), 0.f, W - 1.f);
+    rect.maxY = (i32)std::clamp(std::floor(hi.y), 0.f, H - 1.f);
+    rect.minZ = minZ;
+
+    return hi.x >= 0.f && hi.y >= 0.f && lo.x < W && lo.y < H;
+}
+
+//-----------------------------------------------------------------------------
+
+bool OcclusionBuffer::visible(math::AABB const &box) const
+{
+    Rect r;
+    if (!project(box, r))
+        return true;
+
+    // Tiles whose farthest depth is nearer than the box hide their part of it, only the others need their pixels
+    for (i32 ty = r.minY / (i32)sTile; ty <= r.maxY / (i32)sTile; ++ty)
+    {
+        for (i32 tx = r.minX / (i32)sTile; tx <= r.maxX / (i32)sTile; ++tx)
+        {
+            if (mTileMax[ty * mTilesX + tx] < r.minZ)
+                continue;
+
+            i32 const x0 = std::max(r.minX, tx * (i32)sTile), x1 = std::min(r.maxX, (tx + 1) * (i32)sTile - 1);
+            i32 const y0 = std::max(r.minY, ty * (i32)sTile), y1 = std::min(r.maxY, (ty + 1) * (i32)sTile - 1);
+
+            for (i32 y = y0; y <= y1; ++y)
+                for (i32 x = x0; x <= x1; ++x)
+                    if (depth(x, y) >= r.minZ)
+                        return true;
+        }
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+
+float OcclusionBuffer::screenArea(math::AABB const &box) const
+{
+    Rect r;
+    return project(box, r) ? float(r.maxX - r.minX + 1) * float(r.maxY - r.minY + 1) : 0.f;
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm
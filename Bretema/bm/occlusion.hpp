@@ -0,0 +1,81 @@
+#pragma once
+
+#include "base.hpp"
+#include "utils.hpp"
+
+#include <vector>
+
+namespace bm
+{
+
+//=====================================
+// OCCLUSION BUFFER
+//=====================================
+
+// Low resolution depth buffer for CPU occlusion culling, same [0, 1] depth as the GPU.
+//  - 'begin' clears it and takes the camera, 'add' queues occluder triangles (transformed and set up right away).
+//  - 'render' rasterizes the queue 4 pixels at a time (SSE when available) on the calling thread, then keeps the
+//    farthest depth of every 'sTile' x 'sTile' tile : a single level of tile max-depth, not a full mip chain.
+//  - 'visible' tests a box against the tile max-depths first and only looks at pixels of tiles that can't decide.
+// Triangles crossing the near plane are dropped and so are boxes crossing it reported visible : it only ever errs on
+// the side of drawing.
+class OcclusionBuffer
+{
+public:
+    static constexpr u32 sTile = 8;  // Pixels per side of a max-depth tile
+
+    explicit OcclusionBuffer(u32 width = 256, u32 height = 128);
+
+    OcclusionBuffer(OcclusionBuffer const &)            = delete;
+    OcclusionBuffer &operator=(OcclusionBuffer const &) = delete;
+
+    void resize(u32 width, u32 height);
+
+    void begin(glm::mat4 const &viewproj);
+    void add(glm::mat4 const &world, std::vector<glm::vec3> const &positions, std::vector<u32> const &indices);
+    void render();
+
+    // False only when 'box' (world space) is certainly behind what was rendered
+    bool visible(math::AABB const &box) const;
+
+    // Pixels covered by the screen rect of 'box', 0 when it crosses the near plane
+    float screenArea(math::AABB const &box) const;
+
+    inline u32   width() const { return mWidth; }
+    inline u32   height() const { return mHeight; }
+    inline u32   triangles() const { return (u32)mTris.size(); }
+    inline float depth(u32 x, u32 y) const { return mDepth[y * mPitch + x]; }
+
+private:
+    // Edge functions and depth plane in pixel space, all three edges are >= 0 inside
+    struct Tri
+    {
+        glm::vec3 a    = {};  // Per edge : e(x, y) = a * x + b * y + c
+        glm::vec3 b    = {};
+        glm::vec3 c    = {};
+        glm::vec3 z    = {};  // z(x, y) = z.x * x + z.y * y + z.z
+        i32       minX = 0, minY = 0, maxX = 0, maxY = 0;
+    };
+
+    struct Rect
+    {
+        i32   minX = 0, minY = 0, maxX = 0, maxY = 0;  // Pixels, inclusive
+        float minZ = 0.f;
+    };
+
+    bool project(math::AABB const &box, Rect &rect) const;
+
+    u32                mWidth    = 0;
+    u32                mHeight   = 0;
+    u32                mPitch    = 0;  // Floats per row, multiple of 4 so rows can be stored 4 pixels at a time
+    u32                mTilesX   = 0;
+    u32                mTilesY   = 0;
+    glm::mat4          mViewProj = glm::mat4 { 1.f };
+    std::vector<float> mDepth    = {};
+    std::vector<float> mTileMax  = {};  // Farthest depth of each tile
+    std::vector<Tri>   mTris     = {};
+
+    std::vector<glm::vec4> mProjected = {};  // Scratch of 'add'
+};
+
+}  // namespace bm
@@ -0,0 +1,183 @@
+#include "profiler.hpp"
+
+#include <json.hpp>
+
+#include <fstream>
+
+namespace bm::prof
+{
+
+//-----------------------------------------------------------------------------
+
+Profiler &Profiler::get()
+{
+    static Profiler sProfiler;
+    return sProfiler;
+}
+
+//-----------------------------------------------------------------------------
+
+ThreadRing &Profiler::local()
+{
+    // The ring is owned by the profiler, so events of finished threads can still be exported
+    thread_local ThreadRing *tRing = nullptr;
+
+    if (!tRing)
+    {
+        std::scoped_lock lock { mMutex };
+
+        auto thread  = uNew<Thread>();
+        thread->tid  = (u32)mThreads.size();
+        thread->name = BM_FMT("Thread {}", thread->tid);
+        thread->ring = uNew<ThreadRing>();
+        tRing        = thread->ring.get();
+
+        mThreads.push_back(std::move(thread));
+    }
+
+    return *tRing;
+}
+
+void Profiler::threadName(std::string name)
+{
+    auto const *ring = &local();
+
+    std::scoped_lock lock { mMutex };
+
+    for (auto &T : mThreads)
+        if (T->ring.get() == ring)
+            T->name = std::move(name);
+}
+
+//-----------------------------------------------------------------------------
+
+void Profiler::frame(u64 index)
+{
+    std::scoped_lock lock { mMutex };
+
+    mFrames.push_back({ index, now() });
+    collect();
+
+    // Forget what's older than the oldest frame we keep
+    while (mFrames.size() > sMaxFrames) mFrames.pop_front();
+
+    u64 const oldest = mFrames.front().ns;
+    for (auto &T : mThreads)
+        while (!T->history.empty() && T->history.front().ns < oldest) T->history.pop_front();
+}
+
+void Profiler::collect()
+{
+    for (auto &T : mThreads) T->ring->drain([&](Event const &e) { T->history.push_back(e); });
+}
+
+//-----------------------------------------------------------------------------
+
+bool Profiler::dump(std::string const &path, u64 first, u64 last)
+{
+    using json = nlohmann::json;
+
+    std::scoped_lock lock { mMutex };
+
+    collect();
+
+    // Time window of the requested frames
+    u64 from = ~0ull, to = now();
+    for (size_t i = 0; i < mFrames.size(); ++i)
+    {
+        auto const &F = mFrames[i];
+        if (F.index >= first && from == ~0ull)
+            from = F.ns;
+        if (F.index > last)
+        {
+            to = F.ns;
+            break;
+        }
+    }
+
+    if (from == ~0ull)
+    {
+        BM_WARNF("Profiler : frames [{}, {}] are not in the history", first, last);
+        return false;
+    }
+
+    json events = json::array();
+
+    for (auto const &T : mThreads)
+    {
+        events.push_back({ { "name", "thread_name" }, { "ph", "M" }, { "pid", 0 }, { "tid", T->tid }, { "args", { { "name", T->name } } } });
+
+        // Pair begin/end into complete events, zones open on the window edges are left out
+        std::vector<Event const *> open;
+
+        for (auto const &e : T->history)
+        {
+            if (e.kind == Event::Begin)
+            {
+                open.push_back(&e);
+                continue;
+            }
+
+            if (open.empty())
+                continue;
+
+            auto const *b = open.back();
+            open.pop_back();
+
+            if (b->ns < from || e.ns > to)
+                continue;
+
+            auto const &loc = b->zone->loc;
+            events.push_back({
+              { "name", b->zone->name },
+              { "cat", "cpu" },
+              { "ph", "X" },
+              { "pid", 0 },
+              { "tid", T->tid },
+              { "ts", double(b->ns) * 1e-3 },  // Microseconds
+              { "dur", double(e.ns - b->ns) * 1e-3 },
+              { "args", { { "file", loc.file_name() }, { "line", loc.line() }, { "function", loc.function_name() } } },
+            });
+        }
+
+        if (auto const dropped = T->ring->dropped(); dropped > 0)
+            BM_WARNF("Profiler : '{}' dropped {} events, its ring is too small", T->name, dropped);
+    }
+
+    for (auto const &F : mFrames)
+    {
+        if (F.ns < from || F.ns > to)
+            continue;
+
+        events.push_back(
+          { { "name", BM_FMT("Frame {}", F.index) }, { "ph", "i" }, { "s", "g" }, { "pid", 0 }, { "tid", 0 }, { "ts", double(F.ns) * 1e-3 } });
+    }
+
+    auto file = std::ofstream { path };
+    if (!file.is_open())
+    {
+        BM_ERRF("Profiler : couldn't open {}", path);
+        return false;
+    }
+
+    file << json { { "traceEvents", std::move(events) }, { "displayTimeUnit", "ms" } }.dump();
+
+    BM_INFOF("Profiler : trace written to {}", path);
+    return true;
+}
+
+bool Profiler::dumpLast(std::string const &path, u64 count)
+{
+    u64 first = 0;
+    {
+        std::scoped_lock lock { mMutex };
+        if (!mFrames.empty())
+            first = mFrames[mFrames.size() - std::min<u64>(count, mFrames.size())].index;
+    }
+
+    return dump(path, first);
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::prof
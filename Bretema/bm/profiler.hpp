@@ -0,0 +1,175 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <source_location>
+
+//=====================================
+// CPU ZONE PROFILER
+//=====================================
+// Scoped zones are recorded as begin/end events into a lock-free ring owned by the calling thread.
+// The main thread drains every ring once per frame ('BM_PROFILE_FRAME') into a bounded history,
+// and any range of recent frames can be exported as Chrome trace-event JSON (chrome://tracing, Perfetto).
+// Built with 'OPT_PROFILER' (BM_PROFILER=1), otherwise the macros compile to nothing.
+
+#ifndef BM_PROFILER
+#    define BM_PROFILER 0
+#endif
+
+namespace bm::prof
+{
+
+//-----------------------------------------------------------------------------
+
+// Static per call-site : events only carry a pointer to it
+struct Zone
+{
+    char const          *name = "";
+    std::source_location loc  = {};
+};
+
+struct Event
+{
+    enum Kind : u32
+    {
+        Begin,
+        End,
+    };
+
+    u64         ns   = 0;  // Since the profiler epoch
+    Zone const *zone = nullptr;
+    Kind        kind = Begin;
+};
+
+//-----------------------------------------------------------------------------
+
+// Single-producer (its thread) / single-consumer (the frame collector) ring, drops events when full
+class ThreadRing
+{
+public:
+    static constexpr u64 sCapacity = 1u << 15;  // Power of two
+
+    inline void push(Event const &e)
+    {
+        u64 const head = mHead.load(std::memory_order_relaxed);
+        if (head - mTail.load(std::memory_order_acquire) >= sCapacity)
+        {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        mEvents[head & (sCapacity - 1)] = e;
+        mHead.store(head + 1, std::memory_order_release);
+    }
+
+    template<typename F>
+    void drain(F &&fn)
+    {
+        u64       tail = mTail.load(std::memory_order_relaxed);
+        u64 const head = mHead.load(std::memory_order_acquire);
+
+        for (; tail < head; ++tail) fn(mEvents[tail & (sCapacity - 1)]);
+
+        mTail.store(tail, std::memory_order_release);
+    }
+
+    inline u64 dropped() const { return mDropped.load(std::memory_order_relaxed); }
+
+private:
+    alignas(64) std::atomic<u64> mHead    = 0;
+    alignas(64) std::atomic<u64> mTail    = 0;
+    std::atomic<u64>             mDropped = 0;
+    std::vector<Event>           mEvents  = std::vector<Event>(sCapacity);
+};
+
+//-----------------------------------------------------------------------------
+
+class Profiler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr u64 sMaxFrames = 600;  // History kept for export
+
+    static Profiler &get();
+
+    static inline u64 now() { return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - sEpoch).count(); }
+
+    // Calling thread's ring, registered on first use
+    ThreadRing &local();
+    void        threadName(std::string name);
+
+    // Marks the start of frame 'index', drains every thread and trims the history
+    void frame(u64 index);
+
+    // Frames [first, last] as Chrome trace-event JSON, 'last' beyond the newest frame means 'until now'
+    bool dump(std::string const &path, u64 first = 0, u64 last = ~0ull);
+    // The 'count' most recent frames
+    bool dumpLast(std::string const &path, u64 count = sMaxFrames);
+
+private:
+    struct Thread
+    {
+        u32               tid     = 0;
+        std::string       name    = "";
+        uPtr<ThreadRing>  ring    = nullptr;
+        std::deque<Event> history = {};
+    };
+
+    struct FrameMark
+    {
+        u64 index = 0;
+        u64 ns    = 0;
+    };
+
+    void collect();  // Requires 'mMutex'
+
+    std::mutex                mMutex   = {};
+    std::vector<uPtr<Thread>> mThreads = {};
+    std::deque<FrameMark>     mFrames  = {};
+
+    static inline Clock::time_point const sEpoch = Clock::now();
+};
+
+//-----------------------------------------------------------------------------
+
+class ScopedZone
+{
+public:
+    explicit ScopedZone(Zone const &zone) : mRing(Profiler::get().local()), mZone(&zone)
+    {
+        mRing.push({ Profiler::now(), mZone, Event::Begin });
+    }
+    ~ScopedZone() { mRing.push({ Profiler::now(), mZone, Event::End }); }
+
+    ScopedZone(ScopedZone const &)            = delete;
+    ScopedZone &operator=(ScopedZone const &) = delete;
+
+private:
+    ThreadRing &mRing;
+    Zone const *mZone;
+};
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::prof
+
+// clang-format off
+#if BM_PROFILER
+#    define BM_PROFILE_ZONE(name)                                                                                \
+        static constexpr bm::prof::Zone BM_CONCAT(bmZone_, __LINE__) { name, std::source_location::current() }; \
+        bm::prof::ScopedZone BM_CONCAT(bmScopedZone_, __LINE__) { BM_CONCAT(bmZone_, __LINE__) }
+#    define BM_PROFILE_FRAME(index)        bm::prof::Profiler::get().frame(index)
+#    define BM_PROFILE_THREAD(name)        bm::prof::Profiler::get().threadName(name)
+#    define BM_PROFILE_DUMP(path, frames)  bm::prof::Profiler::get().dumpLast(path, frames)
+#else
+#    define BM_PROFILE_ZONE(name)          (void)0
+#    define BM_PROFILE_FRAME(index)        (void)0
+#    define BM_PROFILE_THREAD(name)        (void)0
+#    define BM_PROFILE_DUMP(path, frames)  (void)0
+#endif
+// clang-format on
@@ -7,6 +7,10 @@
 #define TINYGLTF_NOEXCEPTION  // optional. disable exception handling.
 #include "tiny_gltf.h"
 
+#include <stb_image_write.h>
+
+#include <thread>
+
 namespace bm
 {
 
@@ -14,15 +18,158 @@ namespace bm
 // Base Renderer
 //=========================================================
 
-BaseRenderer::BaseRenderer(sPtr<bm::Window> window)
+BaseRenderer::BaseRenderer(sPtr<bm::Window> window, RendererSettings settings)
 {
-    mWindow = window;
-    syncWinSize();
+    mWindow   = window;
+    mSettings = settings;
+    syncWinSize(winSize());
 
-    BM_ASSERT_X(mWindow->handle(), "Invalid window handle");
+    BM_ASSERT_X(headless() || (mWindow && mWindow->handle()), "Invalid window handle");
     BM_ASSERT_X(w() > 0 && h() > 0, "Invalid viewport size");
 }
 
+void BaseRenderer::beginFrame()
+{
+    if (mSettings.maxFps == 0)
+    {
+        mFrameBegin = Clock::now();
+        return;
+    }
+
+    auto const period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / mSettings.maxFps));
+    auto const target = mFrameBegin + period;
+    auto const now    = Clock::now();
+
+    // Coarse sleep and spin the last stretch, OS timers are too coarse for high refresh rates
+    if (now < target)
+    {
+        std::this_thread::sleep_until(target - std::chrono::milliseconds(1));
+        while (Clock::now() < target) std::this_thread::yield();
+    }
+
+    // Keep the cadence when on time, restart it when we fell behind
+    mFrameBegin = std::max(now, target);
+}
+
+void BaseRenderer::markPresented()
+{
+    // Only count input this frame consumed, idle frames would inflate the number otherwise
+    if (mInputTime == Clock::time_point {} || mInputTime == mPresentedInputTime)
+        return;
+
+    mInputLatencyMs.store(std::chrono::duration<float, std::milli>(Clock::now() - mInputTime).count(), std::memory_order_relaxed);
+    mPresentedInputTime = mInputTime;
+}
+
+void BaseRenderer::requestRedraw()
+{
+    mRedrawRequested.store(true, std::memory_order_release);
+
+    if (mWindow)
+        bm::Window::wakeUp();  // The main thread may be sleeping on events
+}
+
+void BaseRenderer::publishPick(PickResult pick)
+{
+    std::lock_guard lock { mPickedMutex };
+    mPicked = std::move(pick);
+}
+
+void BaseRenderer::setNodeLocal(StrId scene, u32 node, glm::mat4 const &local)
+{
+    {
+        std::lock_guard lock { mNodeEditsMutex };
+        mNodeEdits.push_back({ scene, node, local });
+    }
+
+    requestRedraw();
+}
+
+void BaseRenderer::takeNodeEdits(std::vector<NodeEdit> &edits)
+{
+    edits.clear();
+
+    std::lock_guard lock { mNodeEditsMutex };
+    std::swap(edits, mNodeEdits);  // Both keep their capacity : no allocations once warmed up
+}
+
+void BaseRenderer::queueJob(std::function<void()> job)
+{
+    {
+        std::lock_guard lock { mJobsMutex };
+        mJobs.push_back(std::move(job));
+    }
+
+    requestRedraw();
+}
+
+void BaseRenderer::runJobs()
+{
+    std::vector<std::function<void()>> jobs;
+    {
+        std::lock_guard lock { mJobsMutex };
+        std::swap(jobs, mJobs);
+    }
+
+    for (auto &job : jobs)
+        job();
+}
+
+bool BaseRenderer::capture(std::string const &pngPath)
+{
+    auto const pixels = readback();
+    auto const w      = (i32)this->w();
+    auto const h      = (i32)this->h();
+
+    if (pixels.size() < size_t(w) * h * 4)
+    {
+        BM_ERRF("Capture {} : nothing to read back", pngPath);
+        return false;
+    }
+
+    if (!stbi_write_png(pngPath.c_str(), w, h, 4, pixels.data(), w * 4))
+    {
+        BM_ERRF("Capture {} : couldn't write the file", pngPath);
+        return false;
+    }
+
+    return true;
+}
+
+bool BaseRenderer::saveScene(StrId name, std::string const &path, std::vector<Camera> const &cameras)
+{
+    SceneFile file;
+
+    if (!exportScene(name, file))
+        return false;
+
+    file.cameras = cameras;
+    return saveSceneFile(file, path);
+}
+
+bool BaseRenderer::loadScene(StrId name, std::string const &path, std::vector<Camera> *cameras)
+{
+    auto const begin = Clock::now();
+
+    SceneFile file;
+
+    if (!loadSceneFile(path, file))
+        return false;
+
+    auto const read = Clock::now();
+
+    if (!importScene(name, file))
+        return false;
+
+    auto const ms = [](auto from, auto to) { return std::chrono::duration<float, std::milli>(to - from).count(); };
+    BM_INFOF("Scene {} : {} objects, read in {:.2f} ms, instanced in {:.2f} ms", path, file.size(), ms(begin, read), ms(read, Clock::now()));
+
+    if (cameras && !file.cameras.empty())
+        *cameras = std::move(file.cameras);
+
+    return true;
+}
+
 //=========================================================
 // GLTF Loader
 //=========================================================
@@ -41,64 +188,163 @@ auto gatherMeshData(tinygltf::Model const &model, i32 accessorIdx)
     return ds::make_view(reinterpret_cast<T const *>(&buffer.data[offset]), accessor.count);
 }
 
+// Appends every triangle primitive of 'mesh' to 'meshes', one 'Mesh' each : indices refer to that primitive's vertices
+static void parseGltfMesh(tinygltf::Model const &model, tinygltf::Mesh const &mesh, std::vector<Mesh> &meshes)
+{
+    for (const auto &primitive : mesh.primitives)
+    {
+        if (primitive.mode != TINYGLTF_MODE_TRIANGLES)
+            continue;
+
+        auto const &p   = primitive;
+        auto        idx = [&p](const char *name) { return p.attributes.count(name) > 0 ? p.attributes.at(name) : -1; };
+
+        Mesh outMesh;
+        outMesh.name = mesh.name;
+
+        // INDICES (must read as u16)
+        {
+            auto const dataView = gatherMeshData<u16>(model, primitive.indices);
+            ds::merge<u16>(outMesh.indices, dataView);
+        }
+        // POS : sizes the vertices, the other attributes can't go past it
+        {
+            auto const dataView = gatherMeshData<glm::vec3>(model, idx("POSITION"));
+
+            outMesh.vertices.resize(dataView.size());
+            for (size_t i = 0; i < dataView.size(); ++i) outMesh.vertices[i].pos = dataView[i];
+        }
+
+        size_t const count = outMesh.vertices.size();
+
+        // UV0
+        {
+            auto const dataView = gatherMeshData<glm::vec2>(model, idx("TEXCOORD_0"));
+            for (size_t i = 0; i < std::min(dataView.size(), count); ++i) outMesh.vertices[i].uv0 = dataView[i];
+        }
+        // NORMAL
+        {
+            auto const dataView = gatherMeshData<glm::vec3>(model, idx("NORMAL"));
+            for (size_t i = 0; i < std::min(dataView.size(), count); ++i) outMesh.vertices[i].normal = dataView[i];
+        }
+        // TANGENT
+        {
+            auto const dataView = gatherMeshData<glm::vec4>(model, idx("TANGENT"));
+            for (size_t i = 0; i < std::min(dataView.size(), count); ++i) outMesh.vertices[i].tangent = dataView[i];
+            outMesh.hasTangents = !dataView.empty();
+        }
+
+        meshes.push_back(std::move(outMesh));
+    }
+}
+
 std::vector<Mesh> parseGltf(tinygltf::Model const &model)
 {
     std::vector<Mesh> meshes;
 
+    for (auto const &mesh : model.meshes) parseGltfMesh(model, mesh, meshes);
+
+    return meshes;
+}
+
+// Either the explicit matrix or T * R * S, glTF stores both column-major and quaternions as xyzw
+static glm::mat4 gltfLocal(tinygltf::Node const &node)
+{
+    if (node.matrix.size() == 16)
+        return glm::mat4(glm::make_mat4(node.matrix.data()));
+
+    glm::mat4 local { 1.f };
+
+    if (node.translation.size() == 3)
+        local = glm::translate(local, glm::vec3(glm::make_vec3(node.translation.data())));
+    if (node.rotation.size() == 4)
+        local *= glm::mat4_cast(glm::quat((float)node.rotation[3], (float)node.rotation[0], (float)node.rotation[1], (float)node.rotation[2]));
+    if (node.scale.size() == 3)
+        local = glm::scale(local, glm::vec3(glm::make_vec3(node.scale.data())));
+
+    return local;
+}
+
+static GltfScene parseGltfScene(tinygltf::Model const &model, std::string const &filepath)
+{
+    GltfScene out;
+
+    i32 const  nodeCount = (i32)model.nodes.size();
+    auto const inRange   = [nodeCount](i32 node) { return node >= 0 && node < nodeCount; };
+
     for (auto const &mesh : model.meshes)
     {
-        Mesh outMesh;
-        outMesh.name = mesh.name;
+        out.meshFirst.push_back((u32)out.meshes.size());
+        parseGltfMesh(model, mesh, out.meshes);
+        out.meshCount.push_back((u32)out.meshes.size() - out.meshFirst.back());
+    }
+
+    // Roots of the default scene, or every parentless node when the file has no scenes
+    std::vector<i32> roots;
+
+    if (!model.scenes.empty())
+    {
+        auto const sceneIdx = model.defaultScene >= 0 && model.defaultScene < (i32)model.scenes.size() ? model.defaultScene : 0;
+        roots               = model.scenes[sceneIdx].nodes;
+    }
+    else
+    {
+        std::vector<bool> isChild(model.nodes.size(), false);
+        for (auto const &node : model.nodes)
+            for (auto const child : node.children)
+                if (inRange(child))
+                    isChild[child] = true;
+
+        for (i32 i = 0; i < nodeCount; ++i)
+            if (!isChild[i])
+                roots.push_back(i);
+    }
+
+    // Depth-first with an explicit stack, children pushed reversed to keep their file order
+    struct Pending
+    {
+        i32 node   = -1;
+        u32 parent = SceneGraph::sNone;
+    };
+
+    std::vector<Pending> stack;
+    for (auto it = roots.rbegin(); it != roots.rend(); ++it) stack.push_back({ *it });
+
+    // A node reachable twice (shared or a cycle) would be added again, or forever : only its first visit counts
+    std::vector<bool> visited(model.nodes.size(), false);
+
+    while (!stack.empty())
+    {
+        auto const [nodeIdx, parent] = stack.back();
+        stack.pop_back();
 
-        for (const auto &primitive : mesh.primitives)
+        if (!inRange(nodeIdx))
         {
-            if (primitive.mode != TINYGLTF_MODE_TRIANGLES)
-                continue;
-
-            auto const &p   = primitive;
-            auto        idx = [&p](const char *name) { return p.attributes.count(name) > 0 ? p.attributes.at(name) : -1; };
-
-            // INDICES (must read as u16)
-            {
-                auto const dataView = gatherMeshData<u16>(model, primitive.indices);
-                ds::merge<u16>(outMesh.indices, dataView);
-            }
-            // POS
-            {
-                auto const dataView = gatherMeshData<glm::vec3>(model, idx("POSITION"));
-
-                if (outMesh.vertices.empty())
-                    outMesh.vertices.resize(dataView.size());
-
-                for (size_t i = 0; i < dataView.size(); ++i) outMesh.vertices[i].pos = dataView[i];
-            }
-            // UV0
-            {
-                auto const dataView = gatherMeshData<glm::vec2>(model, idx("TEXCOORD_Ø"));
-                for (size_t i = 0; i < dataView.size(); ++i) outMesh.vertices[i].uv0 = dataView[i];
-            }
-            // NORMAL
-            {
-                auto const dataView = gatherMeshData<glm::vec3>(model, idx("NORMAL"));
-                for (size_t i = 0; i < dataView.size(); ++i) outMesh.vertices[i].normal = dataView[i];
-            }
-            // TANGENT
-            {
-                auto const dataView = gatherMeshData<glm::vec4>(model, idx("TANGENT"));
-                for (size_t i = 0; i < dataView.size(); ++i) outMesh.vertices[i].tangent = dataView[i];
-            }
-
-            meshes.push_back(outMesh);
+            BM_ERRF("Loading GLTF {}: node {} out of range, skipped", filepath, nodeIdx);
+            continue;
         }
+
+        if (visited[nodeIdx])
+        {
+            BM_ERRF("Loading GLTF {}: node {} reached more than once, skipped", filepath, nodeIdx);
+            continue;
+        }
+
+        visited[nodeIdx] = true;
+
+        auto const &node  = model.nodes[nodeIdx];
+        u32 const   added = out.graph.add(parent, gltfLocal(node), node.mesh, node.name);
+
+        for (auto it = node.children.rbegin(); it != node.children.rend(); ++it) stack.push_back({ *it, added });
     }
 
-    return meshes;
+    return out;
 }
 
-std::vector<Mesh> parseGltf(bool isBin, std::string const &filepath, ds::view<u8> bin)
+// Loads either flavour into 'model', false (after logging why) on failure
+static bool loadGltf(bool isBin, std::string const &filepath, ds::view<u8> bin, tinygltf::Model &model)
 {
     tinygltf::TinyGLTF ctx;
-    tinygltf::Model    model;
     std::string        err, warn;
 
     bool const ok = isBin ? ctx.LoadBinaryFromMemory(&model, &err, &warn, bin.data(), (u32)bin.size())
@@ -113,10 +359,13 @@ std::vector<Mesh> parseGltf(bool isBin, std::string const &filepath, ds::view<u8
     if (!ok and (err.empty() or warn.empty()))
         BM_ERRF("Loading GLTF {}: Undefined error", filepath);
 
-    if (!ok or !err.empty() or !warn.empty())
-        return {};
+    return ok and err.empty() and warn.empty();
+}
 
-    return parseGltf(model);
+std::vector<Mesh> parseGltf(bool isBin, std::string const &filepath, ds::view<u8> bin)
+{
+    tinygltf::Model model;
+    return loadGltf(isBin, filepath, bin, model) ? parseGltf(model) : std::vector<Mesh> {};
 }
 
 std::vector<Mesh> parseGltf(std::string const &filepath)
@@ -135,4 +384,13 @@ std::vector<Mesh> parseGltf(ds::view<u8> bin, std::string name)
     return parseGltf(true, name, bin);
 }
 
+GltfScene parseGltfScene(std::string const &filepath)
+{
+    auto const bin   = bin::read(filepath);
+    bool const isBin = bin::checkMagic(ds::make_view(bin, 4), { 'g', 'l', 'T', 'F' });
+
+    tinygltf::Model model;
+    return loadGltf(isBin, filepath, ds::make_view(bin), model) ? parseGltfScene(model, filepath) : GltfScene {};
+}
+
 }  // namespace bm
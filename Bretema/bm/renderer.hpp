@@ -4,16 +4,17 @@
 #include "window.hpp"
 
 #include "camera.hpp"
+#include "sceneFile.hpp"
+#include "sceneGraph.hpp"
+#include "strId.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
 
 namespace bm
 {
 
-//===========================
-//= TYPEDEFS
-//===========================
-
-using UUID = std::string;
-
 //===========================
 //= ENUMS
 //===========================
@@ -46,6 +47,13 @@ enum struct Samples
     _64,
 };
 
+enum struct PresentMode
+{
+    Fifo,       // VSync, never tears
+    Mailbox,    // VSync, newest frame replaces the queued one (falls back to Fifo)
+    Immediate,  // No VSync, may tear (falls back to Fifo)
+};
+
 //===========================
 //= AUX STRUCTS
 //===========================
@@ -72,6 +80,27 @@ struct Area3D
     static Area3D fromInitSize(glm::vec3 const &init, glm::vec3 const &size) { return { init, init + size }; }
 };
 
+struct DrawStats  // What the backend recorded for one frame
+{
+    u32 objects       = 0;  // Considered after culling
+    u32 occluded      = 0;  // Dropped by occlusion culling, after frustum culling
+    u32 draws         = 0;  // Draw calls issued
+    u32 pipelineBinds = 0;
+    u32 meshBinds     = 0;
+};
+
+struct PickResult  // Answer to the pick ray of a snapshot
+{
+    u64       frame    = 0;      // Snapshot that asked
+    u32       object   = ~0u;    // Backend id of the closest object, ~0u : nothing hit
+    float     t        = INF;    // Distance along the ray
+    glm::vec3 point    = ZERO3;  // World space
+    u32       triangle = ~0u;    // Of the object's mesh, ~0u when only its bounds were hit
+    float     ms       = 0.f;    // Time spent answering it
+
+    inline bool hit() const { return object != ~0u; }
+};
+
 //===========================
 //= TYPES
 //===========================
@@ -98,6 +127,7 @@ struct Mesh  // @todo : Check if should change this to use vertex-pull instead v
     MeshIndices           indices;
     std::vector<Vertex>   vertices;
     std::vector<Instance> instances;
+    bool                  hasTangents = false;  // Tangents come from the asset, not defaulted
 };
 using Vertices      = std::vector<Mesh::Vertex>;
 using Instances     = std::vector<Mesh::Instance>;
@@ -121,6 +151,48 @@ struct Framebuffer  // Data for a GPU Framebuffer... does it make sense?
 {
 };
 
+//===========================
+//= SETTINGS
+//===========================
+
+struct RendererSettings
+{
+    bool        bindless    = false;              // Reference per-object data by index from one big descriptor set instead of per-draw binds
+    PresentMode presentMode = PresentMode::Fifo;  // Swapchain present mode, unsupported ones fall back to Fifo
+    u32         maxFps      = 0;                  // CPU frame limiter, 0 : unlimited
+    bool        lowLatency  = false;              // Keep one frame queued and record it before acquiring the swapchain image
+    bool        onDemand    = false;              // Only render when input, camera or renderer state changed, sleep on events otherwise
+    bool        occlusion   = false;              // CPU occlusion culling of what survives the frustum, pays off on dense scenes
+    bool        gpuCulling  = false;              // Frustum + two-phase HZB occlusion culling on the GPU, needs bindless and no low latency
+    Samples     msaa        = Samples::_1;        // 2 / 4 / 8 : multisampled drawing resolved into the presented image, clamped to the device
+
+    // Headless : no window nor surface, frames go to offscreen images that can be read back (CI, GPU-less servers)
+    bool       headless     = false;
+    glm::uvec2 headlessSize = { 1280, 720 };
+};
+
+//===========================
+//= FRAME SNAPSHOT
+//===========================
+
+// Everything the renderer needs from the simulation for one frame, immutable once published.
+// Built on the main thread and handed to the render thread through a triple-buffer.
+struct FrameSnapshot
+{
+    using Clock = std::chrono::steady_clock;
+
+    u64               frame     = 0;
+    glm::mat4         view      = glm::mat4 { 1.f };
+    glm::mat4         proj      = glm::mat4 { 1.f };
+    glm::vec2         size      = ZERO2;       // Window size when the snapshot was taken
+    StrId             scene     = "test"_sid;  // Scene to draw, hashed once here instead of on every lookup
+    Clock::time_point inputTime = {};          // When the input this frame consumes happened
+    bool              pick      = false;       // Cast 'pickRay' into the scene, see 'BaseRenderer::picked'
+    math::Ray         pickRay   = {};          // World space
+
+    inline glm::mat4 viewproj() const { return proj * view; }
+};
+
 //===========================
 //= BASE RENDERER
 //===========================
@@ -128,24 +200,107 @@ struct Framebuffer  // Data for a GPU Framebuffer... does it make sense?
 class BaseRenderer
 {
 public:
+    using Clock = std::chrono::steady_clock;
+
     inline static constexpr i32 sInFlight = 3;
 
     // LIFETIME
-    BaseRenderer(sPtr<bm::Window> window);
+    BaseRenderer(sPtr<bm::Window> window, RendererSettings settings = {});
     virtual ~BaseRenderer() = default;
 
     // PROPS
-    inline bool  isInitialized() { return mInit; }
-    inline float w() { return mSize.x; }
-    inline float h() { return mSize.y; }
+    inline bool                    isInitialized() { return mInit; }
+    inline RendererSettings const &settings() const { return mSettings; }
+    inline float                   w() { return mSize.x; }
+    inline float                   h() { return mSize.y; }
+    inline bool                    headless() const { return mSettings.headless; }
+
+    // LATENCY : Input to present (ms) of the last frame with new input, readable from any thread
+    inline float inputLatency() const { return mInputLatencyMs.load(std::memory_order_relaxed); }
+
+    // GPU TIME : Of the whole frame (ms), as measured by the backend a few frames ago, 0 if unsupported
+    inline float gpuTime() const { return mGpuFrameMs.load(std::memory_order_relaxed); }
+
+    // DRAW STATS : Of the last recorded frame, read them from the render thread (or between frames)
+    inline DrawStats const &drawStats() const { return mDrawStats; }
 
-    // ACTIONS
-    virtual void update() { syncWinSize(); };
-    virtual void draw(Camera const &) = 0;
-    virtual void cleanup()            = 0;
+    // PICKING : Answer to the newest snapshot that asked for one, readable from any thread
+    inline PickResult picked() const
+    {
+        std::lock_guard lock { mPickedMutex };
+        return mPicked;
+    }
+
+    // ON DEMAND : The backend still has work that needs frames (uploads, resize...), cleared on read by the app
+    inline bool consumeRedraw() { return mRedrawRequested.exchange(false, std::memory_order_acq_rel); }
+
+    // ACTIONS : Called from the render thread, the snapshot is the only data shared with the simulation
+    virtual void beginFrame();  // Blocks until a new frame should start
+    virtual void update(FrameSnapshot const &snap)
+    {
+        syncWinSize(snap.size);
+        mInputTime = snap.inputTime;
+    };
+    virtual void draw(FrameSnapshot const &snap) = 0;
+    virtual void cleanup()                       = 0;
+
+    // SCENES : Synthetic 'side' x 'side' grid of the default mesh centered on the origin (benchmarks, stress tests).
+    // Replaces the scene 'name', call it from the render thread or before the first frame
+    virtual void buildGridScene(StrId name, u32 side, float spacing = 1.f) = 0;
+    // Every node of a glTF file that holds a mesh becomes a drawable (one per primitive), false if nothing loaded.
+    // 'name' also names the mesh group, so it is kept as a string (scene files refer to it)
+    virtual bool loadGltfScene(std::string const &name, std::string const &path) = 0;
+    // Local matrix of node 'node' (depth-first index) of a scene loaded from glTF, its subtree follows from the next
+    // frame on. Safe from any thread : edits are queued and the render thread applies them before it culls, skipping
+    // (with a warning) scenes without such node
+    void setNodeLocal(StrId scene, u32 node, glm::mat4 const &local);
+    // Scene 'name' as a file description (no cameras) and back, replacing it. False if it doesn't exist / can't resolve
+    virtual bool exportScene(StrId name, SceneFile &file)       = 0;
+    virtual bool importScene(StrId name, SceneFile const &file) = 0;
+    // Through a scene file, JSON or binary by extension (see 'SceneFile'). Cameras travel along when given
+    bool         saveScene(StrId name, std::string const &path, std::vector<Camera> const &cameras = {});
+    bool         loadScene(StrId name, std::string const &path, std::vector<Camera> *cameras = nullptr);
+
+    // JOBS : Work other threads hand to the render thread, 'runJobs' drains it between frames. Queueing requests a
+    // redraw, so an idle app still publishes the snapshot that wakes the render thread up
+    void queueJob(std::function<void()> job);
+    void runJobs();
+
+    // READBACK : RGBA8 pixels of the last drawn frame (waits for it), empty if the backend can't
+    virtual std::vector<u8> readback() { return {}; }
+    bool                    capture(std::string const &pngPath);  // 'readback' into a PNG file
 
 protected:
-    glm::vec2 winSize() { return mWindow ? mWindow->size() : ZERO2; }
+    glm::vec2 winSize() { return mWindow ? mWindow->size() : (headless() ? glm::vec2(mSettings.headlessSize) : ZERO2); }
+
+    void markPresented();               // Backends call it right after queueing the present
+    void requestRedraw();               // Backends call it when the next frame must be drawn even without new input
+    void publishPick(PickResult pick);  // Backends call it after answering a snapshot's pick ray
+
+    struct NodeEdit
+    {
+        StrId     scene = {};
+        u32       node  = 0;
+        glm::mat4 local = glm::mat4 { 1.f };
+    };
+    // Backends call it on the render thread : swaps the queued 'setNodeLocal' edits into 'edits', oldest first
+    void takeNodeEdits(std::vector<NodeEdit> &edits);
+
+    Clock::time_point  mFrameBegin         = {};
+    Clock::time_point  mInputTime          = {};
+    Clock::time_point  mPresentedInputTime = {};
+    std::atomic<float> mInputLatencyMs     = 0.f;
+    std::atomic<bool>  mRedrawRequested    = true;
+    std::atomic<float> mGpuFrameMs         = 0.f;
+    DrawStats          mDrawStats          = {};
+    PickResult         mPicked             = {};
+    mutable std::mutex mPickedMutex        = {};
+
+    std::vector<NodeEdit> mNodeEdits      = {};  // Written by any thread, drained by the render thread
+    std::mutex            mNodeEditsMutex = {};
+
+    std::vector<std::function<void()>> mJobs      = {};  // Same
+    std::mutex                         mJobsMutex = {};
 
     bool mWindowSizeChanged = false;
 
@@ -153,14 +308,15 @@ protected:
     i32              mFrameNumber = 0;
     glm::vec2        mSize        = ZERO2;
     sPtr<bm::Window> mWindow      = nullptr;
+    RendererSettings mSettings    = {};
 
 private:
-    void syncWinSize()
+    void syncWinSize(glm::vec2 size)
     {
-        mWindowSizeChanged = mSize != winSize();
+        mWindowSizeChanged = mSize != size;
         if (mWindowSizeChanged)
         {
-            mSize = winSize();
+            mSize = size;
         }
     }
 };
@@ -172,6 +328,17 @@ private:
 MeshGroup parseGltf(std::string const &filepath);
 MeshGroup parseGltf(ds::view<u8> bin, std::string name = "");
 
+// Meshes plus the node hierarchy of the default scene, a mesh instanced under many nodes is only stored once
+struct GltfScene
+{
+    MeshGroup        meshes    = {};  // Every triangle primitive
+    std::vector<u32> meshFirst = {};  // Per glTF mesh : its first primitive in 'meshes'
+    std::vector<u32> meshCount = {};  // Per glTF mesh : how many primitives it has
+    SceneGraph       graph     = {};  // 'mesh(node)' indexes 'meshFirst' / 'meshCount'
+};
+
+GltfScene parseGltfScene(std::string const &filepath);
+
 }  // namespace bm
 
 //
@@ -0,0 +1,632 @@
+#include "sceneFile.hpp"
+
+#include "profiler.hpp"
+#include "transform.hpp"
+
+#include <json.hpp>
+
+#include <glm/gtx/matrix_decompose.hpp>
+
+#ifdef _WIN32
+#    ifndef WIN32_LEAN_AND_MEAN
+#        define WIN32_LEAN_AND_MEAN
+#    endif
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace bm
+{
+
+//-----------------------------------------------------------------------------
+
+void SceneFile::clear()
+{
+    *this = {};
+}
+
+bool SceneFile::valid() const
+{
+    if (mesh.size() != world.size() || material.size() != world.size())
+    {
+        BM_ERRF("Scene file : {} transforms but {} meshes and {} materials", world.size(), mesh.size(), material.size());
+        return false;
+    }
+
+    for (u32 i = 0; i < size(); ++i)
+    {
+        if (mesh[i] >= meshes.size() || material[i] >= materials.size())
+        {
+            BM_ERRF("Scene file : object {} points to mesh {} / material {}, out of {} / {}", i, mesh[i], material[i], meshes.size(), materials.size());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+static bool isJson(std::string const &path)
+{
+    static std::string const sExt = ".json";
+    return path.size() >= sExt.size() && path.compare(path.size() - sExt.size(), sExt.size(), sExt) == 0;
+}
+
+bool saveSceneFile(SceneFile const &file, std::string const &path)
+{
+    return isJson(path) ? writeSceneJson(file, path) : writeSceneBinary(file, path);
+}
+
+bool loadSceneFile(std::string const &path, SceneFile &file)
+{
+    return isJson(path) ? readSceneJson(path, file) : readSceneBinary(path, file);
+}
+
+//=====================================
+// JSON
+//=====================================
+
+using json = nlohmann::json;
+
+static char const *modeName(Camera::Mode mode)
+{
+    switch (mode)
+    {
+        case Camera::Mode::Orb: return "orbit";
+        case Camera::Mode::Ortho: return "ortho";
+        default: return "fly";
+    }
+}
+
+static Camera::Mode modeFrom(std::string const &name)
+{
+    return name == "orbit" ? Camera::Mode::Orb : name == "ortho" ? Camera::Mode::Ortho : Camera::Mode::Fly;
+}
+
+static json toJson(glm::vec3 const &v)
+{
+    return { v.x, v.y, v.z };
+}
+
+// glTF order, xyzw
+static json toJson(glm::quat const &q)
+{
+    return { q.x, q.y, q.z, q.w };
+}
+
+// Canonical text form, optional on the file
+static void writeId(json &entry, sole::uuid const &id)
+{
+    if (id != sole::uuid {})
+        entry["id"] = id.str();
+}
+
+static sole::uuid readId(json const &entry)
+{
+    auto const it = entry.find("id");
+    return it != entry.end() ? sole::rebuild(it->get<std::string>()) : sole::uuid {};
+}
+
+static glm::vec3 vec3From(json const &j, char const *key, glm::vec3 const &fallback)
+{
+    auto const it = j.find(key);
+    return it != j.end() && it->size() == 3 ? glm::vec3 { (*it)[0].get<float>(), (*it)[1].get<float>(), (*it)[2].get<float>() } : fallback;
+}
+
+// TRS when the matrix round-trips through it, so the file stays editable, the raw matrix otherwise (shear, projection)
+static void writeWorld(json &object, glm::mat4 const &world)
+{
+    glm::vec3 t, s, skew;
+    glm::quat q;
+    glm::vec4 perspective;
+
+    if (glm::decompose(world, s, q, t, skew, perspective))
+    {
+        auto const recomposed = Transform::compose(t, q, s);
+
+        bool same = true;
+        for (i32 c = 0; c < 4; ++c) same &= math::fuzzyCmp(recomposed[c], world[c], 1e-4f);
+
+        if (same)
+        {
+            object["translation"] = toJson(t);
+            object["rotation"]    = toJson(q);
+            object["scale"]       = toJson(s);
+            return;
+        }
+    }
+
+    object["matrix"] = json(std::vector<float>(glm::value_ptr(world), glm::value_ptr(world) + 16));
+}
+
+static glm::mat4 readWorld(json const &object)
+{
+    if (auto const it = object.find("matrix"); it != object.end() && it->size() == 16)
+        return glm::make_mat4(it->get<std::vector<float>>().data());
+
+    glm::quat rotation = { 1.f, 0.f, 0.f, 0.f };  // w, x, y, z
+    if (auto const it = object.find("rotation"); it != object.end() && it->size() == 4)
+        rotation = glm::quat((*it)[3].get<float>(), (*it)[0].get<float>(), (*it)[1].get<float>(), (*it)[2].get<float>());
+
+    return Transform::compose(vec3From(object, "translation", ZERO3), glm::normalize(rotation), vec3From(object, "scale", ONE3));
+}
+
+//-----------------------------------------------------------------------------
+
+bool writeSceneJson(SceneFile const &file, std::string const &path)
+{
+    BM_PROFILE_ZONE("WriteSceneJson");
+
+    if (!file.valid())
+        return false;
+
+    json meshes = json::array();
+    for (auto const &mesh : file.meshes)
+    {
+        json entry = { { "name", mesh.name }, { "primitive", mesh.primitive } };
+        if (!mesh.source.empty())
+            entry["source"] = mesh.source;
+
+        writeId(entry, mesh.id);
+        meshes.push_back(std::move(entry));
+    }
+
+    json materials = json::array();
+    for (auto const &material : file.materials)
+    {
+        json entry = { { "name", material.name } };
+        writeId(entry, material.id);
+        materials.push_back(std::move(entry));
+    }
+
+    json cameras = json::array();
+    for (auto const &camera : file.cameras)
+    {
+        cameras.push_back({
+          { "name", camera.name() },
+          { "eye", toJson(camera.eye()) },
+          { "lookAt", toJson(camera.lookAt()) },
+          { "fov", camera.fov() },
+          { "mode", modeName(camera.mode()) },
+        });
+    }
+
+    json objects = json::array();
+    for (u32 i = 0; i < file.size(); ++i)
+    {
+        json object = { { "mesh", file.mesh[i] }, { "material", file.material[i] } };
+        writeWorld(object, file.world[i]);
+        objects.push_back(std::move(object));
+    }
+
+    json const root = {
+        { "version", SceneFile::sVersion }, { "grouped", file.grouped }, { "meshes", std::move(meshes) },
+        { "materials", std::move(materials) }, { "cameras", std::move(cameras) }, { "objects", std::move(objects) },
+    };
+
+    auto out = std::ofstream { path, std::ios::binary };
+
+    if (!out.is_open())
+    {
+        BM_ERRF("Scene file {} : can't open it for writing", path);
+        return false;
+    }
+
+    out << root.dump(2);
+    return out.good();
+}
+
+//-----------------------------------------------------------------------------
+
+bool readSceneJson(std::string const &path, SceneFile &file)
+{
+    BM_PROFILE_ZONE("ReadSceneJson");
+
+    file.clear();
+
+    auto const text = fs::read(path);
+    auto const root = json::parse(text, nullptr, false);
+
+    if (root.is_discarded() || !root.is_object())
+    {
+        BM_ERRF("Scene file {} : not valid JSON", path);
+        return false;
+    }
+
+    try
+    {
+        if (auto const version = root.value("version", 0u); version != SceneFile::sVersion)
+        {
+            BM_ERRF("Scene file {} : version {}, expected {}", path, version, SceneFile::sVersion);
+            return false;
+        }
+
+        // Hand-written files come in any order, the renderer groups them
+        file.grouped = root.value("grouped", false);
+
+        for (auto const &mesh : root.value("meshes", json::array()))
+        {
+            auto const name = mesh.at("name").get<std::string>();
+            file.meshes.push_back({ name, mesh.value("primitive", 0u), mesh.value("source", std::string {}), readId(mesh) });
+        }
+
+        // Plain strings are accepted too, easier to write by hand
+        for (auto const &material : root.value("materials", json::array()))
+        {
+            if (material.is_string())
+                file.materials.push_back({ material.get<std::string>() });
+            else
+                file.materials.push_back({ material.at("name").get<std::string>(), readId(material) });
+        }
+
+        for (auto const &camera : root.value("cameras", json::array()))
+        {
+            file.cameras.emplace_back(
+              camera.value("name", std::string { "Main" }),
+              vec3From(camera, "eye", FRONT * 8.f),
+              vec3From(camera, "lookAt", ZERO3),
+              modeFrom(camera.value("mode", std::string { "fly" })),
+              camera.value("fov", 75.f));
+        }
+
+        auto const &objects = root.at("objects");
+        file.mesh.reserve(objects.size());
+        file.material.reserve(objects.size());
+        file.world.reserve(objects.size());
+
+        for (auto const &object : objects)
+        {
+            file.mesh.push_back(object.at("mesh").get<u32>());
+            file.material.push_back(object.at("material").get<u32>());
+            file.world.push_back(readWorld(object));
+        }
+    }
+    catch (json::exception const &e)
+    {
+        BM_ERRF("Scene file {} : {}", path, e.what());
+        file.clear();
+        return false;
+    }
+
+    return file.valid();
+}
+
+//=====================================
+// BINARY
+//=====================================
+
+// Every offset is in bytes from the start of the file, arrays are aligned to their element (matrices to 64 bytes).
+// Little endian, like every platform we target
+namespace snapshot
+{
+
+static constexpr std::array<char, 4> sMagic = { 'B', 'M', 'S', 'C' };
+
+struct StrRef  // Into the string blob, not null-terminated
+{
+    u32 offset = 0;
+    u32 size   = 0;
+};
+
+struct Header
+{
+    std::array<char, 4> magic     = sMagic;
+    u32                 version   = SceneFile::sVersion;
+    u32                 flags     = 0;  // 'sGrouped'
+    u32                 meshes    = 0;
+    u32                 materials = 0;
+    u32                 cameras   = 0;
+    u32                 objects   = 0;
+    u32                 pad       = 0;
+
+    u64 strings       = 0;
+    u64 stringsSize   = 0;
+    u64 meshTable     = 0;  // 'MeshRecord' x 'meshes'
+    u64 materialTable = 0;  // 'MaterialRecord' x 'materials'
+    u64 cameraTable   = 0;  // 'CameraRecord' x 'cameras'
+    u64 worlds        = 0;  // glm::mat4 x 'objects'
+    u64 meshIdx       = 0;  // u32 x 'objects'
+    u64 materialIdx   = 0;  // u32 x 'objects'
+};
+
+struct MeshRecord
+{
+    StrRef     name      = {};
+    StrRef     source    = {};
+    u32        primitive = 0;
+    u32        pad       = 0;
+    sole::uuid id        = {};
+};
+
+struct MaterialRecord
+{
+    StrRef     name = {};
+    sole::uuid id   = {};
+};
+
+struct CameraRecord
+{
+    StrRef    name   = {};
+    glm::vec3 eye    = {};
+    glm::vec3 lookAt = {};
+    float     fov    = 0.f;
+    u32       mode   = 0;
+};
+
+static constexpr u32 sGrouped = BM_BIT(0);
+
+static_assert(
+  sizeof(Header) == 96 && sizeof(MeshRecord) == 40 && sizeof(MaterialRecord) == 24 && sizeof(CameraRecord) == 40,
+  "Snapshot layout changed, bump the version");
+
+//-----
+
+// Read-only view of a whole file, mapped when the platform can and read into memory otherwise
+class MappedFile
+{
+public:
+    explicit MappedFile(std::string const &path)
+    {
+#ifdef _WIN32
+        mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (mFile == INVALID_HANDLE_VALUE)
+            return;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+            return;
+
+        mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mMapping)
+            return;
+
+        mData = (u8 const *)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+        mSize = mData ? (size_t)size.QuadPart : 0;
+#else
+        mFd = open(path.c_str(), O_RDONLY);
+        if (mFd < 0)
+            return;
+
+        struct stat info;
+        if (fstat(mFd, &info) != 0 || info.st_size == 0)
+            return;
+
+        void *data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, mFd, 0);
+        if (data == MAP_FAILED)
+            return;
+
+        mData = (u8 const *)data;
+        mSize = (size_t)info.st_size;
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        if (mData)
+            UnmapViewOfFile(mData);
+        if (mMapping)
+            CloseHandle(mMapping);
+        if (mFile != INVALID_HANDLE_VALUE)
+            CloseHandle(mFile);
+#else
+        if (mData)
+            munmap((void *)mData, mSize);
+        if (mFd >= 0)
+            close(mFd);
+#endif
+    }
+
+    MappedFile(MappedFile const &)            = delete;
+    MappedFile &operator=(MappedFile const &) = delete;
+
+    inline u8 const *data() const { return mData; }
+    inline size_t    size() const { return mSize; }
+
+    // 'count' elements of T at 'offset', null when they don't fit in the file
+    template<typename T>
+    inline T const *at(u64 offset, u64 count) const
+    {
+        bool const fits = offset <= mSize && count <= (mSize - offset) / sizeof(T) && offset % alignof(T) == 0;
+        return fits ? (T const *)(mData + offset) : nullptr;
+    }
+
+private:
+    u8 const *mData = nullptr;
+    size_t    mSize = 0;
+
+#ifdef _WIN32
+    HANDLE mFile    = INVALID_HANDLE_VALUE;
+    HANDLE mMapping = nullptr;
+#else
+    int mFd = -1;
+#endif
+};
+
+//-----
+
+class Writer
+{
+public:
+    // Pads up to 'align' and returns where the appended bytes start
+    u64 append(void const *data, size_t bytes, size_t align)
+    {
+        mBytes.resize((mBytes.size() + align - 1) / align * align);
+        u64 const offset = mBytes.size();
+
+        mBytes.resize(offset + bytes);
+        if (bytes > 0)
+            memcpy(mBytes.data() + offset, data, bytes);
+
+        return offset;
+    }
+
+    template<typename T>
+    u64 append(std::vector<T> const &items, size_t align = alignof(T))
+    {
+        return append(items.data(), items.size() * sizeof(T), align);
+    }
+
+    StrRef string(std::string const &str)
+    {
+        StrRef const ref = { (u32)mStrings.size(), (u32)str.size() };
+        mStrings += str;
+        return ref;
+    }
+
+    inline std::vector<u8> &bytes() { return mBytes; }
+    inline std::string     &strings() { return mStrings; }
+
+private:
+    std::vector<u8> mBytes   = {};
+    std::string     mStrings = {};
+};
+
+}  // namespace snapshot
+
+//-----------------------------------------------------------------------------
+
+bool writeSceneBinary(SceneFile const &file, std::string const &path)
+{
+    BM_PROFILE_ZONE("WriteSceneBinary");
+
+    using namespace snapshot;
+
+    if (!file.valid())
+        return false;
+
+    Writer w;
+
+    std::vector<MeshRecord> meshes;
+    for (auto const &mesh : file.meshes) meshes.push_back({ w.string(mesh.name), w.string(mesh.source), mesh.primitive, 0, mesh.id });
+
+    std::vector<MaterialRecord> materials;
+    for (auto const &material : file.materials) materials.push_back({ w.string(material.name), material.id });
+
+    std::vector<CameraRecord> cameras;
+    for (auto const &camera : file.cameras)
+        cameras.push_back({ w.string(camera.name()), camera.eye(), camera.lookAt(), camera.fov(), (u32)camera.mode() });
+
+    Header header;
+    header.flags     = file.grouped ? sGrouped : 0;
+    header.meshes    = (u32)meshes.size();
+    header.materials = (u32)materials.size();
+    header.cameras   = (u32)cameras.size();
+    header.objects   = file.size();
+
+    // Header first, patched once every offset is known
+    w.append(&header, sizeof(Header), alignof(Header));
+
+    header.meshTable     = w.append(meshes);
+    header.materialTable = w.append(materials);
+    header.cameraTable   = w.append(cameras);
+    header.worlds        = w.append(file.world, 64);
+    header.meshIdx       = w.append(file.mesh);
+    header.materialIdx   = w.append(file.material);
+    header.strings       = w.append(w.strings().data(), w.strings().size(), 1);
+    header.stringsSize   = w.strings().size();
+
+    memcpy(w.bytes().data(), &header, sizeof(Header));
+
+    auto out = std::ofstream { path, std::ios::binary };
+
+    if (!out.is_open())
+    {
+        BM_ERRF("Scene file {} : can't open it for writing", path);
+        return false;
+    }
+
+    out.write((char const *)w.bytes().data(), (std::streamsize)w.bytes().size());
+    return out.good();
+}
+
+//-----------------------------------------------------------------------------
+
+bool readSceneBinary(std::string const &path, SceneFile &file)
+{
+    BM_PROFILE_ZONE("ReadSceneBinary");
+
+    using namespace snapshot;
+
+    file.clear();
+
+    MappedFile const map { path };
+    auto const      *header = map.at<Header>(0, 1);
+
+    if (!header || header->magic != sMagic)
+    {
+        BM_ERRF("Scene file {} : missing or not a scene snapshot", path);
+        return false;
+    }
+
+    if (header->version != SceneFile::sVersion)
+    {
+        BM_ERRF("Scene file {} : version {}, expected {}", path, header->version, SceneFile::sVersion);
+        return false;
+    }
+
+    auto const *strings     = map.at<char>(header->strings, header->stringsSize);
+    auto const *meshes      = map.at<MeshRecord>(header->meshTable, header->meshes);
+    auto const *materials   = map.at<MaterialRecord>(header->materialTable, header->materials);
+    auto const *cameras     = map.at<CameraRecord>(header->cameraTable, header->cameras);
+    auto const *worlds      = map.at<glm::mat4>(header->worlds, header->objects);
+    auto const *meshIdx     = map.at<u32>(header->meshIdx, header->objects);
+    auto const *materialIdx = map.at<u32>(header->materialIdx, header->objects);
+
+    if (!strings || !meshes || !materials || !cameras || !worlds || !meshIdx || !materialIdx)
+    {
+        BM_ERRF("Scene file {} : truncated", path);
+        return false;
+    }
+
+    bool       stringsOk = true;
+    auto const str       = [&](StrRef ref)
+    {
+        stringsOk &= (u64)ref.offset + ref.size <= header->stringsSize;
+        return stringsOk ? std::string { strings + ref.offset, ref.size } : std::string {};
+    };
+
+    //--- Small tables
+
+    file.meshes.reserve(header->meshes);
+    for (u32 i = 0; i < header->meshes; ++i)
+        file.meshes.push_back({ str(meshes[i].name), meshes[i].primitive, str(meshes[i].source), meshes[i].id });
+
+    file.materials.reserve(header->materials);
+    for (u32 i = 0; i < header->materials; ++i) file.materials.push_back({ str(materials[i].name), materials[i].id });
+
+    file.cameras.reserve(header->cameras);
+    for (u32 i = 0; i < header->cameras; ++i)
+    {
+        auto const &c = cameras[i];
+        file.cameras.emplace_back(str(c.name), c.eye, c.lookAt, (Camera::Mode)std::min(c.mode, (u32)Camera::Mode::Ortho), c.fov);
+    }
+
+    if (!stringsOk)
+    {
+        BM_ERRF("Scene file {} : string out of bounds", path);
+        file.clear();
+        return false;
+    }
+
+    //--- Objects, one bulk copy per array
+
+    file.world.assign(worlds, worlds + header->objects);
+    file.mesh.assign(meshIdx, meshIdx + header->objects);
+    file.material.assign(materialIdx, materialIdx + header->objects);
+    file.grouped = header->flags & sGrouped;
+
+    return file.valid();
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm
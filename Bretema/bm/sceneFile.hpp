@@ -0,0 +1,71 @@
+#pragma once
+
+#include "base.hpp"
+#include "camera.hpp"
+#include "utils.hpp"
+
+#include <sole.hpp>
+
+#include <string>
+#include <vector>
+
+namespace bm
+{
+
+//=====================================
+// SCENE FILE
+//=====================================
+
+// What a scene is made of, backend agnostic : meshes and materials are referenced by stable id (falling back to their
+// name) and resolved by the renderer when the scene is instanced, objects point to them by index.
+// Two formats on disk :
+//  - JSON ('.json'), meant to be written and edited by hand. Objects take either a 'matrix' or TRS components.
+//  - Binary snapshot (anything else), laid out so the object arrays can be used straight from a mapped file : a fixed
+//    header, the small tables, then one array per object field, so loading them is a bulk copy each.
+struct SceneFile
+{
+    static constexpr u32 sVersion = 2;
+
+    struct MeshRef
+    {
+        std::string name      = "";  // Mesh group, as the renderer knows it
+        u32         primitive = 0;   // Within the group
+        std::string source    = "";  // glTF file the group is loaded from when the renderer doesn't have it, optional
+        sole::uuid  id        = {};  // Nil : resolved by name and primitive only
+    };
+
+    struct MaterialRef
+    {
+        std::string name = "";
+        sole::uuid  id   = {};  // Nil : resolved by name only
+    };
+
+    std::vector<MeshRef>     meshes    = {};
+    std::vector<MaterialRef> materials = {};
+    std::vector<Camera>      cameras   = {};
+
+    // Objects, one entry per drawable on each array
+    std::vector<u32>       mesh     = {};  // Into 'meshes'
+    std::vector<u32>       material = {};  // Into 'materials'
+    std::vector<glm::mat4> world    = {};
+
+    bool grouped = false;  // Objects already come grouped for drawing (they were saved from a sorted scene)
+
+    inline u32 size() const { return (u32)world.size(); }
+
+    void clear();
+
+    // Every object points to existing meshes and materials and all arrays agree on the size, logs what's wrong
+    bool valid() const;
+};
+
+// The format is picked by the extension, both log what went wrong and return false on failure
+bool saveSceneFile(SceneFile const &file, std::string const &path);
+bool loadSceneFile(std::string const &path, SceneFile &file);
+
+bool writeSceneJson(SceneFile const &file, std::string const &path);
+bool readSceneJson(std::string const &path, SceneFile &file);
+bool writeSceneBinary(SceneFile const &file, std::string const &path);
+bool readSceneBinary(std::string const &path, SceneFile &file);
+
+}  // namespace bm
@@ -0,0 +1,46 @@
+#include "sceneGraph.hpp"
+
+namespace bm
+{
+
+//-----------------------------------------------------------------------------
+
+u32 SceneGraph::add(u32 parent, glm::mat4 const &local, i32 mesh, std::string name)
+{
+    u32 const node = size();
+
+    // Only the open path of the depth-first walk ends at the tail, anything else would split a subtree
+    BM_ASSERT_X(parent == sNone || (parent < node && mEnd[parent] == node), "SceneGraph nodes must be added depth-first");
+
+    mParent.push_back(parent);
+    mEnd.push_back(node + 1);
+    mMesh.push_back(mesh);
+    mLocal.push_back(local);
+    mWorld.push_back(parent == sNone ? local : mWorld[parent] * local);
+    mName.push_back(std::move(name));
+
+    for (u32 p = parent; p != sNone; p = mParent[p]) mEnd[p] = node + 1;
+
+    return node;
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneGraph::setLocal(u32 node, glm::mat4 const &local)
+{
+    BM_ASSERT(node < size());
+
+    mLocal[node] = local;
+    mDirtyRoots.push_back(node);
+}
+
+//-----------------------------------------------------------------------------
+
+void SceneGraph::clear()
+{
+    *this = {};
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm
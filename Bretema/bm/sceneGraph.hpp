@@ -0,0 +1,88 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <string>
+#include <vector>
+
+namespace bm
+{
+
+//=====================================
+// SCENE GRAPH
+//=====================================
+
+// Node hierarchy in structure-of-arrays form, stored depth-first (pre-order) : parents always come before their
+// children and every subtree is the contiguous range [node, subtreeEnd(node)).
+// Changing a local matrix only flags the node, 'update' then walks forward over the flagged subtrees and nothing else.
+class SceneGraph
+{
+public:
+    static constexpr u32 sNone = ~0u;
+
+    // Depth-first construction : 'parent' is 'sNone' (new root) or the last added node or one of its ancestors
+    u32 add(u32 parent, glm::mat4 const &local, i32 mesh = -1, std::string name = "");
+
+    void setLocal(u32 node, glm::mat4 const &local);
+    void clear();
+
+    // Recomputes the world matrices of the flagged subtrees, 'fn(node, world)' is called for every refreshed node
+    template<typename F>
+    void update(F &&fn);
+    inline void update()
+    {
+        update([](u32, glm::mat4 const &) {});
+    }
+
+    inline bool dirty() const { return !mDirtyRoots.empty(); }
+    inline u32  size() const { return (u32)mParent.size(); }
+
+    inline u32                parent(u32 node) const { return mParent[node]; }
+    inline u32                subtreeEnd(u32 node) const { return mEnd[node]; }  // One past its last descendant
+    inline i32                mesh(u32 node) const { return mMesh[node]; }       // Source mesh index, -1 : none
+    inline std::string const &name(u32 node) const { return mName[node]; }
+    inline glm::mat4 const   &local(u32 node) const { return mLocal[node]; }
+    inline glm::mat4 const   &world(u32 node) const { return mWorld[node]; }  // As of the last 'update'
+
+private:
+    std::vector<u32>         mParent     = {};
+    std::vector<u32>         mEnd        = {};
+    std::vector<i32>         mMesh       = {};
+    std::vector<glm::mat4>   mLocal      = {};
+    std::vector<glm::mat4>   mWorld      = {};
+    std::vector<std::string> mName       = {};
+    std::vector<u32>         mDirtyRoots = {};  // Nodes whose local changed, unsorted and maybe repeated
+};
+
+//-----------------------------------------------------------------------------
+
+template<typename F>
+void SceneGraph::update(F &&fn)
+{
+    if (mDirtyRoots.empty())
+        return;
+
+    // Ascending order visits ancestors first, so a root inside an already walked range is covered by it
+    std::sort(mDirtyRoots.begin(), mDirtyRoots.end());
+
+    u32 covered = 0;  // End of the last walked range
+
+    for (u32 const root : mDirtyRoots)
+    {
+        if (root < covered)
+            continue;
+
+        for (u32 i = root; i < mEnd[root]; ++i)
+        {
+            u32 const p = mParent[i];
+            mWorld[i]   = p == sNone ? mLocal[i] : mWorld[p] * mLocal[i];
+            fn(i, mWorld[i]);
+        }
+
+        covered = mEnd[root];
+    }
+
+    mDirtyRoots.clear();
+}
+
+}  // namespace bm
@@ -0,0 +1,52 @@
+#include "strId.hpp"
+
+#include <mutex>
+
+namespace bm
+{
+
+//=====================================
+// STRING ID
+//=====================================
+
+#ifndef NDEBUG
+
+// Function statics : ids may be built while other globals are initialized
+static std::mutex &namesMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::unordered_map<u64, std::string> &names()
+{
+    static std::unordered_map<u64, std::string> table;
+    return table;
+}
+
+void StrId::remember(u64 hash, std::string_view name)
+{
+    std::lock_guard lock { namesMutex() };
+
+    auto const [it, added] = names().try_emplace(hash, name);
+    BM_ASSERT_X(added || it->second == name, "StrId collision, two names share a hash");
+}
+
+std::string StrId::str() const
+{
+    std::lock_guard lock { namesMutex() };
+
+    auto const it = names().find(mHash);
+    return it != names().end() ? it->second : BM_FMT("#{:016x}", mHash);
+}
+
+#else
+
+std::string StrId::str() const
+{
+    return BM_FMT("#{:016x}", mHash);
+}
+
+#endif
+
+}  // namespace bm
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace bm
+{
+
+//=====================================
+// STRING ID
+//=====================================
+
+// 64-bit FNV-1a of a name, usable as a key wherever the name itself is only compared.
+//  - Literals hash at compile time ('"test"_sid' always, plain literals when the context is constant evaluated).
+//  - Keep the id around (snapshots, members) : copying and comparing it is an integer op, nothing is rehashed.
+//  - Debug builds remember the names hashed at runtime, so 'str()' can print them back. Release prints the hash.
+class StrId
+{
+public:
+    constexpr StrId() = default;
+
+    constexpr StrId(std::string_view name) : mHash(hash(name))
+    {
+        if (!std::is_constant_evaluated())
+            remember(mHash, name);
+    }
+
+    constexpr StrId(char const *name) : StrId(std::string_view(name)) {}
+    StrId(std::string const &name) : StrId(std::string_view(name)) {}
+
+    inline constexpr u64  value() const { return mHash; }
+    inline constexpr bool empty() const { return mHash == sEmpty; }
+
+    inline constexpr auto operator<=>(StrId const &) const = default;
+
+    // Name it was built from when known (debug only), its hash otherwise
+    std::string str() const;
+
+    // 'seed' replaces the FNV offset basis, for callers that need a second independent hash of the same name
+    static constexpr u64 hash(std::string_view name, u64 seed = sEmpty)
+    {
+        u64 h = seed;
+        for (char const c : name) h = (h ^ (u8)c) * 0x100000001b3ull;
+        return h;
+    }
+
+private:
+    static constexpr u64 sEmpty = 0xcbf29ce484222325ull;  // FNV offset basis : hash of ""
+
+#ifndef NDEBUG
+    static void remember(u64 hash, std::string_view name);
+#else
+    static inline void remember(u64, std::string_view) {}
+#endif
+
+    u64 mHash = sEmpty;
+};
+
+inline namespace literals
+{
+consteval StrId operator""_sid(char const *name, size_t size)
+{
+    return StrId(std::string_view(name, size));
+}
+}  // namespace literals
+
+}  // namespace bm
+
+template<>
+struct std::hash<bm::StrId>
+{
+    // Already a hash, re-hashing it would only cost time
+    inline size_t operator()(bm::StrId const &id) const noexcept { return (size_t)id.value(); }
+};
+
+template<>
+struct fmt::formatter<bm::StrId>
+{
+    constexpr auto parse(format_parse_context &ctx) -> decltype(ctx.begin()) { return ctx.begin(); }
+
+    template<typename FormatContext>
+    auto format(const bm::StrId &id, FormatContext &ctx) const -> decltype(ctx.out())
+    {
+        return fmt::format_to(ctx.out(), "{}", id.str());
+    }
+};
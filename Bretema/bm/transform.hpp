@@ -2,6 +2,8 @@
 
 #include "base.hpp"
 
+#include <glm/gtx/quaternion.hpp>
+
 namespace bm
 {
 
@@ -38,77 +40,87 @@ struct Directions
     glm::vec3 D = {};
 };
 
+// Position, rotation and scale, with the composed matrix cached until one of them changes
 class Transform
 {
 public:
-    glm::mat4 matrix() const
-    {
-        glm::mat4 T = glm::translate(glm::mat4 { 1.f }, mPos);
+    Transform() = default;
+    Transform(glm::vec3 const &pos, glm::quat const &rot = sIdentity, glm::vec3 const &scl = ONE3) : mPos(pos), mRot(rot), mScl(scl) {}
 
-        glm::mat4 R { 1.f };
-        R = glm::rotate(R, glm::radians(safeRot().z), FRONT);
-        R = glm::rotate(R, glm::radians(safeRot().y), UP);
-        R = glm::rotate(R, glm::radians(safeRot().x), RIGHT);
+    // T * R * S from the raw components, without going through three matrix products
+    static inline glm::mat4 compose(glm::vec3 const &t, glm::quat const &q, glm::vec3 const &s)
+    {
+        float const xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+        float const xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+        float const wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+        return {
+            glm::vec4 { (1.f - 2.f * (yy + zz)) * s.x, 2.f * (xy + wz) * s.x, 2.f * (xz - wy) * s.x, 0.f },
+            glm::vec4 { 2.f * (xy - wz) * s.y, (1.f - 2.f * (xx + zz)) * s.y, 2.f * (yz + wx) * s.y, 0.f },
+            glm::vec4 { 2.f * (xz + wy) * s.z, 2.f * (yz - wx) * s.z, (1.f - 2.f * (xx + yy)) * s.z, 0.f },
+            glm::vec4 { t, 1.f },
+        };
+    }
 
-        glm::mat4 S = glm::scale(glm::mat4 { 1.f }, mScl);
+    // Rebuilt on the first call after a change
+    glm::mat4 const &matrix() const
+    {
+        if (mDirty)
+        {
+            mMatrix = compose(mPos, mRot, mScl);
+            mDirty  = false;
+        }
 
-        return T * R * S;
+        return mMatrix;
     }
 
     glm::mat4 matrixRotFirst() const
     {
-        glm::mat4 T = glm::translate(glm::mat4 { 1.f }, mPos);
-
-        glm::mat4 R { 1.f };
-        R = glm::rotate(R, glm::radians(safeRot().z), FRONT);
-        R = glm::rotate(R, glm::radians(safeRot().y), UP);
-        R = glm::rotate(R, glm::radians(safeRot().x), RIGHT);
-
-        glm::mat4 S = glm::scale(glm::mat4 { 1.f }, mScl);
-
-        return R * T * S;
+        return glm::mat4_cast(mRot) * glm::translate(glm::mat4 { 1.f }, mPos) * glm::scale(glm::mat4 { 1.f }, mScl);
     }
 
     Directions directions() const { return Directions(matrix()); }
 
+    // Turns the current orientation so its front faces 'front'
     void setFront(glm::vec3 const &front)
     {
-        auto const dir = directions();
-        auto const A   = glm::normalize(dir.F);
-        auto const B   = glm::normalize(front);
-        mRot           = glm::degrees(glm::eulerAngles(glm::rotation(A, B)));
+        auto const A = glm::normalize(directions().F);
+        auto const B = glm::normalize(front);
+        setRot(glm::rotation(A, B) * mRot);
     }
 
     void reset() { *this = {}; }
 
     // TRANSLATION
-    inline glm::vec3  pos() const { return mPos; }
-    inline glm::vec3 &pos() { return mPos; }
+    inline glm::vec3 const &pos() const { return mPos; }
+    inline void             setPos(glm::vec3 const &pos) { mPos = pos, mDirty = true; }
+    inline void             translate(glm::vec3 const &delta) { setPos(mPos + delta); }
 
     // SCALE
-    inline glm::vec3  scl() const { return mScl; }
-    inline glm::vec3 &scl() { return mScl; }
-
-    // ROTATION
-    inline glm::vec3  rot() const { return safeRot(); }
-    inline glm::vec3 &rot() { return safeRot(); }
+    inline glm::vec3 const &scl() const { return mScl; }
+    inline void             setScl(glm::vec3 const &scl) { mScl = scl, mDirty = true; }
 
-private:
-    glm::vec3         mPos { 0.f };
-    mutable glm::vec3 mRot { 0.f };
-    glm::vec3         mScl { 1.f };
+    // ROTATION : stored as a unit quaternion, Euler angles (degrees, applied Z * Y * X like before) are a convenience
+    inline glm::quat const &rot() const { return mRot; }
+    inline void             setRot(glm::quat const &rot) { mRot = glm::normalize(rot), mDirty = true; }
+    inline void             rotate(glm::quat const &delta) { setRot(delta * mRot); }
 
-    glm::vec3 &safeRot() const
+    inline glm::vec3 euler() const { return glm::degrees(glm::eulerAngles(mRot)); }
+    inline void      setEuler(glm::vec3 const &degrees)
     {
-        if (mRot.x < 0.f || mRot.x > 360.f)
-            mRot.x = math::clampAngle(mRot.x);
-        if (mRot.y < 0.f || mRot.y > 360.f)
-            mRot.y = math::clampAngle(mRot.y);
-        if (mRot.z < 0.f || mRot.z > 360.f)
-            mRot.z = math::clampAngle(mRot.z);
-
-        return mRot;
+        auto const r = glm::radians(degrees);
+        setRot(glm::angleAxis(r.z, FRONT) * glm::angleAxis(r.y, UP) * glm::angleAxis(r.x, RIGHT));
     }
+
+private:
+    inline static glm::quat const sIdentity = { 1.f, 0.f, 0.f, 0.f };
+
+    glm::vec3 mPos { 0.f };
+    glm::quat mRot = sIdentity;
+    glm::vec3 mScl { 1.f };
+
+    mutable glm::mat4 mMatrix { 1.f };
+    mutable bool      mDirty = true;
 };
 
-}  // namespace bm
\ No newline at end of file
+}  // namespace bm
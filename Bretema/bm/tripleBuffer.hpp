@@ -0,0 +1,105 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <atomic>
+
+namespace bm::ds
+{
+
+//-----------------------------------------------------------------------------
+
+// Lock-free single-producer / single-consumer hand-off of the latest value.
+// The producer fills 'back()' and publishes it, the consumer fetches the newest published one into 'front()'.
+// Neither side ever waits on the other while touching its own slot, a publish not yet fetched is just replaced.
+template<typename T>
+class TripleBuffer
+{
+    // State word : | sequence ... | closed | fresh | middle-slot (2 bits) |
+    static constexpr u32 sSlotMask = 0b0011;
+    static constexpr u32 sFresh    = 0b0100;
+    static constexpr u32 sClosed   = 0b1000;
+    static constexpr u32 sSeqShift = 4;
+
+public:
+    TripleBuffer() = default;
+    TripleBuffer(T const &init) : mSlots { init, init, init } {}
+
+    //--- PRODUCER
+
+    inline T &back() { return mSlots[mBack]; }
+
+    // Swap 'back' with the middle slot and wake the consumer
+    void publish()
+    {
+        u32 s = mState.load(std::memory_order_relaxed);
+        u32 next;
+        do
+        {
+            u32 const seq = (s >> sSeqShift) + 1;
+            next          = (seq << sSeqShift) | (s & sClosed) | sFresh | mBack;
+        } while (!mState.compare_exchange_weak(s, next, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+        mBack = s & sSlotMask;
+        mState.notify_all();
+    }
+
+    // Block until the consumer took the last publish (or the buffer is closed)
+    void waitConsumed() const
+    {
+        for (u32 s = mState.load(std::memory_order_acquire); (s & sFresh) && !(s & sClosed); s = mState.load(std::memory_order_acquire))
+            mState.wait(s, std::memory_order_acquire);
+    }
+
+    // Wake every waiter for good, 'waitFetch' returns false from now on
+    void close()
+    {
+        mState.fetch_or(sClosed, std::memory_order_acq_rel);
+        mState.notify_all();
+    }
+
+    //--- CONSUMER
+
+    inline T const &front() const { return mSlots[mFront]; }
+
+    // Swap the middle slot into 'front' if something new was published
+    bool fetch()
+    {
+        u32 s = mState.load(std::memory_order_relaxed);
+        do
+        {
+            if (!(s & sFresh))
+                return false;
+        } while (!mState.compare_exchange_weak(s, (s & ~(sFresh | sSlotMask)) | mFront, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+        mFront = s & sSlotMask;
+        mState.notify_all();
+        return true;
+    }
+
+    // Block until a new value is fetched, false once closed
+    bool waitFetch()
+    {
+        for (u32 s = mState.load(std::memory_order_acquire); !(s & sClosed); s = mState.load(std::memory_order_acquire))
+        {
+            if (fetch())
+                return true;
+
+            mState.wait(s, std::memory_order_acquire);
+        }
+
+        return false;
+    }
+
+    inline bool isClosed() const { return mState.load(std::memory_order_acquire) & sClosed; }
+
+private:
+    T                mSlots[3] = {};
+    std::atomic<u32> mState    = 1;  // Middle starts at slot 1
+    u32              mBack     = 0;  // Producer only
+    u32              mFront    = 2;  // Consumer only
+};
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::ds
@@ -2,6 +2,8 @@
 
 #include "base.hpp"
 
+#include <chrono>
+
 namespace bm
 {
 
@@ -176,6 +178,7 @@ class UserInput
 {
 public:
     using CallBack = std::function<void(UserInput *)>;
+    using Clock    = std::chrono::steady_clock;
 
     UserInput(CallBack onInputChanged) : mOnInputChanged(onInputChanged) {}
 
@@ -232,6 +235,13 @@ public:
 
     void press(i32 k, i32 s) { press((Key)k, (State)s); }
 
+    // Time of the last change, to measure input-to-present latency
+
+    inline Clock::time_point lastChange() const { return mLastChange; }
+
+    // Whether anything changed since the last call, drives render-on-demand
+    inline bool consumeChanged() { return std::exchange(mChanged, false); }
+
     bool pressed(Key k, bool ignoreHold = false) const
     {
         if (mKeys.count(k) < 1)
@@ -244,6 +254,9 @@ public:
 private:
     void inputChanged()
     {
+        mLastChange = Clock::now();
+        mChanged    = true;
+
         if (mOnInputChanged)
         {
             mOnInputChanged(this);
@@ -258,7 +271,9 @@ private:
     KeyState   mKeys   = {};
     MouseState mMouse  = {};
 
-    CallBack mOnInputChanged = nullptr;
+    Clock::time_point mLastChange     = {};
+    bool              mChanged        = false;
+    CallBack          mOnInputChanged = nullptr;
 };
 
 }  // namespace bm
\ No newline at end of file
@@ -2,8 +2,12 @@
 
 #include "base.hpp"
 
+#include <cstddef>
 #include <filesystem>
 #include <fstream>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace bm
 {
@@ -111,18 +115,98 @@ inline std::string unixPath(std::string const &s)
 namespace ds
 {
 
+// Move-only 'std::function' replacement that stores the callable inline, never touching the heap.
+// A callable that doesn't fit in 'Capacity' bytes is a compile error, not a silent allocation.
+template<typename Sig, size_t Capacity = 48>
+class InplaceFunction;
+
+template<typename R, typename... Args, size_t Capacity>
+class InplaceFunction<R(Args...), Capacity>
+{
+public:
+    InplaceFunction() = default;
+    InplaceFunction(std::nullptr_t) {}
+
+    template<typename F, typename D = std::decay_t<F>, typename = std::enable_if_t<!std::is_same_v<D, InplaceFunction>>>
+    InplaceFunction(F &&fn)
+    {
+        static_assert(sizeof(D) <= Capacity, "Callable too big for InplaceFunction, raise its Capacity");
+        static_assert(alignof(D) <= alignof(std::max_align_t), "Callable over-aligned for InplaceFunction");
+        static_assert(std::is_nothrow_move_constructible_v<D>, "InplaceFunction relocates its callable");
+
+        new (mStorage) D(std::forward<F>(fn));
+        mInvoke = [](void *self, Args... args) -> R { return (*static_cast<D *>(self))(std::forward<Args>(args)...); };
+        mManage = [](void *dst, void *src)
+        {
+            if (dst)
+                new (dst) D(std::move(*static_cast<D *>(src)));
+            static_cast<D *>(src)->~D();
+        };
+    }
+
+    InplaceFunction(InplaceFunction &&other) noexcept { moveFrom(other); }
+    InplaceFunction &operator=(InplaceFunction &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    InplaceFunction(InplaceFunction const &)            = delete;
+    InplaceFunction &operator=(InplaceFunction const &) = delete;
+
+    ~InplaceFunction() { reset(); }
+
+    R operator()(Args... args) { return mInvoke(mStorage, std::forward<Args>(args)...); }
+
+    explicit operator bool() const { return mInvoke != nullptr; }
+
+    void reset()
+    {
+        if (mManage)
+            mManage(nullptr, mStorage);  // Destroy only
+        mInvoke = nullptr;
+        mManage = nullptr;
+    }
+
+private:
+    void moveFrom(InplaceFunction &other)
+    {
+        if (!other.mManage)
+            return;
+
+        other.mManage(mStorage, other.mStorage);  // Move-construct here + destroy there
+        mInvoke = std::exchange(other.mInvoke, nullptr);
+        mManage = std::exchange(other.mManage, nullptr);
+    }
+
+    alignas(std::max_align_t) std::byte mStorage[Capacity];
+    R (*mInvoke)(void *, Args...)  = nullptr;
+    void (*mManage)(void *, void *) = nullptr;  // (dst, src) : relocate when 'dst', destroy-only otherwise
+};
+
+//-----------------------------------------------------------------------------
+
+// LIFO list of teardown callbacks, flushed at shutdown or when the owner is rebuilt
 class DeletionQueue
 {
 public:
-    using fnType = std::function<void()>;
+    using fnType = InplaceFunction<void()>;
 
-    void add(fnType const &fn) { mDestroyFuncs.push_back(fn); }
+    template<typename F>
+    void add(F &&fn)
+    {
+        mDestroyFuncs.emplace_back(std::forward<F>(fn));
+    }
 
     void flush()
     {
         for (auto fnIt = mDestroyFuncs.rbegin(); fnIt != mDestroyFuncs.rend(); ++fnIt)
         {
-            auto const &fn = *fnIt;
+            auto &fn = *fnIt;
             if (fn)
             {
                 fn();
@@ -131,10 +215,74 @@ public:
         mDestroyFuncs.clear();
     }
 
+    inline bool empty() const { return mDestroyFuncs.empty(); }
+
 private:
     std::vector<fnType> mDestroyFuncs;
 };
 
+//-----------------------------------------------------------------------------
+
+// FIFO of callbacks tagged with the (monotonic) frame / timeline value after which they are safe to run.
+// Values are expected in roughly increasing order : 'collect' stops at the first pending entry, so an
+// out-of-order one is only ever run later than needed, never earlier.
+class RetireQueue
+{
+public:
+    using fnType = InplaceFunction<void()>;
+
+    template<typename F>
+    void push(u64 value, F &&fn)
+    {
+        mEntries.push_back({ value, fnType { std::forward<F>(fn) } });
+    }
+
+    // Run every entry whose value is <= 'done', returns how many ran
+    size_t collect(u64 done)
+    {
+        size_t ran = 0;
+
+        // By index : a callback is allowed to push new entries while we iterate
+        while (mHead < mEntries.size() && mEntries[mHead].value <= done)
+        {
+            auto fn = std::move(mEntries[mHead++].fn);
+            if (fn)
+                fn();
+            ++ran;
+        }
+
+        // Compact once the consumed prefix dominates, keeps the storage bounded without per-entry shifts
+        if (mHead == mEntries.size())
+        {
+            mEntries.clear();
+            mHead = 0;
+        }
+        else if (mHead > 64 && mHead * 2 > mEntries.size())
+        {
+            mEntries.erase(mEntries.begin(), mEntries.begin() + mHead);
+            mHead = 0;
+        }
+
+        return ran;
+    }
+
+    // Run everything regardless of its value, the owner must know the GPU is idle
+    void flush() { collect(~0ull); }
+
+    inline bool   empty() const { return mHead == mEntries.size(); }
+    inline size_t size() const { return mEntries.size() - mHead; }
+
+private:
+    struct Entry
+    {
+        u64    value = 0;
+        fnType fn    = {};
+    };
+
+    std::vector<Entry> mEntries = {};
+    size_t             mHead    = 0;
+};
+
 template<typename T, size_t E = static_cast<size_t>(-1)>
 using view = std::span<T const, E>;
 
@@ -321,6 +469,177 @@ inline bool isAligned(T const &a, T const &b, float margin = 0.f)
     return abs(glm::dot(glm::normalize(a), glm::normalize(b))) >= (1.f - EPSILON - margin);
 }
 
+// Axis aligned bounding box, default constructed as empty (min > max) so expanding it is always valid
+struct AABB
+{
+    glm::vec3 min = INF3;
+    glm::vec3 max = -INF3;
+
+    inline bool      empty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+    inline glm::vec3 center() const { return (min + max) * 0.5f; }
+    inline glm::vec3 extent() const { return (max - min) * 0.5f; }  // Half size
+
+    inline void expand(glm::vec3 const &p)
+    {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+
+    inline void expand(AABB const &o)
+    {
+        min = glm::min(min, o.min);
+        max = glm::max(max, o.max);
+    }
+
+    // Box that contains this one once transformed, by projecting the half size on every axis of 'm' (Arvo)
+    inline AABB transformed(glm::mat4 const &m) const
+    {
+        if (empty())
+            return {};
+
+        glm::vec3 const c = glm::vec3(m * glm::vec4(center(), 1.f));
+        glm::vec3 const e = extent();
+        glm::vec3 const r = glm::abs(glm::vec3(m[0])) * e.x + glm::abs(glm::vec3(m[1])) * e.y + glm::abs(glm::vec3(m[2])) * e.z;
+
+        return { c - r, c + r };
+    }
+
+    inline float area() const  // Surface, what the SAH weights nodes by
+    {
+        if (empty())
+            return 0.f;
+
+        glm::vec3 const d = max - min;
+        return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    inline bool overlaps(AABB const &o) const { return glm::all(glm::lessThanEqual(min, o.max)) && glm::all(glm::lessThanEqual(o.min, max)); }
+    inline bool contains(AABB const &o) const { return glm::all(glm::lessThanEqual(min, o.min)) && glm::all(glm::lessThanEqual(o.max, max)); }
+};
+
+// Precomputes the inverse direction for slab tests
+struct Ray
+{
+    Ray() = default;
+    Ray(glm::vec3 const &o, glm::vec3 const &d) : origin(o), dir(glm::normalize(d)), invDir(1.f / dir) {}
+
+    glm::vec3 origin = ZERO3;
+    glm::vec3 dir    = FRONT;
+    glm::vec3 invDir = 1.f / FRONT;
+
+    inline glm::vec3 at(float t) const { return origin + dir * t; }
+
+    // Entry distance into 'box' when it's hit within [0, tMax], INF otherwise
+    inline float hit(AABB const &box, float tMax = INF) const
+    {
+        glm::vec3 const t0 = (box.min - origin) * invDir;
+        glm::vec3 const t1 = (box.max - origin) * invDir;
+
+        float const tNear = glm::compMax(glm::min(t0, t1));
+        float const tFar  = glm::compMin(glm::max(t0, t1));
+
+        return tNear <= tFar && tFar >= 0.f && tNear <= tMax ? std::max(tNear, 0.f) : INF;
+    }
+
+    // Distance to triangle 'abc' when it's hit within [0, tMax], INF otherwise. Both faces count (Moller-Trumbore)
+    inline float hit(glm::vec3 const &a, glm::vec3 const &b, glm::vec3 const &c, float tMax = INF, glm::vec2 *bary = nullptr) const
+    {
+        glm::vec3 const e1  = b - a;
+        glm::vec3 const e2  = c - a;
+        glm::vec3 const p   = glm::cross(dir, e2);
+        float const     det = glm::dot(e1, p);
+
+        if (std::abs(det) < EPSILON)
+            return INF;
+
+        float const     invDet = 1.f / det;
+        glm::vec3 const s      = origin - a;
+        float const     u      = glm::dot(s, p) * invDet;
+
+        if (u < 0.f || u > 1.f)
+            return INF;
+
+        glm::vec3 const q = glm::cross(s, e1);
+        float const     v = glm::dot(dir, q) * invDet;
+
+        if (v < 0.f || u + v > 1.f)
+            return INF;
+
+        float const t = glm::dot(e2, q) * invDet;
+
+        if (t < 0.f || t > tMax)
+            return INF;
+
+        if (bary)
+            *bary = { u, v };
+
+        return t;
+    }
+};
+
+// Ray from the eye through pixel 'px' of a 'size' viewport (top-left origin, as cursors come) for 'vp' = P * V
+inline Ray unproject(glm::vec2 const &px, glm::vec2 const &size, glm::mat4 const &vp)
+{
+    glm::vec2 const ndc = px / glm::max(size, ONE2) * 2.f - 1.f;
+    glm::mat4 const inv = glm::inverse(vp);
+
+    glm::vec4 const onNear = inv * glm::vec4(ndc, 0.f, 1.f);
+    glm::vec4 const onFar  = inv * glm::vec4(ndc, 1.f, 1.f);
+
+    glm::vec3 const from = glm::vec3(onNear) / onNear.w;
+    glm::vec3 const to   = glm::vec3(onFar) / onFar.w;
+
+    return { from, to - from };
+}
+
+// Six planes (xyz : inward normal, w : distance) extracted from a view-projection with [0, 1] depth
+struct Frustum
+{
+    enum Test
+    {
+        Outside,
+        Intersects,
+        Inside,
+    };
+
+    Frustum() = default;
+    explicit Frustum(glm::mat4 const &vp)
+    {
+        auto const row = [&](int i) { return glm::vec4(vp[0][i], vp[1][i], vp[2][i], vp[3][i]); };
+
+        planes[0] = row(3) + row(0);  // Left
+        planes[1] = row(3) - row(0);  // Right
+        planes[2] = row(3) + row(1);  // Bottom
+        planes[3] = row(3) - row(1);  // Top
+        planes[4] = row(2);           // Near
+        planes[5] = row(3) - row(2);  // Far
+
+        for (auto &p : planes) p /= glm::length(glm::vec3(p));
+    }
+
+    // Per plane, the box corner furthest along the normal decides 'outside' and the nearest one 'inside'
+    inline Test test(AABB const &box) const
+    {
+        Test result = Inside;
+
+        for (auto const &p : planes)
+        {
+            glm::vec3 const n  = glm::vec3(p);
+            glm::vec3 const pv = glm::mix(box.min, box.max, glm::greaterThanEqual(n, ZERO3));
+            glm::vec3 const nv = glm::mix(box.max, box.min, glm::greaterThanEqual(n, ZERO3));
+
+            if (glm::dot(n, pv) + p.w < 0.f)
+                return Outside;
+            if (glm::dot(n, nv) + p.w < 0.f)
+                result = Intersects;
+        }
+
+        return result;
+    }
+
+    std::array<glm::vec4, 6> planes = {};
+};
+
 }  // namespace math
 
 //=====================================
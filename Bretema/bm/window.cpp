@@ -74,6 +74,8 @@ Window::Window(i32 w, i32 h, std::string const &title, App *app) : mW(w), mH(h),
     // Window Events
     // -- Resize
     glfwSetFramebufferSizeCallback(mHandle, [](GLFWwindow *p, i32 w, i32 h) { SELF.size(w, h); });
+    // -- Damage (uncovered, restored...) : contents must be presented again
+    glfwSetWindowRefreshCallback(mHandle, [](GLFWwindow *p) { SELF.damage(); });
     // -- Focus
     glfwSetCursorEnterCallback(mHandle, [](GLFWwindow *p, i32 focus) { SELF.focus((bool)focus); });
     // -- On Close
@@ -112,6 +114,14 @@ void Window::waitEvents()
 {
     glfwWaitEvents();
 }
+void Window::waitEvents(double timeoutSecs)
+{
+    glfwWaitEventsTimeout(timeoutSecs);
+}
+void Window::wakeUp()
+{
+    glfwPostEmptyEvent();  // Thread-safe, unblocks 'waitEvents'
+}
 void Window::terminate()
 {
     sIsWindowContextInitialized = false;  // Ensures recreation of window-context after app/renderer 'cleanup'
@@ -28,6 +28,8 @@ public:
     void        destroy();
     static void pollEvents();
     static void waitEvents();
+    static void waitEvents(double timeoutSecs);
+    static void wakeUp();  // From any thread
     static void terminate();
 
     void *handle() const;
@@ -43,6 +45,10 @@ public:
     inline bool focus() { return mFocus; }
     inline void focus(bool f) { mFocus = f; }
 
+    // Set by the windowing system when the contents are lost (uncovered, restored), cleared on read
+    inline void damage() { mDamaged = true; }
+    inline bool consumeDamage() { return std::exchange(mDamaged, false); }
+
     static inline std::vector<char const *> extensions() { return sExtensions; }
 
 private:
@@ -56,7 +62,8 @@ private:
     std::string mTitle     = "";
     std::string mTitleInfo = "";
 
-    bool mFocus = false;
+    bool mFocus   = false;
+    bool mDamaged = true;
 
     static inline std::vector<char const *> sExtensions                 = {};
     static inline bool                      sIsWindowContextInitialized = false;
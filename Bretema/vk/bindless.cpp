@@ -0,0 +1,241 @@
+#include "bindless.hpp"
+#include "str.hpp"
+
+namespace bm::vk
+{
+
+//-----------------------------------------------------------------------------
+
+bool Bindless::requestFeatures(
+  VkPhysicalDeviceFeatures const         &available,
+  VkPhysicalDeviceVulkan12Features const &available12,
+  VkPhysicalDeviceFeatures               &enabled,
+  VkPhysicalDeviceVulkan12Features       &enabled12)
+{
+    bool const supported = available.shaderStorageBufferArrayDynamicIndexing          //  'uObjects[uConsts.objects]'
+                        && available12.descriptorIndexing                             //
+                        && available12.runtimeDescriptorArray                         //
+                        && available12.descriptorBindingPartiallyBound                //
+                        && available12.descriptorBindingUpdateUnusedWhilePending      //
+                        && available12.descriptorBindingStorageBufferUpdateAfterBind  //
+                        && available12.descriptorBindingSampledImageUpdateAfterBind   //
+                        && available12.shaderSampledImageArrayNonUniformIndexing;
+
+    if (!supported)
+        return false;
+
+    enabled.shaderStorageBufferArrayDynamicIndexing = VK_TRUE;
+
+    enabled12.descriptorIndexing                            = VK_TRUE;
+    enabled12.runtimeDescriptorArray                        = VK_TRUE;
+    enabled12.descriptorBindingPartiallyBound               = VK_TRUE;
+    enabled12.descriptorBindingUpdateUnusedWhilePending     = VK_TRUE;
+    enabled12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    enabled12.descriptorBindingSampledImageUpdateAfterBind  = VK_TRUE;
+    enabled12.shaderSampledImageArrayNonUniformIndexing     = VK_TRUE;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void Bindless::init(VkDevice device, VkPhysicalDevice gpu)
+{
+    BM_TRACE();
+
+    mDevice = device;
+
+    // Clamp our table sizes to what the device accepts on update-after-bind sets
+    VkPhysicalDeviceDescriptorIndexingProperties indexingProps = {};
+    indexingProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+    VkPhysicalDeviceProperties2 props2 = {};
+    props2.sType                       = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    props2.pNext                       = &indexingProps;
+    vkGetPhysicalDeviceProperties2(gpu, &props2);
+
+    auto const &P     = indexingProps;
+    mStorage.capacity = std::min({ sMaxStorage,
+                                   P.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                                   P.maxPerStageDescriptorUpdateAfterBindStorageBuffers });
+    mSampled.capacity = std::min({ sMaxSampled,
+                                   P.maxDescriptorSetUpdateAfterBindSampledImages,
+                                   P.maxPerStageDescriptorUpdateAfterBindSampledImages });
+
+    BM_INFOF("Bindless table => storage-buffers: {} | sampled-images: {}", mStorage.capacity, mSampled.capacity);
+
+    // LAYOUT
+    {
+        auto const stages = VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT;
+
+        auto const bindings = std::array {
+            VkDescriptorSetLayoutBinding { sStorageBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, mStorage.capacity, stages, nullptr },
+            VkDescriptorSetLayoutBinding { sSampledBinding, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, mSampled.capacity, stages, nullptr },
+        };
+
+        VkDescriptorBindingFlags const bindingFlag = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT            //
+                                                   | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT          //
+                                                   | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        auto const bindingFlags = std::array { bindingFlag, bindingFlag };
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo flagsCI = {};
+        flagsCI.sType                                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        flagsCI.bindingCount                                = (u32)bindingFlags.size();
+        flagsCI.pBindingFlags                               = bindingFlags.data();
+
+        VkDescriptorSetLayoutCreateInfo CI = {};
+        CI.sType                           = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        CI.pNext                           = &flagsCI;
+        CI.flags                           = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        CI.bindingCount                    = (u32)bindings.size();
+        CI.pBindings                       = bindings.data();
+
+        BMVK_CHECK(vkCreateDescriptorSetLayout(mDevice, &CI, nullptr, &mLayout));
+    }
+
+    // POOL
+    {
+        auto const sizes = std::array {
+            VkDescriptorPoolSize { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, mStorage.capacity },
+            VkDescriptorPoolSize { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, mSampled.capacity },
+        };
+
+        VkDescriptorPoolCreateInfo poolCI = {};
+        poolCI.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCI.flags                      = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+        poolCI.maxSets                    = 1;
+        poolCI.poolSizeCount              = (u32)sizes.size();
+        poolCI.pPoolSizes                 = sizes.data();
+
+        BMVK_CHECK(vkCreateDescriptorPool(mDevice, &poolCI, nullptr, &mPool));
+    }
+
+    // SET
+    {
+        VkDescriptorSetAllocateInfo allocInfo = {};
+        allocInfo.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool              = mPool;
+        allocInfo.descriptorSetCount          = 1;
+        allocInfo.pSetLayouts                 = &mLayout;
+
+        BMVK_CHECK(vkAllocateDescriptorSets(mDevice, &allocInfo, &mSet));
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void Bindless::cleanup()
+{
+    if (!mDevice)
+        return;
+
+    vkDestroyDescriptorPool(mDevice, mPool, nullptr);  // Also frees 'mSet'
+    vkDestroyDescriptorSetLayout(mDevice, mLayout, nullptr);
+
+    *this = {};
+}
+
+//-----------------------------------------------------------------------------
+
+u32 Bindless::addStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    u32 const idx = mStorage.acquire();
+
+    if (idx != sInvalid)
+        setStorageBuffer(idx, buffer, offset, range);
+    else
+        BM_ERRF("Bindless storage-buffer table is full ({})", mStorage.capacity);
+
+    return idx;
+}
+
+void Bindless::setStorageBuffer(u32 idx, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    BM_ASSERT(idx < mStorage.capacity);
+
+    VkDescriptorBufferInfo const info { buffer, offset, range };
+
+    VkWriteDescriptorSet write = {};
+    write.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet               = mSet;
+    write.dstBinding           = sStorageBinding;
+    write.dstArrayElement      = idx;
+    write.descriptorCount      = 1;
+    write.descriptorType       = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo          = &info;
+
+    vkUpdateDescriptorSets(mDevice, 1, &write, 0, nullptr);
+}
+
+void Bindless::removeStorageBuffer(u32 idx)
+{
+    // Partially-bound : a released slot can stay stale as long as no shader reads it
+    mStorage.release(idx);
+}
+
+//-----------------------------------------------------------------------------
+
+u32 Bindless::addSampledImage(VkImageView view, VkImageLayout layout)
+{
+    u32 const idx = mSampled.acquire();
+
+    if (idx != sInvalid)
+        setSampledImage(idx, view, layout);
+    else
+        BM_ERRF("Bindless sampled-image table is full ({})", mSampled.capacity);
+
+    return idx;
+}
+
+void Bindless::setSampledImage(u32 idx, VkImageView view, VkImageLayout layout)
+{
+    BM_ASSERT(idx < mSampled.capacity);
+
+    VkDescriptorImageInfo const info { VK_NULL_HANDLE, view, layout };
+
+    VkWriteDescriptorSet write = {};
+    write.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet               = mSet;
+    write.dstBinding           = sSampledBinding;
+    write.dstArrayElement      = idx;
+    write.descriptorCount      = 1;
+    write.descriptorType       = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    write.pImageInfo           = &info;
+
+    vkUpdateDescriptorSets(mDevice, 1, &write, 0, nullptr);
+}
+
+void Bindless::removeSampledImage(u32 idx)
+{
+    mSampled.release(idx);
+}
+
+//-----------------------------------------------------------------------------
+
+void Bindless::bind(VkCommandBuffer cmd, VkPipelineLayout layout, VkPipelineBindPoint bindPoint) const
+{
+    vkCmdBindDescriptorSets(cmd, bindPoint, layout, sSet, 1, &mSet, 0, nullptr);
+}
+
+//-----------------------------------------------------------------------------
+
+u32 Bindless::Slots::acquire()
+{
+    if (!free.empty())
+    {
+        u32 const idx = free.back();
+        free.pop_back();
+        return idx;
+    }
+
+    return next < capacity ? next++ : sInvalid;
+}
+
+void Bindless::Slots::release(u32 idx)
+{
+    if (idx < next)
+        free.push_back(idx);
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::vk
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "base.hpp"
+#include "types.hpp"
+
+#include "../bm/base.hpp"
+
+#include <vector>
+
+namespace bm::vk
+{
+
+//-----------------------------------------------------------------------------
+
+// One big 'update-after-bind' descriptor set shared by every pipeline.
+// Resources are registered once and shaders reach them by index (push-constants or instance data),
+// so nothing has to be re-bound between draws.
+// Scope : the per-frame object buffers and GPU culling's buffers and depth pyramid live here. Materials hold no data
+// besides their pipeline, so there is no material table : draws sharing a material are grouped by pipeline instead.
+class Bindless
+{
+public:
+    static constexpr u32 sSet            = 1;  // Set 0 is the per-frame global set (camera + scene)
+    static constexpr u32 sStorageBinding = 0;  // layout(set = 1, binding = 0) buffer ... []
+    static constexpr u32 sSampledBinding = 1;  // layout(set = 1, binding = 1) texture2D ... []
+    static constexpr u32 sMaxStorage     = 1u << 16;
+    static constexpr u32 sMaxSampled     = 1u << 16;
+    static constexpr u32 sInvalid        = ~0u;
+
+    // Fill 'enabled' with the subset of 'available' features that bindless needs, false if something is missing.
+    // Core ones too : shaders pick their storage buffer from the table by a push-constant index
+    static bool requestFeatures(
+      VkPhysicalDeviceFeatures const         &available,
+      VkPhysicalDeviceVulkan12Features const &available12,
+      VkPhysicalDeviceFeatures               &enabled,
+      VkPhysicalDeviceVulkan12Features       &enabled12);
+
+    void init(VkDevice device, VkPhysicalDevice gpu);
+    void cleanup();
+
+    u32  addStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+    void setStorageBuffer(u32 idx, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+    void removeStorageBuffer(u32 idx);
+
+    u32  addSampledImage(VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    void setSampledImage(u32 idx, VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    void removeSampledImage(u32 idx);
+
+    void bind(VkCommandBuffer cmd, VkPipelineLayout layout, VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS) const;
+
+    inline bool                  isInitialized() const { return mSet != VK_NULL_HANDLE; }
+    inline VkDescriptorSetLayout layout() const { return mLayout; }
+    inline VkDescriptorSet       set() const { return mSet; }
+
+private:
+    struct Slots
+    {
+        u32              capacity = 0;
+        u32              next     = 0;   // First never-used slot
+        std::vector<u32> free     = {};  // Released slots, reused first
+
+        u32  acquire();
+        void release(u32 idx);
+    };
+
+    VkDevice              mDevice = VK_NULL_HANDLE;
+    VkDescriptorPool      mPool   = VK_NULL_HANDLE;
+    VkDescriptorSetLayout mLayout = VK_NULL_HANDLE;
+    VkDescriptorSet       mSet    = VK_NULL_HANDLE;
+
+    Slots mStorage = {};
+    Slots mSampled = {};
+};
+
+//-----------------------------------------------------------------------------
+
+// Push-constant block of the bindless pipelines, matches 'mesh_bindless.vert'
+struct BindlessConsts
+{
+    u32 objects = Bindless::sInvalid;  // Storage-buffer slot holding this frame's ModelData array
+};
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::vk
@@ -0,0 +1,405 @@
+#include "gpuCulling.hpp"
+#include "init.hpp"
+
+#include <bit>
+
+namespace bm::vk
+{
+
+//-----------------------------------------------------------------------------
+
+static constexpr VkDeviceSize sCommandStride = sizeof(VkDrawIndexedIndirectCommand);
+
+//-----------------------------------------------------------------------------
+
+bool GpuCulling::requestFeatures(VkPhysicalDeviceFeatures const &available, VkPhysicalDeviceFeatures &enabled)
+{
+    bool const supported = available.drawIndirectFirstInstance                 //  'firstInstance' is the object index
+                        && available.shaderStorageBufferArrayDynamicIndexing   //
+                        && available.shaderSampledImageArrayDynamicIndexing;
+
+    if (!supported)
+        return false;
+
+    enabled.drawIndirectFirstInstance               = VK_TRUE;
+    enabled.shaderStorageBufferArrayDynamicIndexing = VK_TRUE;
+    enabled.shaderSampledImageArrayDynamicIndexing  = VK_TRUE;
+    enabled.multiDrawIndirect                       = available.multiDrawIndirect;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void GpuCulling::init(VkDevice device, VmaAllocator allocator, LayoutCache &layouts, Bindless &bindless, Timeline &timeline, u32 maxDrawCount)
+{
+    BM_TRACE();
+
+    mDevice       = device;
+    mAllocator    = allocator;
+    mBindless     = &bindless;
+    mTimeline     = &timeline;
+    mMaxDrawCount = std::max(maxDrawCount, 1u);
+
+    auto const  hzbCode  = Create::ShaderCode("hzb", VK_SHADER_STAGE_COMPUTE_BIT);
+    auto const  cullCode = Create::ShaderCode("cull", VK_SHADER_STAGE_COMPUTE_BIT);
+    auto const &hzb      = ShaderReflection::get(hzbCode);
+    auto const &cull     = ShaderReflection::get(cullCode);
+
+    BM_ASSERT_X(cull.pushConstants == sizeof(Consts), "'cull.comp' push-constants don't match GpuCulling::Consts");
+
+    mPyramidSetLayout = layouts.descSetLayout({ &hzb }, 0);
+    mPyramidLayout    = layouts.pipelineLayout({ &hzb });
+    mCullLayout       = layouts.pipelineLayout({ &cull }, { { Bindless::sSet, bindless.layout() } });
+
+    auto const hzbModule = Create::ShaderModule(mDevice, hzbCode);
+    BM_DEFER(vkDestroyShaderModule(mDevice, hzbModule, nullptr));
+    auto const cullModule = Create::ShaderModule(mDevice, cullCode);
+    BM_DEFER(vkDestroyShaderModule(mDevice, cullModule, nullptr));
+
+    mPyramidPipeline = Create::ComputePipeline(mDevice, hzbModule, mPyramidLayout);
+    mCullPipeline    = Create::ComputePipeline(mDevice, cullModule, mCullLayout);
+}
+
+//-----------------------------------------------------------------------------
+
+void GpuCulling::cleanup()
+{
+    if (!mDevice)
+        return;
+
+    if (mPyramid)
+        destroyPyramid(*mPyramid);
+
+    if (mVisibilityIdx != Bindless::sInvalid)
+        mBindless->removeStorageBuffer(mVisibilityIdx);
+    if (mCommandsIdx != Bindless::sInvalid)
+        mBindless->removeStorageBuffer(mCommandsIdx);
+
+    vmaDestroyBuffer(mAllocator, mVisibility.buffer, mVisibility.allocation);
+    vmaDestroyBuffer(mAllocator, mCommands.buffer, mCommands.allocation);
+
+    vkDestroyPipeline(mDevice, mPyramidPipeline, nullptr);
+    vkDestroyPipeline(mDevice, mCullPipeline, nullptr);
+
+    *this = {};
+}
+
+//-----------------------------------------------------------------------------
+
+void GpuCulling::begin(VkCommandBuffer cmd, u32 count, bool reset, VkImage depth, VkImageView depthView, VkExtent2D extent)
+{
+    if (!mPyramid || mPyramid->depthView != depthView)
+        createPyramid(depth, depthView, extent);
+
+    // Nothing drawn last frame : the early phase draws nothing and the late one everything that isn't culled
+    if (reserve(count) || reset)
+        vkCmdFillBuffer(cmd, mVisibility.buffer, 0, VK_WHOLE_SIZE, 0u);
+}
+
+//-----------------------------------------------------------------------------
+
+bool GpuCulling::reserve(u32 count)
+{
+    static constexpr u32 sMinObjects = 1024;
+
+    if (count <= mCapacity)
+        return false;
+
+    // Frames in flight may still be reading them
+    auto const retire = [this](AllocatedBuffer old, u32 idx)
+    {
+        if (!old.buffer)
+            return;
+
+        mTimeline->retire(
+          mTimeline->last() + 1,
+          [=, this]()
+          {
+              vmaDestroyBuffer(mAllocator, old.buffer, old.allocation);
+              mBindless->removeStorageBuffer(idx);
+          });
+    };
+
+    retire(mVisibility, mVisibilityIdx);
+    retire(mCommands, mCommandsIdx);
+
+    mCapacity = std::max({ count, mCapacity * 2, sMinObjects });
+
+    auto const create = [this](VkDeviceSize bytes, VkBufferUsageFlags usage)
+    {
+        VkBufferCreateInfo info = {};
+        info.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        info.size               = bytes;
+        info.usage              = usage;
+        info.sharingMode        = VK_SHARING_MODE_EXCLUSIVE;  // Graphics queue only
+
+        VmaAllocationCreateInfo allocInfo = {};
+        allocInfo.usage                   = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+
+        AllocatedBuffer b;
+        BMVK_CHECK(vmaCreateBuffer(mAllocator, &info, &allocInfo, &b.buffer, &b.allocation, nullptr));
+        return b;
+    };
+
+    mVisibility = create(sizeof(u32) * mCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    mCommands   = create(sCommandStride * mCapacity * 2, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+
+    // New slots instead of rewriting the old ones, pending frames keep reading what they were recorded with
+    mVisibilityIdx = mBindless->addStorageBuffer(mVisibility.buffer);
+    mCommandsIdx   = mBindless->addStorageBuffer(mCommands.buffer);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void GpuCulling::createPyramid(VkImage depth, VkImageView depthView, VkExtent2D extent)
+{
+    BM_TRACE();
+
+    if (mPyramid)
+        mTimeline->retire(mTimeline->last() + 1, [this, old = std::move(mPyramid)]() mutable { destroyPyramid(*old); });
+
+    auto P = sNew<Pyramid>();
+
+    // Level 0 is the power of two just below the depth buffer, so every level halves the previous one exactly
+    P->extent    = { std::bit_floor(std::max(extent.width, 1u)), std::bit_floor(std::max(extent.height, 1u)) };
+    P->levels    = (u32)std::bit_width(std::max(P->extent.width, P->extent.height));
+    P->depth     = depth;
+    P->depthView = depthView;
+
+    // IMAGE
+    {
+        auto const usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        auto       info  = vk::CreateInfo::Image(sFormat, usage, { P->extent.width, P->extent.height, 1 });
+        info.mipLevels   = P->levels;
+
+        VmaAllocationCreateInfo allocInfo = {};
+        allocInfo.usage                   = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+
+        BMVK_CHECK(vmaCreateImage(mAllocator, &info, &allocInfo, &P->image.image, &P->image.allocation, nullptr));
+
+        auto viewInfo                        = vk::CreateInfo::ImageView(sFormat, P->image.image, VK_IMAGE_ASPECT_COLOR_BIT);
+        viewInfo.subresourceRange.levelCount = P->levels;
+        BMVK_CHECK(vkCreateImageView(mDevice, &viewInfo, nullptr, &P->view));
+
+        P->mips.resize(P->levels);
+        viewInfo.subresourceRange.levelCount = 1;
+
+        for (u32 level = 0; level < P->levels; ++level)
+        {
+            viewInfo.subresourceRange.baseMipLevel = level;
+            BMVK_CHECK(vkCreateImageView(mDevice, &viewInfo, nullptr, &P->mips[level]));
+        }
+    }
+
+    // DESCRIPTORS : one set per level, the image never leaves GENERAL
+    {
+        auto const sizes = std::array {
+            VkDescriptorPoolSize { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, P->levels },
+            VkDescriptorPoolSize { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, P->levels },
+        };
+
+        VkDescriptorPoolCreateInfo poolCI = {};
+        poolCI.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCI.maxSets                    = P->levels;
+        poolCI.poolSizeCount              = (u32)sizes.size();
+        poolCI.pPoolSizes                 = sizes.data();
+        BMVK_CHECK(vkCreateDescriptorPool(mDevice, &poolCI, nullptr, &P->pool));
+
+        std::vector<VkDescriptorSetLayout> const layouts(P->levels, mPyramidSetLayout);
+
+        VkDescriptorSetAllocateInfo allocInfo = {};
+        allocInfo.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool              = P->pool;
+        allocInfo.descriptorSetCount          = P->levels;
+        allocInfo.pSetLayouts                 = layouts.data();
+
+        P->sets.resize(P->levels);
+        BMVK_CHECK(vkAllocateDescriptorSets(mDevice, &allocInfo, P->sets.data()));
+
+        std::vector<VkDescriptorImageInfo> infos;
+        std::vector<VkWriteDescriptorSet>  writes;
+        infos.reserve(P->levels * 2);  // Writes point into it
+
+        auto const write = [&](VkDescriptorSet set, u32 binding, VkDescriptorType type, VkImageView view, VkImageLayout layout)
+        {
+            infos.push_back({ VK_NULL_HANDLE, view, layout });
+
+            VkWriteDescriptorSet W = {};
+            W.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            W.dstSet               = set;
+            W.dstBinding           = binding;
+            W.descriptorCount      = 1;
+            W.descriptorType       = type;
+            W.pImageInfo           = &infos.back();
+            writes.push_back(W);
+        };
+
+        for (u32 level = 0; level < P->levels; ++level)
+        {
+            if (level == 0)
+                write(P->sets[level], 0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, depthView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+            else
+                write(P->sets[level], 0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, P->mips[level - 1], VK_IMAGE_LAYOUT_GENERAL);
+
+            write(P->sets[level], 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, P->mips[level], VK_IMAGE_LAYOUT_GENERAL);
+        }
+
+        vkUpdateDescriptorSets(mDevice, (u32)writes.size(), writes.data(), 0, nullptr);
+    }
+
+    // A new slot, the old one may still be read by frames in flight
+    P->slot = mBindless->addSampledImage(P->view, VK_IMAGE_LAYOUT_GENERAL);
+
+    BM_INFOF("HZB : {}x{}, {} levels", P->extent.width, P->extent.height, P->levels);
+
+    mPyramid = std::move(P);
+}
+
+//-----------------------------------------------------------------------------
+
+void GpuCulling::destroyPyramid(Pyramid &P)
+{
+    mBindless->removeSampledImage(P.slot);
+
+    vkDestroyDescriptorPool(mDevice, P.pool, nullptr);  // Also frees the sets
+    for (auto const view : P.mips) vkDestroyImageView(mDevice, view, nullptr);
+    vkDestroyImageView(mDevice, P.view, nullptr);
+    vmaDestroyImage(mAllocator, P.image.image, P.image.allocation);
+
+    P = {};
+}
+
+//-----------------------------------------------------------------------------
+
+void GpuCulling::cull(VkCommandBuffer cmd, Phase phase, glm::mat4 const &viewproj, u32 objects, u32 count)
+{
+    BM_ASSERT(mPyramid && count <= mCapacity);
+
+    // Visibility bits come from the clear or the previous late phase, commands may still be read by previous draws
+    VkMemoryBarrier before = {};
+    before.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    before.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    before.dstAccessMask   = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+      cmd,
+      VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      0,
+      1,
+      &before,
+      0,
+      nullptr,
+      0,
+      nullptr);
+
+    Consts consts     = {};
+    consts.viewproj   = viewproj;
+    consts.objects    = objects;
+    consts.visibility = mVisibilityIdx;
+    consts.commands   = mCommandsIdx;
+    consts.hzb        = mPyramid->slot;
+    consts.count      = count;
+    consts.capacity   = mCapacity;
+    consts.phase      = phase;
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, mCullPipeline);
+    mBindless->bind(cmd, mCullLayout, VK_PIPELINE_BIND_POINT_COMPUTE);
+    vkCmdPushConstants(cmd, mCullLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Consts), &consts);
+    vkCmdDispatch(cmd, (count + 63) / 64, 1, 1);
+
+    VkMemoryBarrier after = {};
+    after.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    after.srcAccessMask   = VK_ACCESS_SHADER_WRITE_BIT;
+    after.dstAccessMask   = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(
+      cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &after, 0, nullptr, 0, nullptr);
+}
+
+//-----------------------------------------------------------------------------
+
+void GpuCulling::buildPyramid(VkCommandBuffer cmd)
+{
+    BM_ASSERT(mPyramid);
+
+    auto const &P = *mPyramid;
+
+    // Depth : from the early draws to a sampled read. Pyramid : its previous contents (and readers) are discarded
+    VkImageMemoryBarrier toRead        = {};
+    toRead.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toRead.srcAccessMask               = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    toRead.dstAccessMask               = VK_ACCESS_SHADER_READ_BIT;
+    toRead.oldLayout                   = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    toRead.newLayout                   = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+    toRead.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    toRead.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    toRead.image                       = P.depth;
+    toRead.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    toRead.subresourceRange.levelCount = 1;
+    toRead.subresourceRange.layerCount = 1;
+
+    VkImageMemoryBarrier toWrite        = toRead;
+    toWrite.srcAccessMask               = VK_ACCESS_SHADER_READ_BIT;
+    toWrite.dstAccessMask               = VK_ACCESS_SHADER_WRITE_BIT;
+    toWrite.oldLayout                   = VK_IMAGE_LAYOUT_UNDEFINED;
+    toWrite.newLayout                   = VK_IMAGE_LAYOUT_GENERAL;
+    toWrite.image                       = P.image.image;
+    toWrite.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    toWrite.subresourceRange.levelCount = P.levels;
+
+    auto const barriers = std::array { toRead, toWrite };
+
+    vkCmdPipelineBarrier(
+      cmd,
+      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      (u32)barriers.size(),
+      barriers.data());
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, mPyramidPipeline);
+
+    // Each level reads the previous one : wait for it in between, the last wait covers the late cull
+    VkMemoryBarrier levelDone = {};
+    levelDone.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    levelDone.srcAccessMask   = VK_ACCESS_SHADER_WRITE_BIT;
+    levelDone.dstAccessMask   = VK_ACCESS_SHADER_READ_BIT;
+
+    for (u32 level = 0; level < P.levels; ++level)
+    {
+        u32 const w = std::max(P.extent.width >> level, 1u);
+        u32 const h = std::max(P.extent.height >> level, 1u);
+
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, mPyramidLayout, 0, 1, &P.sets[level], 0, nullptr);
+        vkCmdDispatch(cmd, (w + 7) / 8, (h + 7) / 8, 1);
+        vkCmdPipelineBarrier(
+          cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &levelDone, 0, nullptr, 0, nullptr);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+u32 GpuCulling::draw(VkCommandBuffer cmd, Phase phase, Batch const &batch) const
+{
+    VkDeviceSize const offset = (VkDeviceSize(phase) * mCapacity + batch.first) * sCommandStride;
+
+    u32 calls = 0;
+
+    for (u32 done = 0; done < batch.count; done += mMaxDrawCount, ++calls)
+    {
+        u32 const n = std::min(mMaxDrawCount, batch.count - done);
+        vkCmdDrawIndexedIndirect(cmd, mCommands.buffer, offset + done * sCommandStride, n, (u32)sCommandStride);
+    }
+
+    return calls;
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::vk
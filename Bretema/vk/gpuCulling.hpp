@@ -0,0 +1,138 @@
+#pragma once
+
+#include "base.hpp"
+#include "types.hpp"
+#include "bindless.hpp"
+#include "reflect.hpp"
+#include "timeline.hpp"
+
+#include "../bm/base.hpp"
+#include "../bm/utils.hpp"
+
+#include <vma/vk_mem_alloc.h>
+
+#include <vector>
+
+namespace bm::vk
+{
+
+//-----------------------------------------------------------------------------
+
+// Two-phase occlusion culling on the GPU against a hierarchical depth buffer (HZB), the CPU never reads anything back.
+//  - 'cull(Early)' : objects visible last frame that are still inside the frustum become the early draws.
+//  - Once those are rendered 'buildPyramid' reduces their depth into the HZB, farthest depth per texel and level.
+//  - 'cull(Late)' : every object inside the frustum is tested against the HZB, its visibility bit is rewritten and
+//    the ones that weren't drawn early become the late draws, rendered on top of the early ones.
+// There is one indexed-indirect command per object (its packed position) and phase, 'instanceCount' is 0 or 1.
+// Visibility bits live on the GPU and persist between frames, 'begin' clears them when the object set changes.
+class GpuCulling
+{
+public:
+    enum Phase : u32
+    {
+        Early = 0,
+        Late  = 1,
+    };
+
+    // Per object input of 'cull.comp', world bounds and what its command draws
+    struct Object
+    {
+        glm::vec3 min        = {};
+        u32       indexCount = 0;
+        glm::vec3 max        = {};
+        u32       pad        = 0;
+    };
+
+    // Consecutive objects (packed positions) drawn with the same mesh and pipeline : one indirect call per phase
+    struct Batch
+    {
+        u32         first    = 0;
+        u32         count    = 0;
+        Mesh const *mesh     = nullptr;
+        VkPipeline  pipeline = VK_NULL_HANDLE;
+    };
+
+    // Fill 'enabled' with the core features the indirect draws and shaders need, false if something is missing.
+    // 'multiDrawIndirect' is optional : without it every command is its own call
+    static bool requestFeatures(VkPhysicalDeviceFeatures const &available, VkPhysicalDeviceFeatures &enabled);
+
+    // 'timeline' is the graphics one, what gets replaced mid-session is destroyed once it reaches the current frame.
+    // 'maxDrawCount' : commands per indirect call, 1 without 'multiDrawIndirect'
+    void init(VkDevice device, VmaAllocator allocator, LayoutCache &layouts, Bindless &bindless, Timeline &timeline, u32 maxDrawCount);
+    void cleanup();
+
+    // Before anything else on the frame, outside any render pass : grows the buffers to 'count' objects and clears
+    // the visibility bits if 'reset' or they were reallocated. (Re)creates the pyramid when the depth target changed
+    void begin(VkCommandBuffer cmd, u32 count, bool reset, VkImage depth, VkImageView depthView, VkExtent2D extent);
+
+    // 'objects' : bindless slot of this frame's 'Object' array, 'count' entries
+    void cull(VkCommandBuffer cmd, Phase phase, glm::mat4 const &viewproj, u32 objects, u32 count);
+
+    // Between both phases, outside any render pass : reads the depth left by the early draws, which must be on
+    // DEPTH_STENCIL_ATTACHMENT_OPTIMAL, and leaves it on DEPTH_STENCIL_READ_ONLY_OPTIMAL
+    void buildPyramid(VkCommandBuffer cmd);
+
+    // Records the commands of 'batch' for 'phase', pipeline and mesh must already be bound. Returns the calls issued
+    u32 draw(VkCommandBuffer cmd, Phase phase, Batch const &batch) const;
+
+    inline bool isInitialized() const { return mDevice != VK_NULL_HANDLE; }
+    inline u32  levels() const { return mPyramid ? mPyramid->levels : 0; }
+
+private:
+    static constexpr VkFormat sFormat = VK_FORMAT_R32_SFLOAT;
+
+    // Push-constant block of 'cull.comp'
+    struct Consts
+    {
+        glm::mat4 viewproj   = glm::mat4 { 1.f };
+        u32       objects    = Bindless::sInvalid;
+        u32       visibility = Bindless::sInvalid;
+        u32       commands   = Bindless::sInvalid;
+        u32       hzb        = Bindless::sInvalid;
+        u32       count      = 0;
+        u32       capacity   = 0;  // Commands per phase
+        u32       phase      = Early;
+    };
+
+    struct Pyramid
+    {
+        AllocatedImage               image     = {};
+        VkImageView                  view      = VK_NULL_HANDLE;  // Every level, what 'cull.comp' reads
+        std::vector<VkImageView>     mips      = {};              // One level each, what 'hzb.comp' writes and reads
+        VkDescriptorPool             pool      = VK_NULL_HANDLE;
+        std::vector<VkDescriptorSet> sets      = {};  // Per level : previous level (or depth) -> this one
+        u32                          levels    = 0;
+        VkExtent2D                   extent    = {};  // Of level 0, powers of two
+        VkImage                      depth     = VK_NULL_HANDLE;
+        VkImageView                  depthView = VK_NULL_HANDLE;
+        u32                          slot      = Bindless::sInvalid;
+    };
+
+    void createPyramid(VkImage depth, VkImageView depthView, VkExtent2D extent);
+    void destroyPyramid(Pyramid &pyramid);
+    bool reserve(u32 count);  // True when the buffers were reallocated
+
+    VkDevice     mDevice       = VK_NULL_HANDLE;
+    VmaAllocator mAllocator    = VK_NULL_HANDLE;
+    Bindless    *mBindless     = nullptr;
+    Timeline    *mTimeline     = nullptr;
+    u32          mMaxDrawCount = 1;
+
+    VkDescriptorSetLayout mPyramidSetLayout = VK_NULL_HANDLE;  // Owned by the layout-cache, like both pipeline layouts
+    VkPipelineLayout      mPyramidLayout    = VK_NULL_HANDLE;
+    VkPipelineLayout      mCullLayout       = VK_NULL_HANDLE;
+    VkPipeline            mPyramidPipeline  = VK_NULL_HANDLE;
+    VkPipeline            mCullPipeline     = VK_NULL_HANDLE;
+
+    sPtr<Pyramid> mPyramid = nullptr;
+
+    u32             mCapacity      = 0;
+    AllocatedBuffer mVisibility    = {};  // u32 per object, device local
+    AllocatedBuffer mCommands      = {};  // 'mCapacity' commands per phase, device local
+    u32             mVisibilityIdx = Bindless::sInvalid;
+    u32             mCommandsIdx   = Bindless::sInvalid;
+};
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::vk
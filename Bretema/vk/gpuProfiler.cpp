@@ -0,0 +1,218 @@
+#include "gpuProfiler.hpp"
+#include "init.hpp"
+#include "str.hpp"
+
+namespace bm::vk
+{
+
+//-----------------------------------------------------------------------------
+
+static constexpr VkQueryPipelineStatisticFlags sStatFlags = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+                                                          | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+                                                          | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+//-----------------------------------------------------------------------------
+
+void GpuProfiler::init(VkDevice device, VkPhysicalDevice gpu, u32 queueFamily, u32 slots, bool statistics)
+{
+    BM_TRACE();
+
+    mDevice     = device;
+    mStatistics = statistics;
+
+    // Timestamps need a queue that supports them and a known tick period
+    VkPhysicalDeviceProperties props = {};
+    vkGetPhysicalDeviceProperties(gpu, &props);
+
+    u32 familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &familyCount, families.data());
+
+    u32 const validBits = queueFamily < familyCount ? families[queueFamily].timestampValidBits : 0;
+
+    mEnabled   = validBits > 0 && props.limits.timestampPeriod > 0.f;
+    mPeriodNs  = props.limits.timestampPeriod;
+    mValidMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    if (!mEnabled)
+    {
+        BM_WARN("GPU timestamps not supported on the graphics queue, GPU profiler disabled");
+        return;
+    }
+
+    mSlots.resize(slots);
+
+    for (auto &slot : mSlots)
+    {
+        VkQueryPoolCreateInfo tsCI = {};
+        tsCI.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        tsCI.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+        tsCI.queryCount            = sMaxScopes * 2;
+        BMVK_CHECK(vkCreateQueryPool(mDevice, &tsCI, nullptr, &slot.timestamps));
+
+        if (mStatistics)
+        {
+            VkQueryPoolCreateInfo statCI = {};
+            statCI.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            statCI.queryType             = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            statCI.queryCount            = sMaxScopes;
+            statCI.pipelineStatistics    = sStatFlags;
+            BMVK_CHECK(vkCreateQueryPool(mDevice, &statCI, nullptr, &slot.statistics));
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void GpuProfiler::cleanup()
+{
+    if (!mDevice)
+        return;
+
+    for (auto &slot : mSlots)
+    {
+        vkDestroyQueryPool(mDevice, slot.timestamps, nullptr);
+        vkDestroyQueryPool(mDevice, slot.statistics, nullptr);
+    }
+
+    *this = {};
+}
+
+//-----------------------------------------------------------------------------
+
+void GpuProfiler::beginFrame(VkCommandBuffer cmd, u32 slotIdx)
+{
+    if (!mEnabled)
+        return;
+
+    BM_ASSERT(slotIdx < mSlots.size());
+
+    mCurrent   = slotIdx;
+    mDepth     = 0;
+    auto &slot = mSlots[slotIdx];
+
+    // The slot's previous frame is done (its timeline value was waited before recording) : read, don't wait
+    collect(slot);
+
+    vkCmdResetQueryPool(cmd, slot.timestamps, 0, sMaxScopes * 2);
+    if (slot.statistics)
+        vkCmdResetQueryPool(cmd, slot.statistics, 0, sMaxScopes);
+}
+
+//-----------------------------------------------------------------------------
+
+u32 GpuProfiler::begin(VkCommandBuffer cmd, char const *name, bool withStats)
+{
+    if (!mEnabled || mCurrent == sInvalid)
+        return sInvalid;
+
+    auto &slot = mSlots[mCurrent];
+    u32   id   = (u32)slot.scopes.size();
+
+    if (id >= sMaxScopes)
+    {
+        BM_WARNF("GPU profiler : more than {} scopes per frame, '{}' ignored", sMaxScopes, name);
+        return sInvalid;
+    }
+
+    withStats = withStats && slot.statistics;
+
+    slot.scopes.push_back({ name, mDepth++ });
+    slot.withStats.push_back(withStats);
+
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot.timestamps, id * 2);
+    if (withStats)
+        vkCmdBeginQuery(cmd, slot.statistics, id, 0);
+
+    return id;
+}
+
+//-----------------------------------------------------------------------------
+
+void GpuProfiler::end(VkCommandBuffer cmd, u32 id)
+{
+    if (id == sInvalid)
+        return;
+
+    auto &slot = mSlots[mCurrent];
+    BM_ASSERT(id < slot.scopes.size());
+
+    if (slot.withStats[id])
+        vkCmdEndQuery(cmd, slot.statistics, id);
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slot.timestamps, id * 2 + 1);
+
+    mDepth = mDepth > 0 ? mDepth - 1 : 0;
+}
+
+//-----------------------------------------------------------------------------
+
+double GpuProfiler::ms(std::string_view name) const
+{
+    for (auto const &R : mResults)
+        if (std::string_view(R.name) == name)
+            return R.ms;
+
+    return 0.0;
+}
+
+//-----------------------------------------------------------------------------
+
+void GpuProfiler::collect(Slot &slot)
+{
+    u32 const count = (u32)slot.scopes.size();
+
+    if (count == 0)
+        return;
+
+    BM_DEFER(slot.scopes.clear(); slot.withStats.clear());
+
+    // Timestamps : [begin, end] pairs of u64
+    std::array<u64, sMaxScopes * 2> ticks = {};
+
+    auto const res = vkGetQueryPoolResults(
+      mDevice, slot.timestamps, 0, count * 2, sizeof(u64) * count * 2, ticks.data(), sizeof(u64), VK_QUERY_RESULT_64_BIT);
+
+    if (res == VK_NOT_READY)
+        return;  // Keep the last results rather than blocking
+    BMVK_CHECK(res);
+
+    // Statistics : one query holds the enabled counters in bit order (vertex, clipping, fragment)
+    std::array<std::array<u64, 3>, sMaxScopes> stats = {};
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        if (!slot.withStats[i])
+            continue;
+
+        auto const statRes = vkGetQueryPoolResults(
+          mDevice, slot.statistics, i, 1, sizeof(stats[i]), stats[i].data(), sizeof(stats[i]), VK_QUERY_RESULT_64_BIT);
+
+        if (statRes == VK_SUCCESS)
+            slot.scopes[i].hasStats = true;
+    }
+
+    mResults.clear();
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        auto &R = slot.scopes[i];
+
+        u64 const begin = ticks[i * 2] & mValidMask;
+        u64 const end   = ticks[i * 2 + 1] & mValidMask;
+        R.ms            = double((end - begin) & mValidMask) * mPeriodNs * 1e-6;
+
+        if (R.hasStats)
+        {
+            R.vertices   = stats[i][0];
+            R.primitives = stats[i][1];
+            R.fragments  = stats[i][2];
+        }
+
+        mResults.push_back(std::move(R));
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::vk
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "base.hpp"
+#include "types.hpp"
+
+#include "../bm/base.hpp"
+#include "../bm/utils.hpp"
+
+#include <string_view>
+#include <vector>
+
+namespace bm::vk
+{
+
+//-----------------------------------------------------------------------------
+
+// Named GPU scopes measured with timestamp pairs (and optionally pipeline statistics).
+// Every frame-slot owns its query pools : results are fetched when the slot comes back around, after its
+// timeline value was already waited, so reading them never stalls.
+class GpuProfiler
+{
+public:
+    static constexpr u32 sMaxScopes = 32;  // Per frame
+    static constexpr u32 sInvalid   = ~0u;
+
+    struct Result
+    {
+        char const *name       = "";     // As given to 'begin', readers build strings from it if they need them
+        u32         depth      = 0;      // Nesting level, 0 : outermost
+        double      ms         = 0.0;    // GPU time between both timestamps
+        bool        hasStats   = false;  // Counters below are meaningful
+        u64         vertices   = 0;      // Vertex shader invocations
+        u64         fragments  = 0;      // Fragment shader invocations
+        u64         primitives = 0;      // Primitives that reached the rasterizer (clipping output)
+    };
+
+    // 'statistics' : the device enabled 'pipelineStatisticsQuery'
+    void init(VkDevice device, VkPhysicalDevice gpu, u32 queueFamily, u32 slots, bool statistics);
+    void cleanup();
+
+    // Collects 'slot' results from its previous use and resets its queries, outside any render pass
+    void beginFrame(VkCommandBuffer cmd, u32 slot);
+
+    // Scopes nest, pipeline statistics can't : at most one 'withStats' scope open at a time.
+    // 'name' is kept as is until the results are replaced, it must outlive them (string literals do)
+    u32  begin(VkCommandBuffer cmd, char const *name, bool withStats = false);
+    void end(VkCommandBuffer cmd, u32 scope);
+
+    inline bool                       isEnabled() const { return mEnabled; }
+    inline std::vector<Result> const &results() const { return mResults; }  // Of the last collected frame
+    double                            ms(std::string_view name) const;      // 0 if the scope wasn't there
+
+    // RAII helper : 'GpuProfiler::Scope _ { profiler, cmd, "Shadows" };'
+    struct Scope
+    {
+        Scope(GpuProfiler &p, VkCommandBuffer cmd, char const *name, bool withStats = false)
+          : profiler(p)
+          , cmd(cmd)
+          , id(p.begin(cmd, name, withStats))
+        {
+        }
+        ~Scope() { profiler.end(cmd, id); }
+
+        GpuProfiler    &profiler;
+        VkCommandBuffer cmd;
+        u32             id;
+    };
+
+private:
+    struct Slot
+    {
+        VkQueryPool timestamps = VK_NULL_HANDLE;  // 2 per scope : begin + end
+        VkQueryPool statistics = VK_NULL_HANDLE;  // 1 per scope, only used by 'withStats' ones
+
+        std::vector<Result> scopes    = {};  // Recorded ones, pending to be resolved
+        std::vector<bool>   withStats = {};
+    };
+
+    void collect(Slot &slot);
+
+    VkDevice mDevice     = VK_NULL_HANDLE;
+    bool     mEnabled    = false;
+    bool     mStatistics = false;
+    double   mPeriodNs   = 1.0;  // Nanoseconds per timestamp tick
+    u64      mValidMask  = ~0ull;
+
+    std::vector<Slot>   mSlots   = {};
+    u32                 mCurrent = sInvalid;
+    u32                 mDepth   = 0;
+    std::vector<Result> mResults = {};
+};
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::vk
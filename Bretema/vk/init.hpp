@@ -229,7 +229,7 @@ inline auto
 namespace Create
 {
 
-inline VkShaderModule ShaderModule(VkDevice device, std::string const &name, VkShaderStageFlagBits stage)
+inline std::string ShaderCode(std::string const &name, VkShaderStageFlagBits stage)
 {
     static umap<VkShaderStageFlagBits, std::string> sStageToExt {
         { VK_SHADER_STAGE_VERTEX_BIT, "vert" },
@@ -249,13 +249,13 @@ inline VkShaderModule ShaderModule(VkDevice device, std::string const &name, VkS
     if (sStageToExt.count(stage) < 1)
     {
         BM_ERR("Shaders support is limited to: .vert, .frag and .comp");
-        return VK_NULL_HANDLE;
+        return "";
     }
 
     if (name.empty())
     {
         BM_ERR("Shader name cannot be empty");
-        return VK_NULL_HANDLE;
+        return "";
     }
 
     std::string const path = sShadersPath + name + "." + sStageToExt[stage] + ".spv";
@@ -265,9 +265,16 @@ inline VkShaderModule ShaderModule(VkDevice device, std::string const &name, VkS
     {
         BM_ERRF("Failed to open shader '{}'!", path);
         BM_ASSERT(0);
-        return {};
     }
 
+    return code;
+}
+
+inline VkShaderModule ShaderModule(VkDevice device, std::string const &code)
+{
+    if (code.empty())
+        return VK_NULL_HANDLE;
+
     VkShaderModuleCreateInfo info {};
     info.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
     info.pNext    = nullptr;
@@ -281,7 +288,17 @@ inline VkShaderModule ShaderModule(VkDevice device, std::string const &name, VkS
     return shaderModule;
 }
 
-inline VkPipeline Pipeline(vk::PipelineBuilder pb, VkDevice device, VkRenderPass pass, std::vector<VkDynamicState> dynamicStates)
+inline VkShaderModule ShaderModule(VkDevice device, std::string const &name, VkShaderStageFlagBits stage)
+{
+    return ShaderModule(device, ShaderCode(name, stage));
+}
+
+inline VkPipeline Pipeline(
+  vk::PipelineBuilder         pb,
+  VkDevice                    device,
+  VkRenderPass                pass,
+  std::vector<VkDynamicState> dynamicStates,
+  VkPipelineCache             cache = VK_NULL_HANDLE)
 {
     VkPipelineDynamicStateCreateInfo dynamicState {};
     dynamicState.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
@@ -331,7 +348,7 @@ inline VkPipeline Pipeline(vk::PipelineBuilder pb, VkDevice device, VkRenderPass
     // it's easy to error out on create graphics pipeline, so we handle it a bit better than the common BMVK_CHECK case
     VkPipeline pipeline;
 
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &info, nullptr, &pipeline) != VK_SUCCESS)
+    if (vkCreateGraphicsPipelines(device, cache, 1, &info, nullptr, &pipeline) != VK_SUCCESS)
     {
         BM_ERR("Couldn't create pipeline");
         return VK_NULL_HANDLE;
@@ -340,6 +357,25 @@ inline VkPipeline Pipeline(vk::PipelineBuilder pb, VkDevice device, VkRenderPass
     return pipeline;
 }
 
+inline VkPipeline ComputePipeline(VkDevice device, VkShaderModule module, VkPipelineLayout layout, VkPipelineCache cache = VK_NULL_HANDLE)
+{
+    VkComputePipelineCreateInfo info {};
+    info.sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    info.pNext  = nullptr;
+    info.stage  = CreateInfo::PipelineShaderStage(VK_SHADER_STAGE_COMPUTE_BIT, module);
+    info.layout = layout;
+
+    VkPipeline pipeline;
+
+    if (vkCreateComputePipelines(device, cache, 1, &info, nullptr, &pipeline) != VK_SUCCESS)
+    {
+        BM_ERR("Couldn't create compute pipeline");
+        return VK_NULL_HANDLE;
+    }
+
+    return pipeline;
+}
+
 struct DescSetLayoutBinding_t
 {
     VkDescriptorType   type    = VK_DESCRIPTOR_TYPE_MAX_ENUM;
@@ -0,0 +1,76 @@
+#include "permutation.hpp"
+#include "init.hpp"
+#include "str.hpp"
+
+namespace bm::vk
+{
+
+//-----------------------------------------------------------------------------
+
+void PermutationCache::init(VkDevice device, VkRenderPass pass, PipelineBuilder const &pb, std::vector<VkDynamicState> dynamicStates)
+{
+    mDevice        = device;
+    mPass          = pass;
+    mBuilder       = pb;
+    mDynamicStates = std::move(dynamicStates);
+
+    VkPipelineCacheCreateInfo cacheCI = {};
+    cacheCI.sType                     = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    BMVK_CHECK(vkCreatePipelineCache(mDevice, &cacheCI, nullptr, &mDriverCache));
+}
+
+//-----------------------------------------------------------------------------
+
+void PermutationCache::cleanup()
+{
+    if (!mDevice)
+        return;
+
+    for (auto const &[features, pipeline] : mPipelines)
+        if (pipeline)
+            vkDestroyPipeline(mDevice, pipeline, nullptr);
+
+    for (auto const &stage : mBuilder.shaderStages) vkDestroyShaderModule(mDevice, stage.module, nullptr);
+
+    vkDestroyPipelineCache(mDevice, mDriverCache, nullptr);
+
+    *this = {};
+}
+
+//-----------------------------------------------------------------------------
+
+VkPipeline PermutationCache::get(u32 features)
+{
+    features &= ShaderFeature::All;
+
+    if (auto const it = mPipelines.find(features); it != mPipelines.end())
+        return it->second;
+
+    // One boolean constant per feature bit, ids a shader doesn't declare are simply ignored
+    std::array<VkBool32, ShaderFeature::Count>                 values  = {};
+    std::array<VkSpecializationMapEntry, ShaderFeature::Count> entries = {};
+    for (u32 i = 0; i < ShaderFeature::Count; ++i)
+    {
+        values[i]  = (features & BM_BIT(i)) ? VK_TRUE : VK_FALSE;
+        entries[i] = { i, u32(i * sizeof(VkBool32)), sizeof(VkBool32) };
+    }
+
+    VkSpecializationInfo specInfo = {};
+    specInfo.mapEntryCount        = (u32)entries.size();
+    specInfo.pMapEntries          = entries.data();
+    specInfo.dataSize             = sizeof(values);
+    specInfo.pData                = values.data();
+
+    auto pb = mBuilder;
+    for (auto &stage : pb.shaderStages) stage.pSpecializationInfo = &specInfo;
+
+    auto const pipeline = vk::Create::Pipeline(pb, mDevice, mPass, mDynamicStates, mDriverCache);
+    BM_INFOF("Shader permutation {:#05b} compiled ({} cached)", features, mPipelines.size() + 1);
+
+    // Store failures too, so a broken variant logs once instead of once per draw
+    return mPipelines[features] = pipeline;
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::vk
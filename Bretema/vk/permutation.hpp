@@ -0,0 +1,54 @@
+#pragma once
+
+#include "base.hpp"
+#include "types.hpp"
+
+#include "../bm/base.hpp"
+#include "../bm/utils.hpp"
+
+#include <vector>
+
+namespace bm::vk
+{
+
+//-----------------------------------------------------------------------------
+
+// Compile-time toggles of the mesh shaders : bit 'N' feeds 'layout(constant_id = N)' on every stage
+struct ShaderFeature
+{
+    static constexpr u32 HasTangent = BM_BIT(0);  // The vertex stream carries authored tangents
+    static constexpr u32 Fog        = BM_BIT(1);  // SceneData fog terms are applied
+    static constexpr u32 Sun        = BM_BIT(2);  // SceneData sunlight terms are applied
+
+    static constexpr u32 Count = 3;
+    static constexpr u32 All   = BM_BIT(Count) - 1;
+};
+
+//-----------------------------------------------------------------------------
+
+// Specialized variants of one pipeline, created on first use and cached by feature bits.
+// The driver folds the disabled branches away, so shaders don't pay uniform branches per pixel.
+class PermutationCache
+{
+public:
+    // Takes ownership of the shader modules referenced by 'pb'
+    void init(VkDevice device, VkRenderPass pass, PipelineBuilder const &pb, std::vector<VkDynamicState> dynamicStates);
+    void cleanup();
+
+    VkPipeline get(u32 features);
+
+    inline size_t size() const { return mPipelines.size(); }
+
+private:
+    VkDevice                    mDevice        = VK_NULL_HANDLE;
+    VkRenderPass                mPass          = VK_NULL_HANDLE;
+    VkPipelineCache             mDriverCache   = VK_NULL_HANDLE;  // Variants share most of their compiled code
+    PipelineBuilder             mBuilder       = {};
+    std::vector<VkDynamicState> mDynamicStates = {};
+
+    umap<u32, VkPipeline> mPipelines = {};
+};
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::vk
@@ -0,0 +1,589 @@
+#include "reflect.hpp"
+
+#include <mutex>
+
+namespace bm::vk
+{
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+
+// The handful of SPIR-V enums we need (values from the SPIR-V 1.x unified spec)
+namespace spv
+{
+u32 constexpr Magic = 0x07230203;
+
+enum Op : u32
+{
+    OpEntryPoint       = 15,
+    OpTypeBool         = 20,
+    OpTypeInt          = 21,
+    OpTypeFloat        = 22,
+    OpTypeVector       = 23,
+    OpTypeMatrix       = 24,
+    OpTypeImage        = 25,
+    OpTypeSampler      = 26,
+    OpTypeSampledImage = 27,
+    OpTypeArray        = 28,
+    OpTypeRuntimeArray = 29,
+    OpTypeStruct       = 30,
+    OpTypePointer      = 32,
+    OpConstant         = 43,
+    OpVariable         = 59,
+    OpDecorate         = 71,
+    OpMemberDecorate   = 72,
+};
+
+enum Decoration : u32
+{
+    Block         = 2,
+    BufferBlock   = 3,
+    ArrayStride   = 6,
+    MatrixStride  = 7,
+    BuiltIn       = 11,
+    Location      = 30,
+    Binding       = 33,
+    DescriptorSet = 34,
+    Offset        = 35,
+};
+
+enum StorageClass : u32
+{
+    UniformConstant = 0,
+    Input           = 1,
+    Uniform         = 2,
+    PushConstant    = 9,
+    StorageBuffer   = 12,
+};
+
+enum ExecutionModel : u32
+{
+    Vertex                 = 0,
+    TessellationControl    = 1,
+    TessellationEvaluation = 2,
+    Geometry               = 3,
+    Fragment               = 4,
+    GLCompute              = 5,
+};
+
+enum Dim : u32
+{
+    DimBuffer      = 5,
+    DimSubpassData = 6,
+};
+}  // namespace spv
+
+//-----------------------------------------------------------------------------
+
+// Everything we learn about a single SPIR-V <id>
+struct Id
+{
+    u32  op      = 0;
+    u32  type    = 0;  // Component, column, element or pointee type / Result type of constants and variables
+    u32  storage = 0;  // Storage class of pointers and variables
+    u32  width   = 0;  // Scalar bit-width
+    u32  count   = 0;  // Vector components / Matrix columns / Array length-<id>
+    u32  value   = 0;  // Low word of a constant
+    bool sign    = false;
+
+    u32 imageDim     = 0;
+    u32 imageSampled = 0;  // 1 : sampled, 2 : storage
+
+    std::vector<u32> members       = {};
+    std::vector<u32> memberOffsets = {};
+    std::vector<u32> memberStrides = {};  // Matrix-stride of matrix members
+
+    u32  set         = ~0u;
+    u32  binding     = ~0u;
+    u32  location    = ~0u;
+    u32  arrayStride = 0;
+    bool block       = false;
+    bool bufferBlock = false;
+    bool builtin     = false;
+};
+
+using Ids = std::vector<Id>;
+
+u64 fnv1a(void const *data, size_t bytes, u64 hash = 0xcbf29ce484222325ull)
+{
+    auto const *p = static_cast<u8 const *>(data);
+    for (size_t i = 0; i < bytes; ++i)
+    {
+        hash ^= p[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+template<typename T>
+u64 hashPod(T const &pod, u64 hash)
+{
+    return fnv1a(&pod, sizeof(T), hash);
+}
+
+VkShaderStageFlagBits toStage(u32 model)
+{
+    switch (model)
+    {
+        case spv::Vertex: return VK_SHADER_STAGE_VERTEX_BIT;
+        case spv::TessellationControl: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        case spv::TessellationEvaluation: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        case spv::Geometry: return VK_SHADER_STAGE_GEOMETRY_BIT;
+        case spv::Fragment: return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case spv::GLCompute: return VK_SHADER_STAGE_COMPUTE_BIT;
+        default: return VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM;
+    }
+}
+
+u32 sizeOf(Ids const &ids, u32 typeId, u32 matrixStride = 0)
+{
+    auto const &T = ids[typeId];
+
+    switch (T.op)
+    {
+        case spv::OpTypeBool: return 4;
+        case spv::OpTypeInt:
+        case spv::OpTypeFloat: return T.width / 8;
+        case spv::OpTypeVector: return T.count * sizeOf(ids, T.type);
+        case spv::OpTypeMatrix: return T.count * (matrixStride ? matrixStride : sizeOf(ids, T.type));
+        case spv::OpTypeArray:
+        {
+            u32 const len = ids[T.count].value;
+            return len * (T.arrayStride ? T.arrayStride : sizeOf(ids, T.type));
+        }
+        case spv::OpTypeStruct:
+        {
+            u32 size = 0;
+            for (size_t i = 0; i < T.members.size(); ++i)
+            {
+                u32 const offset = i < T.memberOffsets.size() ? T.memberOffsets[i] : size;
+                u32 const stride = i < T.memberStrides.size() ? T.memberStrides[i] : 0;
+                size             = std::max(size, offset + sizeOf(ids, T.members[i], stride));
+            }
+            return size;
+        }
+        default: return 0;  // Runtime arrays, opaque types...
+    }
+}
+
+VkDescriptorType toDescriptorType(Ids const &ids, u32 typeId, u32 storage)
+{
+    auto const &T = ids[typeId];
+
+    switch (T.op)
+    {
+        case spv::OpTypeStruct:
+            if (storage == spv::StorageBuffer || T.bufferBlock)
+                return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            return storage == spv::Uniform ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_MAX_ENUM;
+
+        case spv::OpTypeImage:
+            if (T.imageDim == spv::DimBuffer)
+                return T.imageSampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            if (T.imageDim == spv::DimSubpassData)
+                return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            return T.imageSampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+
+        case spv::OpTypeSampler: return VK_DESCRIPTOR_TYPE_SAMPLER;
+        case spv::OpTypeSampledImage: return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+        default: return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+    }
+}
+
+VkFormat toVertexFormat(Ids const &ids, u32 typeId)
+{
+    static VkFormat const sFloat[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+    static VkFormat const sSInt[]  = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+    static VkFormat const sUInt[]  = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+    auto const &T     = ids[typeId];
+    bool const  isVec = T.op == spv::OpTypeVector;
+    auto const &S     = isVec ? ids[T.type] : T;
+    u32 const   comps = isVec ? T.count : 1;
+    bool const  valid = S.width == 32 && comps >= 1 && comps <= 4;
+    bool const  isFlt = S.op == spv::OpTypeFloat;
+    bool const  isInt = S.op == spv::OpTypeInt;
+
+    if (!valid || (!isFlt && !isInt))
+        return VK_FORMAT_UNDEFINED;
+
+    return isFlt ? sFloat[comps - 1] : (S.sign ? sSInt[comps - 1] : sUInt[comps - 1]);
+}
+
+ShaderReflection reflect(ds::view<u32> code)
+{
+    ShaderReflection R;
+
+    if (code.size() < 5 || code[0] != spv::Magic)
+    {
+        BM_ERR("Invalid SPIR-V module, nothing to reflect");
+        return R;
+    }
+
+    Ids              ids(code[3]);  // Header word 3 : <id> bound
+    std::vector<u32> variables;
+
+    // 1. Gather types, constants, variables and decorations
+    for (size_t w = 5; w < code.size();)
+    {
+        u32 const  op    = code[w] & 0xFFFF;
+        u32 const  count = code[w] >> 16;
+        auto const arg   = [&](u32 i) { return code[w + i]; };
+
+        if (count == 0 || w + count > code.size())
+        {
+            BM_ERR("Malformed SPIR-V instruction stream");
+            return {};
+        }
+
+        switch (op)
+        {
+            case spv::OpEntryPoint:
+                if (R.stage == VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM)
+                    R.stage = toStage(arg(1));
+                break;
+
+            case spv::OpTypeBool:
+            case spv::OpTypeSampler:
+            case spv::OpTypeSampledImage: ids[arg(1)].op = op; break;
+
+            case spv::OpTypeInt:
+            case spv::OpTypeFloat:
+                ids[arg(1)].op    = op;
+                ids[arg(1)].width = arg(2);
+                ids[arg(1)].sign  = op == spv::OpTypeInt && arg(3) != 0;
+                break;
+
+            case spv::OpTypeVector:
+            case spv::OpTypeMatrix:
+            case spv::OpTypeArray:
+                ids[arg(1)].op    = op;
+                ids[arg(1)].type  = arg(2);
+                ids[arg(1)].count = arg(3);
+                break;
+
+            case spv::OpTypeRuntimeArray:
+                ids[arg(1)].op   = op;
+                ids[arg(1)].type = arg(2);
+                break;
+
+            case spv::OpTypeImage:
+                ids[arg(1)].op           = op;
+                ids[arg(1)].imageDim     = arg(3);
+                ids[arg(1)].imageSampled = arg(7);
+                break;
+
+            case spv::OpTypeStruct:
+                ids[arg(1)].op = op;
+                ids[arg(1)].members.assign(code.begin() + w + 2, code.begin() + w + count);
+                break;
+
+            case spv::OpTypePointer:
+                ids[arg(1)].op      = op;
+                ids[arg(1)].storage = arg(2);
+                ids[arg(1)].type    = arg(3);
+                break;
+
+            case spv::OpConstant:
+                ids[arg(2)].op    = op;
+                ids[arg(2)].type  = arg(1);
+                ids[arg(2)].value = arg(3);
+                break;
+
+            case spv::OpVariable:
+                ids[arg(2)].op      = op;
+                ids[arg(2)].type    = arg(1);
+                ids[arg(2)].storage = arg(3);
+                variables.push_back(arg(2));
+                break;
+
+            case spv::OpDecorate:
+            {
+                auto &D = ids[arg(1)];
+                switch (arg(2))
+                {
+                    case spv::Block: D.block = true; break;
+                    case spv::BufferBlock: D.bufferBlock = true; break;
+                    case spv::BuiltIn: D.builtin = true; break;
+                    case spv::ArrayStride: D.arrayStride = arg(3); break;
+                    case spv::Location: D.location = arg(3); break;
+                    case spv::Binding: D.binding = arg(3); break;
+                    case spv::DescriptorSet: D.set = arg(3); break;
+                }
+                break;
+            }
+
+            case spv::OpMemberDecorate:
+            {
+                auto     &D      = ids[arg(1)];
+                u32 const member = arg(2);
+                if (arg(3) == spv::Offset)
+                {
+                    D.memberOffsets.resize(std::max<size_t>(D.memberOffsets.size(), member + 1), 0);
+                    D.memberOffsets[member] = arg(4);
+                }
+                else if (arg(3) == spv::MatrixStride)
+                {
+                    D.memberStrides.resize(std::max<size_t>(D.memberStrides.size(), member + 1), 0);
+                    D.memberStrides[member] = arg(4);
+                }
+                else if (arg(3) == spv::BuiltIn)
+                {
+                    D.builtin = true;
+                }
+                break;
+            }
+        }
+
+        w += count;
+    }
+
+    // 2. Walk the global variables
+    struct Attribute
+    {
+        u32      location;
+        VkFormat format;
+        u32      size;
+    };
+    std::vector<Attribute> attributes;
+
+    for (u32 varId : variables)
+    {
+        auto const &var     = ids[varId];
+        u32 const   pointee = ids[var.type].type;
+
+        // Push-constants
+        if (var.storage == spv::PushConstant)
+        {
+            R.pushConstants = std::max(R.pushConstants, sizeOf(ids, pointee));
+            continue;
+        }
+
+        // Vertex input
+        if (var.storage == spv::Input)
+        {
+            bool const isUserInput = R.stage == VK_SHADER_STAGE_VERTEX_BIT && !var.builtin && var.location != ~0u;
+            if (isUserInput)
+                attributes.push_back({ var.location, toVertexFormat(ids, pointee), sizeOf(ids, pointee) });
+            continue;
+        }
+
+        // Descriptors
+        bool const isResource = var.storage == spv::UniformConstant || var.storage == spv::Uniform || var.storage == spv::StorageBuffer;
+        if (!isResource || var.binding == ~0u)
+            continue;
+
+        ShaderReflection::Binding B;
+        B.set     = var.set == ~0u ? 0 : var.set;
+        B.binding = var.binding;
+        B.stages  = R.stage;
+
+        u32 elem = pointee;
+        if (ids[elem].op == spv::OpTypeArray)
+        {
+            B.count = ids[ids[elem].count].value;
+            elem    = ids[elem].type;
+        }
+        else if (ids[elem].op == spv::OpTypeRuntimeArray)
+        {
+            B.count = 0;
+            elem    = ids[elem].type;
+        }
+
+        B.type = toDescriptorType(ids, elem, var.storage);
+        if (B.type == VK_DESCRIPTOR_TYPE_MAX_ENUM)
+        {
+            BM_WARNF("Unsupported resource at set={} binding={}, skipped", B.set, B.binding);
+            continue;
+        }
+
+        R.bindings.push_back(B);
+    }
+
+    std::sort(
+      R.bindings.begin(),
+      R.bindings.end(),
+      [](auto const &a, auto const &b) { return a.set != b.set ? a.set < b.set : a.binding < b.binding; });
+
+    // 3. Vertex input : tightly interleaved on binding 0, following the location order
+    if (!attributes.empty())
+    {
+        std::sort(attributes.begin(), attributes.end(), [](auto const &a, auto const &b) { return a.location < b.location; });
+
+        u32 offset = 0;
+        for (auto const &A : attributes)
+        {
+            R.vertexInput.attributes.push_back({ A.location, 0, A.format, offset });
+            offset += A.size;
+        }
+        R.vertexInput.bindings.push_back({ 0, offset, VK_VERTEX_INPUT_RATE_VERTEX });
+    }
+
+    return R;
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+ShaderReflection const &ShaderReflection::get(ds::view<u32> spirv)
+{
+    static std::mutex                  sMutex;
+    static umap<u64, ShaderReflection> sCache;
+
+    u64 const hash = fnv1a(spirv.data(), spirv.size_bytes());
+
+    std::scoped_lock lock { sMutex };
+
+    if (auto it = sCache.find(hash); it != sCache.end())
+        return it->second;
+
+    auto reflection = reflect(spirv);
+    reflection.hash = hash;
+
+    return sCache.emplace(hash, std::move(reflection)).first->second;
+}
+
+ShaderReflection const &ShaderReflection::get(std::string const &spirv)
+{
+    return get(ds::make_view(reinterpret_cast<u32 const *>(spirv.data()), spirv.size() / sizeof(u32)));
+}
+
+//-----------------------------------------------------------------------------
+
+void LayoutCache::init(VkDevice device)
+{
+    mDevice = device;
+}
+
+void LayoutCache::cleanup()
+{
+    for (auto &[_, L] : mPipelineLayouts) vkDestroyPipelineLayout(mDevice, L, nullptr);
+    for (auto &[_, L] : mSetLayouts) vkDestroyDescriptorSetLayout(mDevice, L, nullptr);
+
+    mPipelineLayouts.clear();
+    mSetLayouts.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+VkDescriptorSetLayout LayoutCache::descSetLayout(std::vector<ShaderReflection const *> const &stages, u32 set)
+{
+    // Merge the bindings of every stage : same slot, same type, stage flags are OR-ed
+    std::vector<VkDescriptorSetLayoutBinding> merged;
+
+    for (auto const *S : stages)
+    {
+        for (auto const &B : S->bindings)
+        {
+            if (B.set != set)
+                continue;
+
+            BM_ASSERT_X(B.count > 0, "Runtime-sized arrays need an external set-layout (see LayoutCache::Overrides)");
+
+            auto it = std::find_if(merged.begin(), merged.end(), [&](auto const &M) { return M.binding == B.binding; });
+            if (it == merged.end())
+            {
+                merged.push_back({ B.binding, B.type, std::max(B.count, 1u), B.stages, nullptr });
+                continue;
+            }
+
+            BM_ASSERT_X(it->descriptorType == B.type, "Shader stages disagree on a descriptor type");
+            it->stageFlags |= B.stages;
+        }
+    }
+
+    std::sort(merged.begin(), merged.end(), [](auto const &a, auto const &b) { return a.binding < b.binding; });
+
+    return descSetLayout(merged);
+}
+
+VkDescriptorSetLayout LayoutCache::descSetLayout(std::vector<VkDescriptorSetLayoutBinding> const &bindings)
+{
+    u64 key = hashPod(bindings.size(), 0xcbf29ce484222325ull);
+    for (auto const &B : bindings)
+    {
+        key = hashPod(B.binding, key);
+        key = hashPod(B.descriptorType, key);
+        key = hashPod(B.descriptorCount, key);
+        key = hashPod(B.stageFlags, key);
+    }
+
+    if (auto it = mSetLayouts.find(key); it != mSetLayouts.end())
+        return it->second;
+
+    VkDescriptorSetLayoutCreateInfo CI = {};
+    CI.sType                           = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    CI.bindingCount                    = (u32)bindings.size();
+    CI.pBindings                       = bindings.data();
+
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    BMVK_CHECK(vkCreateDescriptorSetLayout(mDevice, &CI, nullptr, &layout));
+
+    return mSetLayouts[key] = layout;
+}
+
+//-----------------------------------------------------------------------------
+
+VkPushConstantRange LayoutCache::pushConstantRange(std::vector<ShaderReflection const *> const &stages) const
+{
+    VkPushConstantRange range = { 0, 0, 0 };
+
+    for (auto const *S : stages)
+    {
+        if (S->pushConstants > 0)
+        {
+            range.stageFlags |= S->stage;
+            range.size = std::max(range.size, S->pushConstants);
+        }
+    }
+
+    return range;
+}
+
+//-----------------------------------------------------------------------------
+
+VkPipelineLayout LayoutCache::pipelineLayout(std::vector<ShaderReflection const *> const &stages, Overrides const &overrides)
+{
+    // Sets in use : from 0 up to the highest one any stage (or override) touches
+    i32 lastSet = -1;
+    for (auto const *S : stages)
+        for (auto const &B : S->bindings) lastSet = std::max(lastSet, (i32)B.set);
+    for (auto const &[set, _] : overrides) lastSet = std::max(lastSet, (i32)set);
+
+    std::vector<VkDescriptorSetLayout> setLayouts;
+    for (i32 set = 0; set <= lastSet; ++set)
+    {
+        auto it = std::find_if(overrides.begin(), overrides.end(), [&](auto const &O) { return O.first == (u32)set; });
+        setLayouts.push_back(it != overrides.end() ? it->second : descSetLayout(stages, (u32)set));
+    }
+
+    auto const push = pushConstantRange(stages);
+
+    u64 key = hashPod(setLayouts.size(), 0xcbf29ce484222325ull);
+    for (auto const L : setLayouts) key = hashPod(L, key);
+    key = hashPod(push.stageFlags, key);
+    key = hashPod(push.size, key);
+
+    if (auto it = mPipelineLayouts.find(key); it != mPipelineLayouts.end())
+        return it->second;
+
+    auto info                   = VkPipelineLayoutCreateInfo {};
+    info.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    info.setLayoutCount         = (u32)setLayouts.size();
+    info.pSetLayouts            = setLayouts.data();
+    info.pushConstantRangeCount = push.size > 0 ? 1 : 0;
+    info.pPushConstantRanges    = push.size > 0 ? &push : nullptr;
+
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    BMVK_CHECK(vkCreatePipelineLayout(mDevice, &info, nullptr, &layout));
+
+    return mPipelineLayouts[key] = layout;
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::vk
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "base.hpp"
+#include "types.hpp"
+
+#include "../bm/base.hpp"
+#include "../bm/utils.hpp"
+
+#include <vector>
+
+namespace bm::vk
+{
+
+//-----------------------------------------------------------------------------
+
+// What a compiled SPIR-V module expects from the pipeline, extracted from its decorations
+struct ShaderReflection
+{
+    struct Binding
+    {
+        u32                set     = 0;
+        u32                binding = 0;
+        VkDescriptorType   type    = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+        u32                count   = 1;  // 0 : runtime-sized array (bindless)
+        VkShaderStageFlags stages  = 0;
+    };
+
+    u64                    hash          = 0;  // Of the SPIR-V words, also the cache key
+    VkShaderStageFlagBits  stage         = VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM;
+    std::vector<Binding>   bindings      = {};  // Sorted by set, then binding
+    u32                    pushConstants = 0;   // Size in bytes of the push-constant block, 0 if none
+    VertexInputDescription vertexInput   = {};  // Vertex stage only : one interleaved binding, ordered by location
+
+    // Parse (or fetch from the cache) the reflection of a module, the returned reference is stable
+    static ShaderReflection const &get(ds::view<u32> spirv);
+    static ShaderReflection const &get(std::string const &spirv);
+};
+
+//-----------------------------------------------------------------------------
+
+// Owns every layout derived from reflection, identical requests share the same handle so pipelines stay
+// layout-compatible and descriptor sets survive pipeline switches
+class LayoutCache
+{
+public:
+    // Externally built set-layouts (e.g. the bindless set) that replace the reflected ones
+    using Overrides = std::vector<std::pair<u32, VkDescriptorSetLayout>>;
+
+    void init(VkDevice device);
+    void cleanup();
+
+    VkDescriptorSetLayout descSetLayout(std::vector<ShaderReflection const *> const &stages, u32 set);
+    VkDescriptorSetLayout descSetLayout(std::vector<VkDescriptorSetLayoutBinding> const &bindings);
+
+    VkPipelineLayout pipelineLayout(std::vector<ShaderReflection const *> const &stages, Overrides const &overrides = {});
+
+    VkPushConstantRange pushConstantRange(std::vector<ShaderReflection const *> const &stages) const;
+
+private:
+    VkDevice mDevice = VK_NULL_HANDLE;
+
+    umap<u64, VkDescriptorSetLayout> mSetLayouts      = {};
+    umap<u64, VkPipelineLayout>      mPipelineLayouts = {};
+};
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::vk
@@ -15,7 +15,35 @@ constexpr i32 BM_VK_MINOR_VERSION = 2;
 
 //-----------------------------------------------------------------------------
 
-Renderer::Renderer(sPtr<bm::Window> window) : bm::BaseRenderer(window)
+static VkPresentModeKHR toVk(PresentMode mode)
+{
+    switch (mode)
+    {
+        case PresentMode::Mailbox: return VK_PRESENT_MODE_MAILBOX_KHR;
+        case PresentMode::Immediate: return VK_PRESENT_MODE_IMMEDIATE_KHR;
+        default: return VK_PRESENT_MODE_FIFO_KHR;
+    }
+}
+
+static VkSampleCountFlagBits toVk(Samples samples)
+{
+    return static_cast<VkSampleCountFlagBits>(BM_BIT((i32)samples));
+}
+
+// Highest count on 'supported' that isn't above 'requested', MSAA goes up to x8
+static Samples clampSamples(Samples requested, VkSampleCountFlags supported)
+{
+    auto samples = std::min(requested, Samples::_8);
+
+    while (samples != Samples::_1 && !(supported & toVk(samples)))
+        samples = static_cast<Samples>((i32)samples - 1);
+
+    return samples;
+}
+
+//-----------------------------------------------------------------------------
+
+Renderer::Renderer(sPtr<bm::Window> window, RendererSettings settings) : bm::BaseRenderer(window, settings)
 {
     BM_TRACE();
 
@@ -41,39 +69,50 @@ Renderer::Renderer(sPtr<bm::Window> window) : bm::BaseRenderer(window)
 
 //-----------------------------------------------------------------------------
 
-void Renderer::draw(Camera const &cam)
+void Renderer::beginFrame()
 {
-    // bm::BaseRenderer::draw(cam);
+    bm::BaseRenderer::beginFrame();
 
-    // BM_TRACE();
+    // Low latency : don't let the CPU run frames ahead of the GPU, the input sampled after this returns is
+    // presented by the very next frame instead of waiting behind the ones already queued
+    BM_PROFILE_ZONE("WaitGpu");
+    u64 const value = mSettings.lowLatency ? mGraphicsTL.last() : frame().renderValue;
+    mGraphicsTL.wait(value, sOneSec);
+}
 
-    // Wait for GPU (1 second timeout)
-    BMVK_CHECK(vkWaitForFences(mDevice, 1, &frame().renderFence, true, sOneSec));
+//-----------------------------------------------------------------------------
 
-    // Request image from the swapchain (1 second timeout)
-    u32  swapchainImgIdx = 0;
-    auto resAcquire      = vkAcquireNextImageKHR(mDevice, mSwapchain, sOneSec, frame().presentSemaphore, nullptr, &swapchainImgIdx);
+void Renderer::draw(FrameSnapshot const &snap)
+{
+    // bm::BaseRenderer::draw(snap);
 
-    if (resAcquire == VK_ERROR_OUT_OF_DATE_KHR)
+    // BM_TRACE();
+
+    // Minimized : nothing to present to, the swapchain is rebuilt once the window has an area again
+    if (w() < 1 || h() < 1)
     {
-        recreateSwapchain();
+        mResizePending = true;
         return;
     }
-    else if (resAcquire != VK_SUCCESS && resAcquire != VK_SUBOPTIMAL_KHR)
+
+    // Debounce : while the user drags the compositor stretches the old images, rebuild once the size settles
+    if (mWindowSizeChanged)
     {
-        BM_ABORTF("{} : {}", bm::vk::str::Result.at(resAcquire), "vkAcquireNextImageKHR presentSemaphore");
+        mResizePending = true;
+        mResizeAt      = Clock::now();
     }
 
-    // Reset(s) on valid image
-    BMVK_CHECK(vkResetFences(mDevice, 1, &frame().renderFence));
-    BMVK_CHECK(vkResetCommandBuffer(frame().graphics.cmd, 0));
+    // Wait for GPU to be done with this frame slot (1 second timeout), a no-op if 'beginFrame' already did it
+    if (!mGraphicsTL.wait(frame().renderValue, sOneSec))
+    {
+        BM_WARNF("Frame {} still in flight after 1s, skipping", mFrameNumber);
+        requestRedraw();
+        return;
+    }
 
-    // Begin the command buffer recording.
-    // We will use this command buffer exactly once, so we want to let Vulkan know that
-    VkCommandBufferBeginInfo cbBeginInfo {};
-    cbBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    cbBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-    BMVK_CHECK(vkBeginCommandBuffer(frame().graphics.cmd, &cbBeginInfo));
+    // Release whatever the GPU has finished with (staging buffers, one-shot commands, ...)
+    mGraphicsTL.collect();
+    mTransferTL.collect();
 
     // Calculations...
     int const   frameIdx   = mFrameNumber % sFlightFrames;
@@ -95,12 +134,71 @@ void Renderer::draw(Camera const &cam)
 
     // Scene data stuff
     mSceneData.ambientColor = { frameSin01, 0.f, frameCos01, 1.f };
+
+    // Disabled fog/sun are baked into the pipeline variants instead of being branched on per pixel
+    mSceneFeatures = 0;
+    mSceneFeatures |= (mSceneData.fogDistances.y > mSceneData.fogDistances.x) ? ShaderFeature::Fog : 0u;
+    mSceneFeatures |= (mSceneData.sunlightDirection.w > 0.f) ? ShaderFeature::Sun : 0u;
     char *sceneData;
     vmaMapMemory(mAllocator, mSceneDataBuff.allocation, (void **)&sceneData);
     sceneData += mSceneDataPaddedSize * frameIdx;
     memcpy(sceneData, &mSceneData, sizeof(SceneData));
     vmaUnmapMemory(mAllocator, mSceneDataBuff.allocation);
 
+    // Low latency : record the scene before acquiring, so the (possibly blocking) acquire happens as late as
+    // possible and only a tiny primary command buffer is left to record once the image is ours
+    if (mSettings.lowLatency)
+    {
+        auto const cmd = frame().graphicsScene;
+        BMVK_CHECK(vkResetCommandBuffer(cmd, 0));
+
+        VkCommandBufferInheritanceInfo inheritance {};
+        inheritance.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance.renderPass  = mDefaultRenderPass;
+        inheritance.subpass     = 0;
+        inheritance.framebuffer = VK_NULL_HANDLE;  // Unknown until the image is acquired
+
+        VkCommandBufferBeginInfo sceneBeginInfo {};
+        sceneBeginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        sceneBeginInfo.flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        sceneBeginInfo.pInheritanceInfo = &inheritance;
+
+        BMVK_CHECK(vkBeginCommandBuffer(cmd, &sceneBeginInfo));
+        drawScene(snap, cmd);
+        BMVK_CHECK(vkEndCommandBuffer(cmd));
+    }
+
+    // Request image from the swapchain (1 second timeout), headless owns one target per frame slot instead
+    u32  swapchainImgIdx = (u32)frameIdx;
+    auto resAcquire      = headless() ? VK_SUCCESS
+                                      : vkAcquireNextImageKHR(mDevice, mSwapchain, sOneSec, frame().presentSemaphore, nullptr, &swapchainImgIdx);
+
+    if (resAcquire == VK_ERROR_OUT_OF_DATE_KHR)
+    {
+        recreateSwapchain();
+        requestRedraw();  // Nothing was presented
+        return;
+    }
+    else if (resAcquire != VK_SUCCESS && resAcquire != VK_SUBOPTIMAL_KHR)
+    {
+        BM_ABORTF("{} : {}", bm::vk::str::Result.at(resAcquire), "vkAcquireNextImageKHR presentSemaphore");
+    }
+
+    // Reset(s) on valid image
+    BMVK_CHECK(vkResetCommandBuffer(frame().graphics.cmd, 0));
+
+    // Begin the command buffer recording.
+    // We will use this command buffer exactly once, so we want to let Vulkan know that
+    VkCommandBufferBeginInfo cbBeginInfo {};
+    cbBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    cbBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    BMVK_CHECK(vkBeginCommandBuffer(frame().graphics.cmd, &cbBeginInfo));
+
+    // GPU timings : this slot's previous results are ready (its value was waited above), publish them
+    mGpuProfiler.beginFrame(frame().graphics.cmd, (u32)frameIdx);
+    mGpuFrameMs.store((float)mGpuProfiler.ms("Frame"), std::memory_order_relaxed);
+    u32 const frameScope = mGpuProfiler.begin(frame().graphics.cmd, "Frame");
+
     // Start the main renderpass.
     // We will use the clear color from above, and the framebuffer of the index the swapchain gave us
     VkRenderPassBeginInfo renderpassBI = {};
@@ -114,35 +212,64 @@ void Renderer::draw(Camera const &cam)
     renderpassBI.clearValueCount       = (u32)clears.size();
     renderpassBI.pClearValues          = clears.data();
 
-    vkCmdBeginRenderPass(frame().graphics.cmd, &renderpassBI, VK_SUBPASS_CONTENTS_INLINE);
-
     //===========
 
-    drawScene("test", cam);
+    if (mUseGpuCulling)
+    {
+        // Culling runs between two passes, so it records them itself
+        GpuProfiler::Scope _ { mGpuProfiler, frame().graphics.cmd, "Scene", true };
+        drawSceneTwoPhase(snap, frame().graphics.cmd, renderpassBI);
+    }
+    else
+    {
+        auto const contents = mSettings.lowLatency ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+        vkCmdBeginRenderPass(frame().graphics.cmd, &renderpassBI, contents);
+
+        {
+            // Statistics queries can't be inherited by the low-latency secondary, only timed there
+            GpuProfiler::Scope _ { mGpuProfiler, frame().graphics.cmd, "Scene", !mSettings.lowLatency };
+
+            if (mSettings.lowLatency)
+                vkCmdExecuteCommands(frame().graphics.cmd, 1, &frame().graphicsScene);
+            else
+                drawScene(snap, frame().graphics.cmd);
+        }
+
+        vkCmdEndRenderPass(frame().graphics.cmd);
+    }
 
     //===========
 
-    vkCmdEndRenderPass(frame().graphics.cmd);
+    mGpuProfiler.end(frame().graphics.cmd, frameScope);
     BMVK_CHECK(vkEndCommandBuffer(frame().graphics.cmd));
 
     // Prepare the submission to the queue.
     // We want to wait on the mPresentSemaphore, as that semaphore is signaled when the swapchain is ready
-    // we will signal the mRenderSemaphore, to signal that rendering has finished
-    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-
-    VkSubmitInfo submitInfo         = {};
-    submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.pNext                = nullptr;
-    submitInfo.pWaitDstStageMask    = &waitStage;
-    submitInfo.waitSemaphoreCount   = 1;
-    submitInfo.pWaitSemaphores      = &frame().presentSemaphore;
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores    = &frame().renderSemaphore;
-    submitInfo.commandBufferCount   = 1;
-    submitInfo.pCommandBuffers      = &frame().graphics.cmd;
-
-    BMVK_CHECK(vkQueueSubmit(mGraphics.queue, 1, &submitInfo, frame().renderFence));  // Submit and execute
-    // --> mRenderFence will now block until the graphic commands finish execution
+    // and on the transfer timeline, so pending uploads land before the vertex stage reads them.
+    // We will signal the mRenderSemaphore for present, and the next graphics-timeline value for this frame slot
+    frame().renderValue = mGraphicsTL.next();
+
+    Submission submission;
+    submission.cmd(frame().graphics.cmd);
+    submission.signal(mGraphicsTL, frame().renderValue);
+    if (!headless())
+    {
+        submission.wait(frame().presentSemaphore, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+        submission.signal(frame().renderSemaphore);
+    }
+    if (!mTransferTL.reached(mUploadsValue))
+        submission.wait(mTransferTL, mUploadsValue, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+
+    BMVK_CHECK(submission.submit(mGraphics.queue));  // Submit and execute
+
+    // Headless : nothing to present, the target stays on its slot until 'readback' asks for it
+    if (headless())
+    {
+        mLastTarget = swapchainImgIdx;
+        markPresented();
+        mFrameNumber++;
+        return;
+    }
 
     // This will put the image we just rendered into the visible window.
     // We want to wait on the mRenderSemaphore for that, as it's necessary that drawing commands have finished
@@ -156,19 +283,100 @@ void Renderer::draw(Camera const &cam)
     presentInfo.waitSemaphoreCount = 1;
     presentInfo.pImageIndices      = &swapchainImgIdx;
     auto resPresent                = vkQueuePresentKHR(mGraphics.queue, &presentInfo);
+    markPresented();
+
+    // Increase the number of frames drawn (the slot was submitted, whatever the present said)
+    mFrameNumber++;
 
-    if (resPresent == VK_ERROR_OUT_OF_DATE_KHR || resPresent == VK_SUBOPTIMAL_KHR || mWindowSizeChanged)
+    if (resPresent == VK_ERROR_OUT_OF_DATE_KHR)
     {
-        recreateSwapchain();
-        return;
+        recreateSwapchain();  // Can't present anymore, no point on waiting for the size to settle
+    }
+    else if (resPresent == VK_SUBOPTIMAL_KHR || resAcquire == VK_SUBOPTIMAL_KHR)
+    {
+        mResizePending = true;  // Still presentable, goes through the debounce
     }
     else if (resPresent != VK_SUCCESS)
     {
-        BM_ABORTF("{} : {}", bm::vk::str::Result.at(resAcquire), "vkQueuePresentKHR renderSemaphore");
+        BM_ABORTF("{} : {}", bm::vk::str::Result.at(resPresent), "vkQueuePresentKHR renderSemaphore");
     }
 
-    // Increase the number of frames drawn
-    mFrameNumber++;
+    if (mResizePending && Clock::now() - mResizeAt >= sResizeDebounce)
+        recreateSwapchain();
+
+    // On demand : keep frames coming until uploads land and the swapchain matches the window again
+    if (mResizePending || !mTransferTL.reached(mUploadsValue))
+        requestRedraw();
+}
+
+//-----------------------------------------------------------------------------
+
+std::vector<u8> Renderer::readback()
+{
+    BM_TRACE();
+
+    if (!headless() || mFrameNumber == 0)
+    {
+        BM_WARN("Readback is only available on headless mode, after drawing a frame");
+        return {};
+    }
+
+    auto const image = mSwapchainImages[mLastTarget];
+    u64 const  bytes = u64(extentW()) * extentH() * 4;
+
+    auto const host = createBuffer(
+      bytes,
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+      false);
+    BM_DEFER(vmaDestroyBuffer(mAllocator, host.buffer, host.allocation));
+
+    // Same queue as the frame, so submission order already puts the copy after it
+    executeImmediately(
+      frame().graphics.pool,
+      mGraphics.queue,
+      mGraphicsTL,
+      [&](VkCommandBuffer cmd)
+      {
+          // The render pass left the target on TRANSFER_SRC, only its writes have to be made visible
+          VkImageMemoryBarrier toCopy        = {};
+          toCopy.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+          toCopy.srcAccessMask               = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+          toCopy.dstAccessMask               = VK_ACCESS_TRANSFER_READ_BIT;
+          toCopy.oldLayout                   = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+          toCopy.newLayout                   = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+          toCopy.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+          toCopy.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+          toCopy.image                       = image;
+          toCopy.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+          toCopy.subresourceRange.levelCount = 1;
+          toCopy.subresourceRange.layerCount = 1;
+          vkCmdPipelineBarrier(
+            cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toCopy);
+
+          VkBufferImageCopy region           = {};
+          region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+          region.imageSubresource.layerCount = 1;
+          region.imageExtent                 = extent3D();
+          vkCmdCopyImageToBuffer(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, host.buffer, 1, &region);
+
+          VkMemoryBarrier toHost = {};
+          toHost.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+          toHost.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+          toHost.dstAccessMask   = VK_ACCESS_HOST_READ_BIT;
+          vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &toHost, 0, nullptr, 0, nullptr);
+      });
+
+    std::vector<u8> pixels(bytes);
+
+    void *data = nullptr;
+    BMVK_CHECK(vmaMapMemory(mAllocator, host.allocation, &data));
+    vmaInvalidateAllocation(mAllocator, host.allocation, 0, VK_WHOLE_SIZE);
+    memcpy(pixels.data(), data, bytes);
+    vmaUnmapMemory(mAllocator, host.allocation);
+
+    return pixels;
 }
 
 //-----------------------------------------------------------------------------
@@ -184,10 +392,9 @@ void Renderer::cleanup()
 
     vkDeviceWaitIdle(mDevice);
 
-    for (u64 i = 0; i < sFlightFrames; i++)
-    {
-        vkWaitForFences(mDevice, 1, &mFrames[i].renderFence, true, sOneSec * 4);
-    }
+    // Mesh buffers belong to the pool (replaced ones are retired by 'addMeshGroup'), the rest go with the queues
+    mMeshes.each([this](MeshHandle, Mesh &mesh) { destroyMeshBuffers(mesh.vertices, mesh.indices); });
+    mMeshes.clear();
 
     mDqMain.flush();
     mDqSwapchain.flush();
@@ -205,9 +412,23 @@ void Renderer::cleanup()
 void Renderer::recreateSwapchain()
 {
     BM_TRACE();
-    vkDeviceWaitIdle(mDevice);
-    mDqSwapchain.flush();
-    initSwapchain();
+    BM_PROFILE_ZONE("RecreateSwapchain");
+
+    if (w() < 1 || h() < 1)
+    {
+        mResizePending = true;  // Minimized, retried once the window has an area again
+        return;
+    }
+
+    mResizePending = false;
+
+    // The old swapchain, its views, depth and framebuffers may still be used by frames in flight : instead of
+    // stalling the whole device they are destroyed once the last submitted graphics work is done
+    auto const prev = mSwapchain;
+    mGraphicsTL.retire(mGraphicsTL.last(), [retired = std::move(mDqSwapchain)]() mutable { retired.flush(); });
+    mDqSwapchain = {};
+
+    initSwapchain(prev);  // 'prev' is retired by the driver but keeps presenting what it already has queued
     initFramebuffers();
 }
 
@@ -225,6 +446,9 @@ void Renderer::initVulkan()
         vkbInstanceBuilder.enable_extension(ext);
     }
 
+    // Headless : no surface extensions, so software ICDs without WSI (lavapipe on a server) are fine
+    vkbInstanceBuilder.set_headless(headless());
+
     auto vkbInstanceResult = vkbInstanceBuilder.set_app_name("Bretema Engine")
                                .request_validation_layers(true)
                                .require_api_version(BM_VK_VER, 0)
@@ -240,30 +464,87 @@ void Renderer::initVulkan()
     mDebugMessenger = vkbInstance.debug_messenger;
 
     // Surface : // @dani externalize this call ??
-    glfwCreateWindowSurface(mInstance, (GLFWwindow *)mWindow->handle(), nullptr, &mSurface);
+    if (!headless())
+        glfwCreateWindowSurface(mInstance, (GLFWwindow *)mWindow->handle(), nullptr, &mSurface);
 
-    // vkb : Select a GPU based on some criteria
+    // vkb : Select a GPU based on some criteria (a headless instance doesn't ask for present support)
     auto vkbGpuSelector = vkb::PhysicalDeviceSelector { vkbInstance };
-    auto vkbGpuResult   = vkbGpuSelector.set_minimum_version(BM_VK_VER).set_surface(mSurface).select();
+    if (mSurface)
+        vkbGpuSelector.set_surface(mSurface);
+    auto vkbGpuResult = vkbGpuSelector.set_minimum_version(BM_VK_VER).select();
     VKB_CHECK(vkbGpuResult);
     auto &vkbGpu = vkbGpuResult.value();
 
     // Physical Device  (GPU)
     mChosenGPU = vkbGpu.physical_device;
 
+    // Optional features : query what the GPU offers and only enable what we are going to use
+    VkPhysicalDeviceVulkan12Features available12 = {};
+    available12.sType                            = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    VkPhysicalDeviceFeatures2 available          = {};
+    available.sType                              = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    available.pNext                              = &available12;
+    vkGetPhysicalDeviceFeatures2(mChosenGPU, &available);
+
+    mFeatures12       = {};
+    mFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    // Timeline semaphores drive frame pacing, uploads and deferred deletion : not optional
+    if (!available12.timelineSemaphore)
+        BM_ABORT("Timeline semaphores are not supported by the GPU");
+    mFeatures12.timelineSemaphore = VK_TRUE;
+
+    // Pipeline statistics for the GPU profiler, timestamps alone work without it
+    if (available.features.pipelineStatisticsQuery)
+        vkbGpu.features.pipelineStatisticsQuery = VK_TRUE;
+
+    mUseBindless = mSettings.bindless && Bindless::requestFeatures(available.features, available12, vkbGpu.features, mFeatures12);
+    if (mSettings.bindless && !mUseBindless)
+        BM_WARN("Bindless mode requested but descriptor-indexing is not supported, using per-draw binds");
+
+    // GPU culling : indirect draws over the bindless object table, split around the pyramid so it can't be recorded
+    // into the single-pass low-latency secondary
+    mUseGpuCulling = mSettings.gpuCulling && mUseBindless && !mSettings.lowLatency
+                  && GpuCulling::requestFeatures(available.features, vkbGpu.features);
+    if (mSettings.gpuCulling && !mUseGpuCulling)
+        BM_WARN("GPU culling requested but it needs bindless, no low-latency mode and indirect draws, using CPU culling");
+
     // vkb : Create the final Vulkan device
     auto vkbDeviceBuilder = vkb::DeviceBuilder { vkbGpu };
+    vkbDeviceBuilder.add_pNext(&mFeatures12);
     auto vkbDeviceResult  = vkbDeviceBuilder.build();
     VKB_CHECK(vkbDeviceResult);
     auto &vkbDevice = vkbDeviceResult.value();
 
     // Device
-    mDevice     = vkbDevice.device;
-    mProperties = vkbDevice.physical_device.properties;
+    mDevice             = vkbDevice.device;
+    mProperties         = vkbDevice.physical_device.properties;
+    mPipelineStatistics = vkbGpu.features.pipelineStatisticsQuery;
+    mMultiDrawIndirect  = vkbGpu.features.multiDrawIndirect;
 
     // Initialize data dependant of device properties
     mSceneDataPaddedSize = paddedSizeUBO<SceneData>();
 
+    // MSAA : color and depth share the attachments' sample count. GPU culling reads single-sampled depth between its
+    // passes and needs the attachments stored across them, which is what the transient MSAA targets avoid
+    auto const &limits = mProperties.limits;
+    mSamples           = clampSamples(mSettings.msaa, limits.framebufferColorSampleCounts & limits.framebufferDepthSampleCounts);
+
+    if (msaa() && mUseGpuCulling)
+    {
+        BM_WARN("MSAA is not supported along with GPU culling, disabled");
+        mSamples = Samples::_1;
+    }
+    else if (mSamples != mSettings.msaa)
+    {
+        BM_WARNF("MSAA x{} requested, using x{}", BM_BIT((i32)mSettings.msaa), BM_BIT((i32)mSamples));
+    }
+
+    VkPhysicalDeviceMemoryProperties memory = {};
+    vkGetPhysicalDeviceMemoryProperties(mChosenGPU, &memory);
+    for (u32 i = 0; i < memory.memoryTypeCount; ++i)
+        mLazyMemory |= (memory.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+
     // Initialize the memory allocator
     VmaAllocatorCreateInfo allocatorInfo = {};
     allocatorInfo.physicalDevice         = mChosenGPU;
@@ -271,11 +552,15 @@ void Renderer::initVulkan()
     allocatorInfo.instance               = mInstance;
     vmaCreateAllocator(&allocatorInfo, &mAllocator);
 
-    // Queues
+    // Queues : without dedicated compute / transfer families everything goes through graphics
     mGraphics = vk::Queue { vkbDevice, vkb::QueueType::graphics };
-    mPresent  = vk::Queue { vkbDevice, vkb::QueueType::present };
-    mCompute  = vk::Queue { vkbDevice, vkb::QueueType::compute };
-    mTransfer = vk::Queue { vkbDevice, vkb::QueueType::transfer };
+    mPresent  = headless() ? mGraphics : vk::Queue { vkbDevice, vkb::QueueType::present };
+    mCompute  = vk::Queue { vkbDevice, vkb::QueueType::compute, false };
+    mTransfer = vk::Queue { vkbDevice, vkb::QueueType::transfer, false };
+    if (!mCompute.valid)
+        mCompute = mGraphics;
+    if (!mTransfer.valid)
+        mTransfer = mGraphics;
     BM_INFOF("G:{} | P:{} | C:{} | T:{}", mGraphics, mPresent, mCompute, mTransfer);
 }
 
@@ -289,54 +574,95 @@ void Renderer::initSwapchain(VkSwapchainKHR prev)
 
     // === SWAP CHAIN ===
 
-    // vkb : Create swapchain
-    auto vkbSwapchainBuilder = vkb::SwapchainBuilder { mChosenGPU, mDevice, mSurface };
-    auto vkbSwapchainResult  = vkbSwapchainBuilder.use_default_format_selection()
-                                .set_desired_present_mode(VK_PRESENT_MODE_FIFO_KHR)  // fifo = vsync present mode
-                                .set_desired_extent((u32)w(), (u32)h())
-                                .use_default_image_usage_flags()
-                                .set_desired_min_image_count(sInFlight)
-                                .set_old_swapchain(prev)
-                                .set_clipped(true)
-                                .build();
-
-    VKB_CHECK(vkbSwapchainResult);
-    auto &vkbSwapchain = vkbSwapchainResult.value();
-    mSwapchain         = vkbSwapchain.swapchain;
-    ADD_DESTROY_SWAPCHAIN(vkDestroySwapchainKHR(mDevice, mSwapchain, nullptr));
-
-    // Swapchain images
-    auto vkbSwapchainImagesResult = vkbSwapchain.get_images();
-    VKB_CHECK(vkbSwapchainImagesResult);
-    mSwapchainImages = vkbSwapchainImagesResult.value();
-
-    // Swapchain image-views
-    auto vkbSwapchainImageViewsResult = vkbSwapchain.get_image_views();
-    VKB_CHECK(vkbSwapchainImageViewsResult);
-    mSwapchainImageViews = vkbSwapchainImageViewsResult.value();
-
-    // Swapchain image-format and viewport
-    mSwapchainImageFormat = vkbSwapchain.image_format;
+    if (headless())
+    {
+        initOffscreenTargets();  // Plays the role of the swapchain images
+    }
+    else
+    {
+        // vkb : Create swapchain
+        auto vkbSwapchainBuilder = vkb::SwapchainBuilder { mChosenGPU, mDevice, mSurface };
+        auto vkbSwapchainResult  = vkbSwapchainBuilder.use_default_format_selection()
+                                    .set_desired_present_mode(toVk(mSettings.presentMode))
+                                    .add_fallback_present_mode(VK_PRESENT_MODE_FIFO_KHR)  // fifo = vsync, always available
+                                    .set_desired_extent((u32)w(), (u32)h())
+                                    .use_default_image_usage_flags()
+                                    .set_desired_min_image_count(sInFlight)
+                                    .set_old_swapchain(prev)
+                                    .set_clipped(true)
+                                    .build();
+
+        VKB_CHECK(vkbSwapchainResult);
+        auto &vkbSwapchain = vkbSwapchainResult.value();
+        mSwapchain         = vkbSwapchain.swapchain;
+        mSwapchainExtent   = vkbSwapchain.extent;
+        BM_INFOF("Present mode : {}", str::PresentMode.at(vkbSwapchain.present_mode));
+
+        // @note : Swapchain destroy-callbacks capture handles by value, they may run after a newer swapchain replaced them
+        auto const swapchain = mSwapchain;
+        ADD_DESTROY_SWAPCHAIN(vkDestroySwapchainKHR(mDevice, swapchain, nullptr));
+
+        // Swapchain images
+        auto vkbSwapchainImagesResult = vkbSwapchain.get_images();
+        VKB_CHECK(vkbSwapchainImagesResult);
+        mSwapchainImages = vkbSwapchainImagesResult.value();
+
+        // Swapchain image-views
+        auto vkbSwapchainImageViewsResult = vkbSwapchain.get_image_views();
+        VKB_CHECK(vkbSwapchainImageViewsResult);
+        mSwapchainImageViews = vkbSwapchainImageViewsResult.value();
+
+        // Swapchain image-format and viewport
+        mSwapchainImageFormat = vkbSwapchain.image_format;
+    }
 
     // === DEPTH BUFFER ===
 
-    static auto const depthBit = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-    auto const        imgInfo  = vk::CreateInfo::Image(sDepthFormat, depthBit, extent3D());
+    // GPU culling reduces it into the depth pyramid, with MSAA nothing reads it after the pass
+    VkImageUsageFlags depthUsage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    if (mUseGpuCulling)
+        depthUsage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (msaa())
+        depthUsage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+    createAttachment(sDepthFormat, depthUsage, VK_IMAGE_ASPECT_DEPTH_BIT, mDepthImage, mDepthImageView);
+
+    // === MSAA COLOR ===
+
+    // What gets drawn into, resolved into the swapchain image at the end of the pass
+    if (msaa())
+    {
+        auto const colorUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+        createAttachment(mSwapchainImageFormat, colorUsage, VK_IMAGE_ASPECT_COLOR_BIT, mColorImage, mColorImageView);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+void Renderer::createAttachment(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect, AllocatedImage &image, VkImageView &view)
+{
+    auto const imgInfo = vk::CreateInfo::Image(format, usage, extent3D(), mSamples);
 
-    // for the depth image, we want to allocate it from GPU local memory
+    // GPU local memory, transient attachments go to the lazily allocated kind when the device has it
     VmaAllocationCreateInfo imgAllocInfo = {};
     imgAllocInfo.usage                   = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
     imgAllocInfo.requiredFlags           = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
-    // allocate and create the image
-    vmaCreateImage(mAllocator, &imgInfo, &imgAllocInfo, &mDepthImage.image, &mDepthImage.allocation, nullptr);
-    ADD_DESTROY_SWAPCHAIN(vmaDestroyImage(mAllocator, mDepthImage.image, mDepthImage.allocation));
+    if (mLazyMemory && (usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT))
+    {
+        imgAllocInfo.usage         = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED;
+        imgAllocInfo.requiredFlags = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+    }
+
+    BMVK_CHECK(vmaCreateImage(mAllocator, &imgInfo, &imgAllocInfo, &image.image, &image.allocation, nullptr));
+    auto const created = image;
+    ADD_DESTROY_SWAPCHAIN(vmaDestroyImage(mAllocator, created.image, created.allocation));
 
-    // build an image-view for the depth image to use for rendering
-    auto const viewInfo = vk::CreateInfo::ImageView(sDepthFormat, mDepthImage.image, VK_IMAGE_ASPECT_DEPTH_BIT);
+    auto const viewInfo = vk::CreateInfo::ImageView(format, image.image, aspect);
 
-    BMVK_CHECK(vkCreateImageView(mDevice, &viewInfo, nullptr, &mDepthImageView));
-    ADD_DESTROY_SWAPCHAIN(vkDestroyImageView(mDevice, mDepthImageView, nullptr));
+    BMVK_CHECK(vkCreateImageView(mDevice, &viewInfo, nullptr, &view));
+    auto const createdView = view;
+    ADD_DESTROY_SWAPCHAIN(vkDestroyImageView(mDevice, createdView, nullptr));
 }
 
 //-----------------------------------------------------------------------------
@@ -366,6 +692,48 @@ void Renderer::initCommands()
         initCommandsByFamily(fd.present, &mPresent);
         initCommandsByFamily(fd.compute, &mCompute);
         initCommandsByFamily(fd.transfer, &mTransfer);
+
+        auto const sceneAllocInfo = vk::AllocInfo::CommandBuffer(fd.graphics.pool, 1, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+        BMVK_CHECK(vkAllocateCommandBuffers(mDevice, &sceneAllocInfo, &fd.graphicsScene));
+    }
+
+    // Query pools per frame-slot, recorded on the graphics command buffers
+    mGpuProfiler.init(mDevice, mChosenGPU, mGraphics.family, (u32)sFlightFrames, mPipelineStatistics);
+    ADD_DESTROY(mGpuProfiler.cleanup());
+}
+
+//-----------------------------------------------------------------------------
+
+void Renderer::initOffscreenTargets()
+{
+    BM_TRACE();
+
+    mSwapchain            = VK_NULL_HANDLE;
+    mSwapchainExtent      = { (u32)w(), (u32)h() };
+    mSwapchainImageFormat = sOffscreenFormat;
+    mSwapchainImages.clear();
+    mSwapchainImageViews.clear();
+
+    // One per frame in flight, so a slot never renders into an image a previous frame is still using
+    auto const usage   = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    auto const imgInfo = vk::CreateInfo::Image(mSwapchainImageFormat, usage, extent3D());
+
+    VmaAllocationCreateInfo imgAllocInfo = {};
+    imgAllocInfo.usage                   = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+
+    for (u64 i = 0; i < sFlightFrames; ++i)
+    {
+        AllocatedImage img = {};
+        BMVK_CHECK(vmaCreateImage(mAllocator, &imgInfo, &imgAllocInfo, &img.image, &img.allocation, nullptr));
+        ADD_DESTROY_SWAPCHAIN(vmaDestroyImage(mAllocator, img.image, img.allocation));
+
+        // Views are owned by 'initFramebuffers', like the swapchain ones
+        VkImageView view     = VK_NULL_HANDLE;
+        auto const  viewInfo = vk::CreateInfo::ImageView(mSwapchainImageFormat, img.image, VK_IMAGE_ASPECT_COLOR_BIT);
+        BMVK_CHECK(vkCreateImageView(mDevice, &viewInfo, nullptr, &view));
+
+        mSwapchainImages.push_back(img.image);
+        mSwapchainImageViews.push_back(view);
     }
 }
 
@@ -375,17 +743,21 @@ void Renderer::initDefaultRenderPass()
 {
     BM_TRACE();
 
+    // Ready to be read back / to display on renderpass end
+    auto const presentLayout = headless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
     // == ATTACHMENT(s) ==
-    // att0 : Color
+    // att0 : Color (the swapchain image, or the multisampled target resolved into it)
     VkAttachmentDescription color0  = {};
     color0.format                   = mSwapchainImageFormat;             // Copy swapchain format
-    color0.samples                  = VK_SAMPLE_COUNT_1_BIT;             // 1 sample, no MSAA right now
+    color0.samples                  = toVk(mSamples);                    // 1 sample unless MSAA
     color0.loadOp                   = VK_ATTACHMENT_LOAD_OP_CLEAR;       // Clear on load
-    color0.storeOp                  = VK_ATTACHMENT_STORE_OP_STORE;      // Keep stored on renderpass end
+    color0.storeOp                  = msaa() ? VK_ATTACHMENT_STORE_OP_DONT_CARE  // Only the resolve is kept
+                                             : VK_ATTACHMENT_STORE_OP_STORE;     // Keep stored on renderpass end
     color0.stencilLoadOp            = VK_ATTACHMENT_LOAD_OP_DONT_CARE;   // No stencil right now
     color0.stencilStoreOp           = VK_ATTACHMENT_STORE_OP_DONT_CARE;  // No stencil right now
     color0.initialLayout            = VK_IMAGE_LAYOUT_UNDEFINED;         // Let it as undefined on init
-    color0.finalLayout              = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;   // Ready to display on renderpass end
+    color0.finalLayout              = msaa() ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : presentLayout;
     VkAttachmentReference refColor0 = {};
     refColor0.attachment            = 0;  // Attachment idx in the renderpass
     refColor0.layout                = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
@@ -393,9 +765,9 @@ void Renderer::initDefaultRenderPass()
     VkAttachmentDescription depth0  = {};
     depth0.flags                    = 0;
     depth0.format                   = sDepthFormat;
-    depth0.samples                  = VK_SAMPLE_COUNT_1_BIT;
+    depth0.samples                  = toVk(mSamples);
     depth0.loadOp                   = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depth0.storeOp                  = VK_ATTACHMENT_STORE_OP_STORE;
+    depth0.storeOp                  = msaa() ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
     depth0.stencilLoadOp            = VK_ATTACHMENT_LOAD_OP_CLEAR;
     depth0.stencilStoreOp           = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     depth0.initialLayout            = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -403,12 +775,26 @@ void Renderer::initDefaultRenderPass()
     VkAttachmentReference refDepth0 = {};
     refDepth0.attachment            = 1;  // Attachment idx in the renderpass
     refDepth0.layout                = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    // att2 : MSAA resolve (the swapchain image), fully overwritten so nothing to load
+    VkAttachmentDescription resolve0  = {};
+    resolve0.format                   = mSwapchainImageFormat;
+    resolve0.samples                  = VK_SAMPLE_COUNT_1_BIT;
+    resolve0.loadOp                   = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    resolve0.storeOp                  = VK_ATTACHMENT_STORE_OP_STORE;
+    resolve0.stencilLoadOp            = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    resolve0.stencilStoreOp           = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    resolve0.initialLayout            = VK_IMAGE_LAYOUT_UNDEFINED;
+    resolve0.finalLayout              = presentLayout;
+    VkAttachmentReference refResolve0 = {};
+    refResolve0.attachment            = 2;  // Attachment idx in the renderpass
+    refResolve0.layout                = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
     // == SUBPASS(es) ==
     VkSubpassDescription subpass    = {};
     subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;  // Create the renderpass for graphics
     subpass.colorAttachmentCount    = 1;
     subpass.pColorAttachments       = &refColor0;
+    subpass.pResolveAttachments     = msaa() ? &refResolve0 : nullptr;
     subpass.pDepthStencilAttachment = &refDepth0;
 
     // == DEPENDENCIES ==
@@ -433,8 +819,8 @@ void Renderer::initDefaultRenderPass()
     VkRenderPassCreateInfo renderpassCI = {};
     renderpassCI.sType                  = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
     // att(s)
-    auto const atts                     = std::array { color0, depth0 };
-    renderpassCI.attachmentCount        = (u32)atts.size();
+    auto const atts                     = std::array { color0, depth0, resolve0 };
+    renderpassCI.attachmentCount        = msaa() ? 3 : 2;  // The resolve only exists with MSAA
     renderpassCI.pAttachments           = atts.data();
     // subpass(es)
     renderpassCI.subpassCount           = 1;
@@ -446,6 +832,33 @@ void Renderer::initDefaultRenderPass()
 
     BMVK_CHECK(vkCreateRenderPass(mDevice, &renderpassCI, nullptr, &mDefaultRenderPass));
     ADD_DESTROY(vkDestroyRenderPass(mDevice, mDefaultRenderPass, nullptr));
+
+    // == LOAD RENDER PASS ==
+    // GPU culling : the late draws go on top of the early ones, after the depth was read by the pyramid build.
+    // Same attachments, so it's compatible with the framebuffers and pipelines of the default one. Never multisampled
+    if (!mUseGpuCulling)
+        return;
+
+    BM_ASSERT(!msaa());
+
+    color0.loadOp        = VK_ATTACHMENT_LOAD_OP_LOAD;
+    color0.initialLayout = color0.finalLayout;
+    depth0.loadOp        = VK_ATTACHMENT_LOAD_OP_LOAD;
+    depth0.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+    depColor0.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    depColor0.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    depDepth0.srcStageMask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;  // The pyramid build is the last one reading it
+    depDepth0.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    auto const loadAtts = std::array { color0, depth0 };
+    auto const loadDeps = std::array { depColor0, depDepth0 };
+
+    renderpassCI.pAttachments  = loadAtts.data();
+    renderpassCI.pDependencies = loadDeps.data();
+
+    BMVK_CHECK(vkCreateRenderPass(mDevice, &renderpassCI, nullptr, &mLoadRenderPass));
+    ADD_DESTROY(vkDestroyRenderPass(mDevice, mLoadRenderPass, nullptr));
 }
 
 //-----------------------------------------------------------------------------
@@ -472,14 +885,18 @@ void Renderer::initFramebuffers()
     // Create framebuffers for each of the swapchain image views
     for (size_t i = 0; i < mSwapchainImages.size(); i++)
     {
-        auto const atts = std::array { mSwapchainImageViews[i], mDepthImageView };
+        // MSAA : every framebuffer draws into the same multisampled targets, the swapchain image is the resolve
+        auto const atts = msaa() ? std::array { mColorImageView, mDepthImageView, mSwapchainImageViews[i] }
+                                 : std::array { mSwapchainImageViews[i], mDepthImageView, VkImageView {} };
 
-        framebufferCI.attachmentCount = (u32)atts.size();
+        framebufferCI.attachmentCount = msaa() ? 3 : 2;
         framebufferCI.pAttachments    = atts.data();
 
         BMVK_CHECK(vkCreateFramebuffer(mDevice, &framebufferCI, nullptr, &mFramebuffers[i]));
-        ADD_DESTROY_SWAPCHAIN(vkDestroyImageView(mDevice, mSwapchainImageViews[i], nullptr));
-        ADD_DESTROY_SWAPCHAIN(vkDestroyFramebuffer(mDevice, mFramebuffers[i], nullptr));
+        auto const imageView   = mSwapchainImageViews[i];
+        auto const framebuffer = mFramebuffers[i];
+        ADD_DESTROY_SWAPCHAIN(vkDestroyImageView(mDevice, imageView, nullptr));
+        ADD_DESTROY_SWAPCHAIN(vkDestroyFramebuffer(mDevice, framebuffer, nullptr));
     }
 }
 
@@ -489,15 +906,20 @@ void Renderer::initSyncStructures()
 {
     BM_TRACE();
 
+    // One timeline per queue, its retirees may free command buffers so they go before the pools
+    mGraphicsTL.init(mDevice);
+    mComputeTL.init(mDevice);
+    mTransferTL.init(mDevice);
+    ADD_DESTROY(mGraphicsTL.cleanup());
+    ADD_DESTROY(mComputeTL.cleanup());
+    ADD_DESTROY(mTransferTL.cleanup());
+
+    // Binary semaphores are still needed by the swapchain
     for (u64 i = 0; i < sFlightFrames; i++)
     {
-        auto const fenceCI     = vk::CreateInfo::Fence();
         auto const semaphoreCI = vk::CreateInfo::Semaphore();
         auto      &fd          = mFrames[i];
 
-        BMVK_CHECK(vkCreateFence(mDevice, &fenceCI, nullptr, &fd.renderFence));
-        ADD_DESTROY(vkDestroyFence(mDevice, fd.renderFence, nullptr));
-
         BMVK_CHECK(vkCreateSemaphore(mDevice, &semaphoreCI, nullptr, &fd.presentSemaphore));
         ADD_DESTROY(vkDestroySemaphore(mDevice, fd.presentSemaphore, nullptr));
 
@@ -513,14 +935,14 @@ void Renderer::initDescriptors()
     BM_TRACE();
 
     // CREATE GLOBAL DESCRIPTOR SET LAYOUT
+    // Reflected from the mesh shaders, the layout-cache hands this same handle to every pipeline that agrees on set 0
     {
-        mDescSetLayout = Create::DescSetLayout(
-          mDevice,
-          {
-            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0 },                                //
-            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 1 }  //
-          });
-        ADD_DESTROY(vkDestroyDescriptorSetLayout(mDevice, mDescSetLayout, nullptr));
+        mLayouts.init(mDevice);
+        ADD_DESTROY(mLayouts.cleanup());
+
+        auto const &vs = ShaderReflection::get(Create::ShaderCode("mesh", VK_SHADER_STAGE_VERTEX_BIT));
+        auto const &fs = ShaderReflection::get(Create::ShaderCode("mesh", VK_SHADER_STAGE_FRAGMENT_BIT));
+        mDescSetLayout = mLayouts.descSetLayout({ &vs, &fs }, 0);
     }
     auto const descSetLayouts = std::array { mDescSetLayout };
 
@@ -539,6 +961,25 @@ void Renderer::initDescriptors()
         ADD_DESTROY(vkDestroyDescriptorPool(mDevice, mDescPool, nullptr));
     }
 
+    // BINDLESS
+    if (mUseBindless)
+    {
+        mBindless.init(mDevice, mChosenGPU);
+        ADD_DESTROY(mBindless.cleanup());
+
+        // Per-frame object buffers are (re)allocated on demand by 'reserveObjects'
+        ADD_DESTROY(for (auto &fd : mFrames) vmaDestroyBuffer(mAllocator, fd.objects.buffer, fd.objects.allocation));
+        ADD_DESTROY(for (auto &fd : mFrames) vmaDestroyBuffer(mAllocator, fd.bounds.buffer, fd.bounds.allocation));
+    }
+
+    // GPU CULLING
+    if (mUseGpuCulling)
+    {
+        u32 const maxDrawCount = mMultiDrawIndirect ? mProperties.limits.maxDrawIndirectCount : 1;
+        mGpuCulling.init(mDevice, mAllocator, mLayouts, mBindless, mGraphicsTL, maxDrawCount);
+        ADD_DESTROY(mGpuCulling.cleanup());
+    }
+
     // SCENE DATA
     mSceneDataBuff = createBuffer(
       mSceneDataPaddedSize * sFlightFrames,
@@ -584,36 +1025,40 @@ void Renderer::initMaterials()
 {
     BM_TRACE();
 
-    // Shader - tri
-    auto vs_tri = vk::Create::ShaderModule(mDevice, "tri", VK_SHADER_STAGE_VERTEX_BIT);
-    BM_DEFER(vkDestroyShaderModule(mDevice, vs_tri, nullptr));
-    auto fs_tri = vk::Create::ShaderModule(mDevice, "tri", VK_SHADER_STAGE_FRAGMENT_BIT);
-    BM_DEFER(vkDestroyShaderModule(mDevice, fs_tri, nullptr));
-
-    // Shader - mesh
-    auto vs_mesh = vk::Create::ShaderModule(mDevice, "mesh", VK_SHADER_STAGE_VERTEX_BIT);
-    BM_DEFER(vkDestroyShaderModule(mDevice, vs_mesh, nullptr));
-    auto fs_mesh = vk::Create::ShaderModule(mDevice, "mesh", VK_SHADER_STAGE_FRAGMENT_BIT);
-    BM_DEFER(vkDestroyShaderModule(mDevice, fs_mesh, nullptr));
-
-    // Pipeline Layout(s)
-
-    mPipelineLayouts = std::vector<VkPipelineLayout>(100, VK_NULL_HANDLE);
+    // Shaders : module + reflection, layouts and vertex-input are derived from the SPIR-V itself
+    struct Stage
+    {
+        VkShaderModule          module     = VK_NULL_HANDLE;
+        ShaderReflection const *reflection = nullptr;
+    };
+    auto const loadStage = [this](std::string const &name, VkShaderStageFlagBits stage)
+    {
+        auto const code = vk::Create::ShaderCode(name, stage);
+        return Stage { vk::Create::ShaderModule(mDevice, code), &ShaderReflection::get(code) };
+    };
 
-    auto const triInfoPL = vk::CreateInfo::PipelineLayout();
-    BMVK_CHECK(vkCreatePipelineLayout(mDevice, &triInfoPL, nullptr, &mPipelineLayouts[0]));
+    // Shader - tri
+    auto const vs_tri = loadStage("tri", VK_SHADER_STAGE_VERTEX_BIT);
+    BM_DEFER(vkDestroyShaderModule(mDevice, vs_tri.module, nullptr));
+    auto const fs_tri = loadStage("tri", VK_SHADER_STAGE_FRAGMENT_BIT);
+    BM_DEFER(vkDestroyShaderModule(mDevice, fs_tri.module, nullptr));
 
-    VkPushConstantRange push_constant = { VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ModelData) };
+    // Shader - mesh (the bindless variant fetches its ModelData by instance index, same fragment stage)
+    // @note : Modules are kept alive by the permutation-cache, new variants are specialized from them on demand
+    auto const vs_mesh = loadStage(mUseBindless ? "mesh_bindless" : "mesh", VK_SHADER_STAGE_VERTEX_BIT);
+    auto const fs_mesh = loadStage("mesh", VK_SHADER_STAGE_FRAGMENT_BIT);
 
-    auto meshInfoPL                   = vk::CreateInfo::PipelineLayout();
-    meshInfoPL.pPushConstantRanges    = &push_constant;
-    meshInfoPL.pushConstantRangeCount = 1;
-    meshInfoPL.setLayoutCount         = 1;
-    meshInfoPL.pSetLayouts            = &mDescSetLayout;
+    BM_ASSERT_X(
+      vs_mesh.reflection->vertexInput.bindings.size() == 1
+        && vs_mesh.reflection->vertexInput.bindings[0].stride == sizeof(bm::Mesh::Vertex),
+      "Mesh shader inputs don't match bm::Mesh::Vertex layout");
 
-    BMVK_CHECK(vkCreatePipelineLayout(mDevice, &meshInfoPL, nullptr, &mPipelineLayouts[1]));
+    // Pipeline Layout(s) : owned by the layout-cache, identical signatures share the same handle
+    auto const overrides = mUseBindless ? LayoutCache::Overrides { { Bindless::sSet, mBindless.layout() } } : LayoutCache::Overrides {};
 
-    ADD_DESTROY(for (auto L : mPipelineLayouts) if (L) vkDestroyPipelineLayout(mDevice, L, nullptr));
+    mPipelineLayouts    = std::vector<VkPipelineLayout>(100, VK_NULL_HANDLE);
+    mPipelineLayouts[0] = mLayouts.pipelineLayout({ vs_tri.reflection, fs_tri.reflection });
+    mPipelineLayouts[1] = mLayouts.pipelineLayout({ vs_mesh.reflection, fs_mesh.reflection }, overrides);
 
     //=====
 
@@ -625,8 +1070,8 @@ void Renderer::initMaterials()
 
     // Pipeline 1
 
-    pb.shaderStages.push_back(vk::CreateInfo::PipelineShaderStage(VK_SHADER_STAGE_VERTEX_BIT, vs_tri));
-    pb.shaderStages.push_back(vk::CreateInfo::PipelineShaderStage(VK_SHADER_STAGE_FRAGMENT_BIT, fs_tri));
+    pb.shaderStages.push_back(vk::CreateInfo::PipelineShaderStage(VK_SHADER_STAGE_VERTEX_BIT, vs_tri.module));
+    pb.shaderStages.push_back(vk::CreateInfo::PipelineShaderStage(VK_SHADER_STAGE_FRAGMENT_BIT, fs_tri.module));
     pb.vertexInputInfo      = vk::CreateInfo::VertexInputState();
     pb.inputAssembly        = vk::CreateInfo::InputAssembly();
     pb.viewport.x           = 0.0f;
@@ -638,7 +1083,7 @@ void Renderer::initMaterials()
     pb.scissor.offset       = { 0, 0 };
     pb.scissor.extent       = extent2D();
     pb.rasterizer           = vk::CreateInfo::RasterizationState();
-    pb.multisampling        = vk::CreateInfo::MultisamplingState();
+    pb.multisampling        = vk::CreateInfo::MultisamplingState(mSamples);
     pb.colorBlendAttachment = vk::Blend::None;
     pb.pipelineLayout       = mPipelineLayouts[0];
     pb.depthStencil         = vk::CreateInfo::DepthStencil(true, true, VK_COMPARE_OP_LESS_OR_EQUAL);
@@ -650,17 +1095,21 @@ void Renderer::initMaterials()
 
     pb.shaderStages.clear();
 
-    pb.shaderStages.push_back(vk::CreateInfo::PipelineShaderStage(VK_SHADER_STAGE_VERTEX_BIT, vs_mesh));
-    pb.shaderStages.push_back(vk::CreateInfo::PipelineShaderStage(VK_SHADER_STAGE_FRAGMENT_BIT, fs_mesh));
-    pb.vertexInputInfo = vk::CreateInfo::VertexInputState(VertexInputDescription::get());
+    pb.shaderStages.push_back(vk::CreateInfo::PipelineShaderStage(VK_SHADER_STAGE_VERTEX_BIT, vs_mesh.module));
+    pb.shaderStages.push_back(vk::CreateInfo::PipelineShaderStage(VK_SHADER_STAGE_FRAGMENT_BIT, fs_mesh.module));
+    pb.vertexInputInfo = vk::CreateInfo::VertexInputState(vs_mesh.reflection->vertexInput);
     pb.rasterizer      = vk::CreateInfo::RasterizationState(Cull::NONE);
-    pb.multisampling   = vk::CreateInfo::MultisamplingState(Samples::_1);  // Must match with renderpass ...
+    pb.multisampling   = vk::CreateInfo::MultisamplingState(mSamples);  // Must match with renderpass ...
     pb.pipelineLayout  = mPipelineLayouts[1];
 
-    mPipelines.push_back(vk::Create::Pipeline(pb, mDevice, mDefaultRenderPass, sDynamicStates));
-    createMaterial(mPipelines.back(), mPipelineLayouts[1], "default");
+    auto &permutations = mPermutations["default"_sid];
+    permutations.init(mDevice, mDefaultRenderPass, pb, sDynamicStates);
+
+    auto const defaultMat               = createMaterial(permutations.get(ShaderFeature::All), mPipelineLayouts[1], "default");
+    mMaterials[defaultMat].permutations = &permutations;
 
     ADD_DESTROY(for (auto P : mPipelines) if (P) vkDestroyPipeline(mDevice, P, nullptr));
+    ADD_DESTROY(for (auto &[name, permutations] : mPermutations) permutations.cleanup());
 }
 
 //-----------------------------------------------------------------------------
@@ -675,7 +1124,7 @@ void Renderer::initMeshes()  // todo : this have to come from user-land
     static auto const sGeometryPath = runtime::exepath() + "/Assets/Geometry";
 #endif
 
-    auto const addMesh = [this](auto const &name, auto const &path) { mMeshMap[name] = createMesh(bm::parseGltf(path)); };
+    auto const addMesh = [this](auto const &name, auto const &path) { addMeshGroup(name, createMesh(bm::parseGltf(path)), path); };
 
     addMesh("monkey", sGeometryPath + "/suzanne_donut.glb");
     addMesh("cube", sGeometryPath + "/cube2.glb");
@@ -687,21 +1136,263 @@ void Renderer::initTestScene()
 {
     BM_TRACE();
 
-    auto &testScene = mScenes["test"];
+    buildGridScene("test"_sid, 41);
+    makeScene("test"_sid).add(mesh0("monkey"), material("default"));
+}
+
+//-----------------------------------------------------------------------------
+
+void Renderer::buildGridScene(StrId name, u32 side, float spacing)
+{
+    BM_TRACE();
+
+    auto &scene = makeScene(name);
+    scene.clear();
+
+    auto const mesh = mesh0("monkey");
+    auto const mat  = material("default");
+
+    float const     half  = float(side > 0 ? side - 1 : 0) * 0.5f;
+    glm::mat4 const scale = glm::scale(glm::mat4 { 1.0 }, glm::vec3(0.2, 0.2, 0.2));
+
+    for (u32 x = 0; x < side; x++)
+    {
+        for (u32 y = 0; y < side; y++)
+        {
+            auto const pos = glm::vec3((float(x) - half) * spacing, 0, (float(y) - half) * spacing);
+            scene.add(mesh, mat, glm::translate(glm::mat4 { 1.0 }, pos) * scale);
+        }
+    }
+
+    scene.sortForDraw();
+}
+
+//-----------------------------------------------------------------------------
+
+bool Renderer::loadGltfScene(std::string const &name, std::string const &path)
+{
+    BM_TRACE();
+
+    auto gltf = bm::parseGltfScene(path);
+
+    if (gltf.graph.size() == 0 || gltf.meshes.empty())
+    {
+        BM_WARNF("glTF scene {} : no nodes with geometry", path);
+        return false;
+    }
+
+    // Primitives are uploaded once and shared by every node that instances their mesh
+    auto const &meshes = addMeshGroup(name, createMesh(gltf.meshes), path);
+    auto const  mat    = material("default");
+
+    auto &scene = makeScene(name);
+    scene.clear();
+
+    // The scene keeps the graph with each node's drawables, so moving a node later only touches its subtree
+    std::vector<u32>           nodeFirst;
+    std::vector<Scene::Entity> nodeEntities;
+    nodeFirst.reserve(gltf.graph.size() + 1);
+
+    for (u32 node = 0; node < gltf.graph.size(); ++node)
+    {
+        nodeFirst.push_back((u32)nodeEntities.size());
+
+        auto const mesh = gltf.graph.mesh(node);
+
+        if (mesh < 0 || mesh >= (i32)gltf.meshFirst.size())
+            continue;
+
+        for (u32 p = 0; p < gltf.meshCount[mesh]; ++p)
+            nodeEntities.push_back(scene.add(meshes[gltf.meshFirst[mesh] + p], mat, gltf.graph.world(node)));
+    }
+
+    nodeFirst.push_back((u32)nodeEntities.size());
+
+    scene.sortForDraw();
+
+    BM_INFOF("glTF scene {} : {} nodes, {} primitives, {} drawables", path, gltf.graph.size(), gltf.meshes.size(), scene.size());
+
+    scene.setGraph(std::move(gltf.graph), std::move(nodeFirst), std::move(nodeEntities));
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void Renderer::applyNodeEdits()
+{
+    takeNodeEdits(mEdits);
+
+    for (auto const &edit : mEdits)
+    {
+        auto const sceneIt = mScenes.find(edit.scene);
+
+        if (sceneIt == mScenes.end() || edit.node >= sceneIt->second.graph().size())
+        {
+            BM_WARNF("Set node local : scene {} has no node {}", edit.scene, edit.node);
+            continue;
+        }
+
+        sceneIt->second.setLocal(edit.node, edit.local);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+bool Renderer::exportScene(StrId name, SceneFile &file)
+{
+    BM_TRACE();
+
+    file.clear();
+
+    auto const sceneIt = mScenes.find(name);
+
+    if (sceneIt == mScenes.end())
+    {
+        BM_WARNF("Export scene {} : doesn't exist", name);
+        return false;
+    }
+
+    auto &scene = sceneIt->second;
+
+    // Back from handles to ids and names (by slot index), only what the scene uses makes it to the file
+    std::vector<u32> meshIdx(mMeshes.capacity(), ~0u);
+    std::vector<u32> materialIdx(mMaterials.capacity(), ~0u);
+
+    for (auto const &[key, group] : mMeshGroups)
+    {
+        for (u32 p = 0; p < group.meshes.size(); ++p)
+        {
+            meshIdx[group.meshes[p].index] = (u32)file.meshes.size();
+            file.meshes.push_back({ group.name, p, group.source, mMeshes.id(group.meshes[p]) });
+        }
+    }
+
+    mMaterials.each(
+      [&](MaterialHandle handle, Material const &)
+      {
+          materialIdx[handle.index] = (u32)file.materials.size();
+          file.materials.push_back({ mMaterials.name(handle), mMaterials.id(handle) });
+      });
+
+    file.mesh.reserve(scene.size());
+    file.material.reserve(scene.size());
+    file.world.reserve(scene.size());
+
+    u32 stale = 0;
+
+    for (auto [e, transform, bounds, meshRef, materialRef] : scene.drawables().each())
+    {
+        if (!mMeshes.valid(meshRef.mesh) || !mMaterials.valid(materialRef.material))
+        {
+            ++stale;
+            continue;
+        }
+
+        file.mesh.push_back(meshIdx[meshRef.mesh.index]);
+        file.material.push_back(materialIdx[materialRef.material.index]);
+        file.world.push_back(transform.world);
+    }
 
-    RenderObject ro { mesh0("monkey"), material("default") };
-    testScene.push_back(ro);
+    if (stale > 0)
+        BM_WARNF("Export scene {} : {} objects point to removed meshes or materials, skipped", name, stale);
 
-    for (int x = -20; x <= 20; x++)
+    // Drop the unused entries, remapping indices to the compacted tables
+    auto const compact = [](auto &table, std::vector<u32> &indices)
     {
-        for (int y = -20; y <= 20; y++)
+        std::vector<u32>                         remap(table.size(), ~0u);
+        std::remove_reference_t<decltype(table)> used;
+
+        for (auto &idx : indices)
         {
-            glm::mat4 translation = glm::translate(glm::mat4 { 1.0 }, glm::vec3(x, 0, y));
-            glm::mat4 scale       = glm::scale(glm::mat4 { 1.0 }, glm::vec3(0.2, 0.2, 0.2));
-            ro.transform          = translation * scale;
-            testScene.push_back(ro);
+            if (remap[idx] == ~0u)
+            {
+                remap[idx] = (u32)used.size();
+                used.push_back(std::move(table[idx]));
+            }
+
+            idx = remap[idx];
         }
+
+        table = std::move(used);
+    };
+
+    compact(file.meshes, file.mesh);
+    compact(file.materials, file.material);
+
+    // Packed order is the draw order, 'sortForDraw' already ran on everything built here
+    file.grouped = true;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool Renderer::importScene(StrId name, SceneFile const &file)
+{
+    BM_TRACE();
+
+    if (!file.valid())
+        return false;
+
+    // Resolve the tables once, objects just index them : by id, then by name, then loading the group from its source
+    std::vector<MeshHandle> meshes(file.meshes.size());
+
+    for (size_t i = 0; i < file.meshes.size(); ++i)
+    {
+        auto const &ref = file.meshes[i];
+
+        if (meshes[i] = mMeshes.find(ref.id); meshes[i])
+            continue;
+
+        if (!mesh(ref.name) && !ref.source.empty())
+            addMeshGroup(ref.name, createMesh(bm::parseGltf(ref.source)), ref.source);
+
+        auto const *const group = mesh(ref.name);
+
+        if (!group || ref.primitive >= group->size())
+        {
+            BM_ERRF("Import scene {} : mesh {}[{}] not found", name, ref.name, ref.primitive);
+            return false;
+        }
+
+        meshes[i] = (*group)[ref.primitive];
+    }
+
+    std::vector<MaterialHandle> materials(file.materials.size());
+
+    for (size_t i = 0; i < file.materials.size(); ++i)
+    {
+        auto const &ref = file.materials[i];
+
+        if (materials[i] = mMaterials.find(ref.id); materials[i])
+            continue;
+
+        if (materials[i] = material(ref.name); !materials[i])
+        {
+            BM_WARNF("Import scene {} : material {} not found, using the default one", name, ref.name);
+            materials[i] = material("default");
+        }
+    }
+
+    //-----
+
+    std::vector<MeshHandle>     objectMeshes(file.size());
+    std::vector<MaterialHandle> objectMaterials(file.size());
+
+    for (u32 i = 0; i < file.size(); ++i)
+    {
+        objectMeshes[i]    = meshes[file.mesh[i]];
+        objectMaterials[i] = materials[file.material[i]];
     }
+
+    auto &scene = makeScene(name);
+    scene.clear();
+    scene.add(ds::make_view(objectMeshes), ds::make_view(objectMaterials), ds::make_view(file.world));
+
+    if (!file.grouped)
+        scene.sortForDraw();
+
+    return true;
 }
 
 //-----------------------------------------------------------------------------
@@ -723,6 +1414,15 @@ AllocatedBuffer Renderer::createBuffer(
     info.usage              = usage;
     info.sharingMode        = VK_SHARING_MODE_EXCLUSIVE;  // only one queue at time
 
+    // Filled on the transfer queue and read on graphics : share it instead of transferring ownership
+    auto const families = std::array { mGraphics.family, mTransfer.family };
+    if ((usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) && mGraphics.family != mTransfer.family)
+    {
+        info.sharingMode           = VK_SHARING_MODE_CONCURRENT;
+        info.queueFamilyIndexCount = (u32)families.size();
+        info.pQueueFamilyIndices   = families.data();
+    }
+
     VmaAllocationCreateInfo allocInfo = {};
     allocInfo.usage                   = VMA_MEMORY_USAGE_UNKNOWN;
     allocInfo.requiredFlags           = reqFlags;
@@ -742,7 +1442,7 @@ AllocatedBuffer Renderer::createBuffer(
 
 //-----------------------------------------------------------------------------
 
-AllocatedBuffer Renderer::createBufferStaging(void const *data, u64 bytes, VkBufferUsageFlags usage)
+AllocatedBuffer Renderer::createBufferStaging(void const *data, u64 bytes, VkBufferUsageFlags usage, bool addToDelQueue)
 {
     //-----
 
@@ -754,7 +1454,7 @@ AllocatedBuffer Renderer::createBufferStaging(void const *data, u64 bytes, VkBuf
     // Create dev
     auto const devUsage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage;
     auto const devProps = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-    auto       devBuff  = createBuffer(bytes, devUsage, devProps);
+    auto       devBuff  = createBuffer(bytes, devUsage, devProps, 0, addToDelQueue);
 
     //-----
 
@@ -764,10 +1464,11 @@ AllocatedBuffer Renderer::createBufferStaging(void const *data, u64 bytes, VkBuf
     memcpy(hostMap, data, bytes);
     vmaUnmapMemory(mAllocator, hostBuff.allocation);
 
-    // Populate dev (from host)
-    executeImmediately(
+    // Populate dev (from host) : asynchronously, the next graphics submit waits for it on the transfer timeline
+    mUploadsValue = executeAsync(
       frame().transfer.pool,
       mTransfer.queue,
+      mTransferTL,
       [&](VkCommandBuffer cb)
       {
           VkBufferCopy const copyRegion { 0, 0, bytes };
@@ -776,8 +1477,8 @@ AllocatedBuffer Renderer::createBufferStaging(void const *data, u64 bytes, VkBuf
 
     //-----
 
-    // Host is no longer needed
-    vmaDestroyBuffer(mAllocator, hostBuff.buffer, hostBuff.allocation);
+    // Host is no longer needed once the copy is done
+    mTransferTL.retire(mUploadsValue, [=, this]() { vmaDestroyBuffer(mAllocator, hostBuff.buffer, hostBuff.allocation); });
 
     //-----
 
@@ -795,10 +1496,23 @@ MeshGroup Renderer::createMesh(bm::MeshGroup const &meshes)
         auto const &I = mesh.indices;
         auto const &V = mesh.vertices;
 
+        math::AABB             bounds;
+        std::vector<glm::vec3> positions;
+        positions.reserve(V.size());
+
+        for (auto const &v : V)
+        {
+            bounds.expand(v.pos);
+            positions.push_back(v.pos);
+        }
+
         mg.emplace_back(
           BMVK_COUNT(I),
-          createBufferStaging(BMVK_VOIDC(I), BMVK_BYTES(I), VK_BUFFER_USAGE_INDEX_BUFFER_BIT),
-          createBufferStaging(BMVK_VOIDC(V), BMVK_BYTES(V), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT));
+          createBufferStaging(BMVK_VOIDC(I), BMVK_BYTES(I), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, false),
+          createBufferStaging(BMVK_VOIDC(V), BMVK_BYTES(V), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, false),
+          mesh.hasTangents ? ShaderFeature::HasTangent : 0u,
+          bounds,
+          sNew<MeshBvh const>(std::move(positions), std::vector<u32>(I.begin(), I.end())));
     }
 
     return mg;
@@ -806,9 +1520,47 @@ MeshGroup Renderer::createMesh(bm::MeshGroup const &meshes)
 
 //-----------------------------------------------------------------------------
 
-Material *Renderer::createMaterial(VkPipeline pipeline, VkPipelineLayout layout, std::string const &name)
+MaterialHandle Renderer::createMaterial(VkPipeline pipeline, VkPipelineLayout layout, std::string const &name)
 {
-    return &(mMatMap.insert({ name, Material { pipeline, layout } })).first->second;
+    return mMaterials.add(Material { pipeline, layout }, ds::stableId(name), name);
+}
+
+//-----------------------------------------------------------------------------
+
+std::vector<MeshHandle> const &Renderer::addMeshGroup(std::string const &name, MeshGroup group, std::string const &source)
+{
+    // Replacing a group turns the handles to its old primitives stale, scenes still using them skip those objects.
+    // Their buffers may still be read by frames in flight : freed once the graphics timeline passes them
+    auto &entry = mMeshGroups[name];
+    for (auto const handle : entry.meshes)
+    {
+        if (auto const *mesh = mMeshes.get(handle))
+            retire([=, this, v = mesh->vertices, i = mesh->indices]() { destroyMeshBuffers(v, i); });
+        mMeshes.remove(handle);
+    }
+
+    entry.name   = name;
+    entry.source = source;
+    entry.meshes.clear();
+    entry.meshes.reserve(group.size());
+
+    for (u32 p = 0; p < group.size(); ++p)
+        entry.meshes.push_back(mMeshes.add(std::move(group[p]), ds::stableId(name + "#" + std::to_string(p))));
+
+    // Uploaded objects carry their mesh's index count, the stale ones must go to zero
+    for (auto &slot : mFrames) slot.objectsVersion = 0;
+
+    return entry.meshes;
+}
+
+//-----------------------------------------------------------------------------
+
+VkPipeline Renderer::variant(Mesh const *mesh, Material const *material)
+{
+    if (!material->permutations)
+        return material->pipeline;
+
+    return material->permutations->get(mSceneFeatures | mesh->features);
 }
 
 //-----------------------------------------------------------------------------
@@ -817,82 +1569,474 @@ Material *Renderer::createMaterial(VkPipeline pipeline, VkPipelineLayout layout,
 
 //-----------------------------------------------------------------------------
 
-void Renderer::drawScene(std::string const &name, Camera const &cam)
+// Calls 'fn(index, transform, mesh, material)' for the drawables of 'scene' at the packed positions in 'visible', skipping
+// the ones whose mesh or material was removed
+template<typename F>
+static void eachVisible(
+  Scene                    &scene,
+  std::vector<u32> const   &visible,
+  ds::HandlePool<Mesh>     &meshes,
+  ds::HandlePool<Material> &materials,
+  F                       &&fn)
+{
+    auto drawables = scene.drawables();
+
+    for (u32 const i : visible)
+    {
+        if (i >= drawables.size())
+        {
+            continue;
+        }
+
+        auto const [transform, meshRef, materialRef] = drawables.get<cmp::Transform, cmp::MeshRef, cmp::MaterialRef>(drawables[i]);
+        auto *const mesh     = meshes.get(meshRef.mesh);
+        auto *const material = materials.get(materialRef.material);
+
+        if (mesh && material)
+            fn(i, transform, mesh, material);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+Scene *Renderer::beginScene(FrameSnapshot const &snap)
 {
+    mDrawStats = {};
+
+    // Every scene, not just this one : edits of hidden scenes wait on their graph, not on the queue
+    applyNodeEdits();
+
     //-----
 
-    bool const sceneExists = mScenes.count(name) > 0;
+    auto const sceneIt = mScenes.find(snap.scene);
 
-    if (!sceneExists)
+    if (sceneIt == mScenes.end())
     {
-        return;
+        return nullptr;
+    }
+
+    auto &scene = sceneIt->second;
+
+    // Moved nodes first, so picking and culling see this frame's transforms
+    scene.updateGraph();
+
+    if (snap.pick)
+    {
+        auto const  begin = Clock::now();
+        auto const  hit   = scene.pick(snap.pickRay);
+        float const ms    = std::chrono::duration<float, std::milli>(Clock::now() - begin).count();
+
+        publishPick({ snap.frame, hit ? (u32)entt::to_integral(hit.entity) : ~0u, hit.t, hit.point, hit.triangle, ms });
     }
 
     //-----
 
     CameraData uCam {};
-    uCam.proj     = cam.P();
-    uCam.view     = cam.V();
-    uCam.viewproj = uCam.proj * uCam.view;
+    uCam.proj     = snap.proj;
+    uCam.view     = snap.view;
+    uCam.viewproj = snap.viewproj();
 
     void *map = nullptr;
     BMVK_CHECK(vmaMapMemory(mAllocator, frame().camera.allocation, &map));
     memcpy(map, &uCam, sizeof(CameraData));
     vmaUnmapMemory(mAllocator, frame().camera.allocation);
 
+    return &scene;
+}
+
+//-----------------------------------------------------------------------------
+
+void Renderer::drawScene(FrameSnapshot const &snap, VkCommandBuffer cmd)
+{
+    BM_PROFILE_ZONE("DrawScene");
+
+    auto *const scenePtr = beginScene(snap);
+
+    if (!scenePtr)
+    {
+        return;
+    }
+
+    auto &scene = *scenePtr;
+
+    // The scene BVH culls against this frame's camera
+    scene.cull(math::Frustum(snap.viewproj()), mVisible);
+
+    // Then whatever hides behind the biggest occluders on screen
+    if (mSettings.occlusion)
+        mDrawStats.occluded = scene.occlude(mOcclusion, snap.viewproj(), mVisible);
+
+    auto const &visible = mVisible;
+    mDrawStats.objects  = (u32)visible.size();
+
+    //-----
+
+    if (mUseBindless)
+    {
+        drawSceneBindless(scene, visible, cmd);
+        return;
+    }
+
     ModelData model {};
 
-    Mesh     *lastMesh     = nullptr;
-    Material *lastMaterial = nullptr;
+    Mesh      *lastMesh     = nullptr;
+    Material  *lastMaterial = nullptr;
+    VkPipeline lastPipeline = VK_NULL_HANDLE;
+
+    //-----
+
+    eachVisible(
+      scene,
+      visible,
+      mMeshes,
+      mMaterials,
+      [&](u32, cmp::Transform const &transform, Mesh *mesh, Material *material)
+      {
+          // update push-constant
+          model.normal = transform.normal;
+          model.model  = transform.world;
+          vkCmdPushConstants(cmd, mPipelineLayouts[1], VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ModelData), &model);
+
+          // only bind the pipeline if it doesn't match with the already bound one
+          if (auto const pipeline = variant(mesh, material); pipeline != lastPipeline)
+          {
+              vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+              lastPipeline = pipeline;
+              ++mDrawStats.pipelineBinds;
+          }
+
+          if (material != lastMaterial)
+          {
+              lastMaterial = material;
+
+              static auto const sGraphicsBP = VK_PIPELINE_BIND_POINT_GRAPHICS;
+              vkCmdBindDescriptorSets(cmd, sGraphicsBP, material->pipelineLayout, 0, 1, &frame().descSet, 0, nullptr);
+
+              VkViewport viewport {};
+              viewport.x        = 0.0f;
+              viewport.y        = 0.0f;
+              viewport.width    = (float)extentW();
+              viewport.height   = (float)extentH();
+              viewport.minDepth = 0.0f;
+              viewport.maxDepth = 1.0f;
+              vkCmdSetViewport(cmd, 0, 1, &viewport);
+
+              VkRect2D scissor {};
+              scissor.offset = { 0, 0 };
+              scissor.extent = extent2D();
+              vkCmdSetScissor(cmd, 0, 1, &scissor);
+          }
+
+          // only bind the mesh if it's a different one from last bind
+          if (mesh != lastMesh)
+          {
+              mesh->bind(cmd);
+              lastMesh = mesh;
+              ++mDrawStats.meshBinds;
+          }
+
+          // draw
+          mesh->draw(cmd);
+          ++mDrawStats.draws;
+      });
+}
+
+//-----------------------------------------------------------------------------
+
+void Renderer::drawSceneBindless(Scene &scene, std::vector<u32> const &visible, VkCommandBuffer cmd)
+{
+    BM_PROFILE_ZONE("DrawSceneBindless");
+
+    static auto const sGraphicsBP = VK_PIPELINE_BIND_POINT_GRAPHICS;
+
+    auto &fd = frame();
+
+    uploadObjects(scene, fd);
+    bindBindless(cmd, fd);
 
     //-----
 
-    for (auto const &ro : mScenes[name])
+    Mesh      *lastMesh     = nullptr;
+    VkPipeline lastPipeline = VK_NULL_HANDLE;
+
+    // The whole scene is uploaded, culling only skips draws (indices keep pointing to the full table)
+    eachVisible(
+      scene,
+      visible,
+      mMeshes,
+      mMaterials,
+      [&](u32 i, cmp::Transform const &, Mesh *mesh, Material *material)
+      {
+          if (auto const pipeline = variant(mesh, material); pipeline != lastPipeline)
+          {
+              vkCmdBindPipeline(cmd, sGraphicsBP, pipeline);
+              lastPipeline = pipeline;
+              ++mDrawStats.pipelineBinds;
+          }
+
+          if (mesh != lastMesh)
+          {
+              mesh->bind(cmd);
+              lastMesh = mesh;
+              ++mDrawStats.meshBinds;
+          }
+
+          mesh->draw(cmd, i);
+          ++mDrawStats.draws;
+      });
+}
+
+//-----------------------------------------------------------------------------
+
+void Renderer::drawSceneTwoPhase(FrameSnapshot const &snap, VkCommandBuffer cmd, VkRenderPassBeginInfo const &passBI)
+{
+    BM_PROFILE_ZONE("DrawSceneTwoPhase");
+
+    auto *const scene = beginScene(snap);
+    u32 const   count = scene ? scene->size() : 0;
+    auto       &fd    = frame();
+
+    // Nothing to cull, the pass still clears the targets
+    if (count == 0)
     {
-        if (!ro.mesh && !ro.material)
+        vkCmdBeginRenderPass(cmd, &passBI, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdEndRenderPass(cmd);
+        return;
+    }
+
+    // The GPU decides what gets drawn, without a readback the CPU only knows the candidates
+    mDrawStats.objects = count;
+
+    uploadObjects(*scene, fd);
+
+    // Visibility bits are per packed position : they start over whenever positions may mean other objects (another
+    // scene, adds, removes or a re-sort, even when the count stays the same)
+    bool const reset = scene->version() != mCulledVersion;
+    mCulledVersion   = scene->version();
+
+    mGpuCulling.begin(cmd, count, reset, mDepthImage.image, mDepthImageView, extent2D());
+    mGpuCulling.cull(cmd, GpuCulling::Early, snap.viewproj(), fd.boundsIdx, count);
+
+    // Runs of consecutive objects sharing mesh and pipeline, long ones after 'sortForDraw'
+    mBatches.clear();
+
+    // Objects with a removed mesh or material break the run and are left out
+    u32 position = 0;
+    for (auto [e, transform, bounds, meshRef, materialRef] : scene->drawables().each())
+    {
+        auto *const mesh     = mMeshes.get(meshRef.mesh);
+        auto *const material = mMaterials.get(materialRef.material);
+
+        if (mesh && material)
         {
-            continue;
+            auto const pipeline = variant(mesh, material);
+            auto const extends  = !mBatches.empty() && mBatches.back().first + mBatches.back().count == position;
+
+            if (extends && mBatches.back().mesh == mesh && mBatches.back().pipeline == pipeline)
+                ++mBatches.back().count;
+            else
+                mBatches.push_back({ position, 1, mesh, pipeline });
         }
 
-        // update push-constant
-        model.normal = glm::transpose(glm::inverse(ro.transform));
-        model.model  = ro.transform;
-        vkCmdPushConstants(frame().graphics.cmd, mPipelineLayouts[1], VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ModelData), &model);
+        ++position;
+    }
+
+    auto const drawPhase = [&](GpuCulling::Phase phase)
+    {
+        bindBindless(cmd, fd);
 
-        // only bind the pipeline if it doesn't match with the already bound one
-        if (ro.material != lastMaterial)
+        Mesh const *lastMesh     = nullptr;
+        VkPipeline  lastPipeline = VK_NULL_HANDLE;
+
+        for (auto const &batch : mBatches)
         {
-            ro.material->bind(frame().graphics.cmd);
-            lastMaterial = ro.material;
-
-            static auto const sGraphicsBP = VK_PIPELINE_BIND_POINT_GRAPHICS;
-            vkCmdBindDescriptorSets(frame().graphics.cmd, sGraphicsBP, ro.material->pipelineLayout, 0, 1, &frame().descSet, 0, nullptr);
-
-            VkViewport viewport {};
-            viewport.x        = 0.0f;
-            viewport.y        = 0.0f;
-            viewport.width    = w();
-            viewport.height   = h();
-            viewport.minDepth = 0.0f;
-            viewport.maxDepth = 1.0f;
-            vkCmdSetViewport(frame().graphics.cmd, 0, 1, &viewport);
-
-            VkRect2D scissor {};
-            scissor.offset = { 0, 0 };
-            scissor.extent = extent2D();
-            vkCmdSetScissor(frame().graphics.cmd, 0, 1, &scissor);
+            if (batch.pipeline != lastPipeline)
+            {
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, batch.pipeline);
+                lastPipeline = batch.pipeline;
+                ++mDrawStats.pipelineBinds;
+            }
+
+            if (batch.mesh != lastMesh)
+            {
+                batch.mesh->bind(cmd);
+                lastMesh = batch.mesh;
+                ++mDrawStats.meshBinds;
+            }
+
+            mDrawStats.draws += mGpuCulling.draw(cmd, phase, batch);
         }
+    };
+
+    //-----
+
+    vkCmdBeginRenderPass(cmd, &passBI, VK_SUBPASS_CONTENTS_INLINE);
+    drawPhase(GpuCulling::Early);
+    vkCmdEndRenderPass(cmd);
+
+    {
+        GpuProfiler::Scope _ { mGpuProfiler, cmd, "Hzb" };
+        mGpuCulling.buildPyramid(cmd);
+        mGpuCulling.cull(cmd, GpuCulling::Late, snap.viewproj(), fd.boundsIdx, count);
+    }
+
+    auto latePassBI       = passBI;
+    latePassBI.renderPass = mLoadRenderPass;
+
+    vkCmdBeginRenderPass(cmd, &latePassBI, VK_SUBPASS_CONTENTS_INLINE);
+    drawPhase(GpuCulling::Late);
+    vkCmdEndRenderPass(cmd);
+}
+
+//-----------------------------------------------------------------------------
+
+void Renderer::uploadObjects(Scene &scene, FrameData &fd)
+{
+    BM_PROFILE_ZONE("UploadObjects");
+
+    // Every slot keeps its own copy, so what moved since the last frame is pending on all of them
+    if (scene.takeMoved(mMoved))
+    {
+        for (auto &slot : mFrames)
+            for (auto const e : mMoved) slot.objectsMoved.push_back(entt::to_integral(e));
+    }
+    else
+    {
+        for (auto &slot : mFrames) slot.objectsVersion = 0;
+    }
+
+    reserveObjects(fd, scene.size());
+
+    // Another scene or layout : every object, in packed order (each draw picks its entry through gl_InstanceIndex)
+    bool const full = fd.objectsVersion != scene.version() || fd.objectsMoved.size() >= scene.size();
+
+    ModelData          *data   = nullptr;
+    GpuCulling::Object *object = nullptr;
+    BMVK_CHECK(vmaMapMemory(mAllocator, fd.objects.allocation, (void **)&data));
+    if (mUseGpuCulling)
+        BMVK_CHECK(vmaMapMemory(mAllocator, fd.bounds.allocation, (void **)&object));
+
+    auto const write = [&](u32 i, cmp::Transform const &transform, cmp::Bounds const &bounds, cmp::MeshRef const &meshRef)
+    {
+        data[i].normal = transform.normal;
+        data[i].model  = transform.world;
+
+        if (!object)
+            return;
+
+        auto *const mesh     = mMeshes.get(meshRef.mesh);
+        object[i].min        = bounds.world.min;
+        object[i].max        = bounds.world.max;
+        object[i].indexCount = mesh ? mesh->indexCount : 0;  // Removed meshes draw nothing
+    };
+
+    auto drawables = scene.drawables();
 
-        // only bind the mesh if it's a different one from last bind
-        if (ro.mesh != lastMesh)
+    if (full)
+    {
+        u32 i = 0;
+        for (auto [e, transform, bounds, meshRef, materialRef] : drawables.each()) write(i++, transform, bounds, meshRef);
+    }
+    else
+    {
+        // Positions hold while the version does, entities from other scenes or removed since just aren't there
+        for (u32 const id : fd.objectsMoved)
         {
-            ro.mesh->bind(frame().graphics.cmd);
-            lastMesh = ro.mesh;
+            auto const e = Scene::Entity { id };
+
+            if (!drawables.contains(e))
+                continue;
+
+            auto const [transform, bounds, meshRef] = drawables.get<cmp::Transform, cmp::Bounds, cmp::MeshRef>(e);
+            write((u32)(drawables.find(e) - drawables.begin()), transform, bounds, meshRef);
         }
+    }
 
-        // draw
-        ro.mesh->draw(frame().graphics.cmd);
+    fd.objectsVersion = scene.version();
+    fd.objectsMoved.clear();
+
+    vmaUnmapMemory(mAllocator, fd.objects.allocation);
+    if (object)
+        vmaUnmapMemory(mAllocator, fd.bounds.allocation);
+}
+
+//-----------------------------------------------------------------------------
+
+void Renderer::bindBindless(VkCommandBuffer cmd, FrameData const &fd)
+{
+    // Bind once : every bindless pipeline shares this layout, so sets and push-constants survive pipeline switches
+    static auto const sGraphicsBP = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    auto const        layout      = mPipelineLayouts[1];
+
+    vkCmdBindDescriptorSets(cmd, sGraphicsBP, layout, 0, 1, &fd.descSet, 0, nullptr);
+    mBindless.bind(cmd, layout, sGraphicsBP);
+
+    BindlessConsts consts {};
+    consts.objects = fd.objectsIdx;
+    vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(BindlessConsts), &consts);
+
+    VkViewport viewport {};
+    viewport.x        = 0.0f;
+    viewport.y        = 0.0f;
+    viewport.width    = (float)extentW();
+    viewport.height   = (float)extentH();
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+
+    VkRect2D scissor {};
+    scissor.offset = { 0, 0 };
+    scissor.extent = extent2D();
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+}
+
+//-----------------------------------------------------------------------------
+
+void Renderer::reserveObjects(FrameData &fd, u32 count)
+{
+    static constexpr u32 sMinObjects = 1024;
+
+    if (count <= fd.objectsCapacity)
+    {
+        return;
     }
+
+    if (auto const old = fd.objects; old.buffer)
+        retire([=, this]() { vmaDestroyBuffer(mAllocator, old.buffer, old.allocation); });
+
+    fd.objectsCapacity = std::max({ count, fd.objectsCapacity * 2, sMinObjects });
+    fd.objectsVersion  = 0;  // New buffers start empty
+    fd.objects         = createBuffer(
+      sizeof(ModelData) * fd.objectsCapacity,
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      false);
+
+    if (fd.objectsIdx == Bindless::sInvalid)
+        fd.objectsIdx = mBindless.addStorageBuffer(fd.objects.buffer);
+    else
+        mBindless.setStorageBuffer(fd.objectsIdx, fd.objects.buffer);
+
+    if (!mUseGpuCulling)
+    {
+        return;
+    }
+
+    if (auto const old = fd.bounds; old.buffer)
+        retire([=, this]() { vmaDestroyBuffer(mAllocator, old.buffer, old.allocation); });
+
+    fd.bounds = createBuffer(
+      sizeof(GpuCulling::Object) * fd.objectsCapacity,
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      false);
+
+    if (fd.boundsIdx == Bindless::sInvalid)
+        fd.boundsIdx = mBindless.addStorageBuffer(fd.bounds.buffer);
+    else
+        mBindless.setStorageBuffer(fd.boundsIdx, fd.bounds.buffer);
 }
 
 //-----------------------------------------------------------------------------
@@ -901,7 +2045,7 @@ void Renderer::drawScene(std::string const &name, Camera const &cam)
 
 //-----------------------------------------------------------------------------
 
-void Renderer::executeImmediately(VkCommandPool pool, VkQueue queue, const std::function<void(VkCommandBuffer cb)> &fn)
+u64 Renderer::executeAsync(VkCommandPool pool, VkQueue queue, Timeline &timeline, const std::function<void(VkCommandBuffer cb)> &fn)
 {
     // Allocate
     VkCommandBuffer cb;
@@ -917,15 +2061,21 @@ void Renderer::executeImmediately(VkCommandPool pool, VkQueue queue, const std::
     BMVK_CHECK(vkEndCommandBuffer(cb));
 
     // Submit
-    VkSubmitInfo submitInfo {};
-    submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers    = &cb;
-    vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(queue);  // There is some room to improve using 'vkWaitForFences'-logic
-
-    // Free
-    vkFreeCommandBuffers(mDevice, pool, 1, &cb);
+    u64 const value = timeline.next();
+    BMVK_CHECK(Submission {}.cmd(cb).signal(timeline, value).submit(queue));
+
+    // Free (when done)
+    timeline.retire(value, [=, this]() { vkFreeCommandBuffers(mDevice, pool, 1, &cb); });
+
+    return value;
+}
+
+//-----------------------------------------------------------------------------
+
+void Renderer::executeImmediately(VkCommandPool pool, VkQueue queue, Timeline &timeline, const std::function<void(VkCommandBuffer cb)> &fn)
+{
+    timeline.wait(executeAsync(pool, queue, timeline, fn));
+    timeline.collect();
 }
 
 //-----------------------------------------------------------------------------
@@ -3,12 +3,20 @@
 #include "base.hpp"
 #include "str.hpp"
 #include "types.hpp"
+#include "bindless.hpp"
+#include "reflect.hpp"
+#include "permutation.hpp"
+#include "timeline.hpp"
+#include "gpuProfiler.hpp"
+#include "gpuCulling.hpp"
+#include "scene.hpp"
 
 // ^^^ Include the <vk/dx/gl/mt/wg>-Renderer files before the BaseRenderer
 
 #include "../bm/base.hpp"
 #include "../bm/utils.hpp"
 #include "../bm/renderer.hpp"
+#include "../bm/profiler.hpp"
 
 #include <vma/vk_mem_alloc.h>
 
@@ -17,24 +25,39 @@ namespace bm::vk
 
 class Renderer : public bm::BaseRenderer
 {
-    static constexpr u64      sOneSec       = 1000000000;
-    static constexpr u64      sFlightFrames = 3;
-    static constexpr VkFormat sDepthFormat  = VK_FORMAT_D32_SFLOAT;  // @todo: Check VK_FORMAT_D32_SFLOAT_S8_UINT  ??
+    static constexpr u64      sOneSec          = 1000000000;
+    static constexpr u64      sFlightFrames    = 3;
+    static constexpr VkFormat sDepthFormat     = VK_FORMAT_D32_SFLOAT;      // @todo: Check VK_FORMAT_D32_SFLOAT_S8_UINT  ??
+    static constexpr VkFormat sOffscreenFormat = VK_FORMAT_R8G8B8A8_UNORM;  // Headless targets, what 'readback' returns
 
 public:
-    Renderer(sPtr<bm::Window> window);
-    virtual void update() override { bm::BaseRenderer::update(); }
-    virtual void draw(Camera const &cam) override;
+    Renderer(sPtr<bm::Window> window, RendererSettings settings = {});
+    virtual void beginFrame() override;
+    virtual void update(FrameSnapshot const &snap) override { bm::BaseRenderer::update(snap); }
+    virtual void draw(FrameSnapshot const &snap) override;
     virtual void cleanup() override;
 
+    virtual std::vector<u8> readback() override;
+
+    inline u32 sampleCount() const { return BM_BIT((u32)mSamples); }  // MSAA samples in use, after clamping to the device
+
+    virtual void buildGridScene(StrId name, u32 side, float spacing = 1.f) override;
+    virtual bool loadGltfScene(std::string const &name, std::string const &path) override;
+    virtual bool exportScene(StrId name, SceneFile &file) override;
+    virtual bool importScene(StrId name, SceneFile const &file) override;
+
 private:
     void initVulkan();
     void initSwapchain(VkSwapchainKHR prev = VK_NULL_HANDLE);
+    void initOffscreenTargets();  // Headless stand-in for the swapchain images
     void initCommands();
     void initDefaultRenderPass();
     void initFramebuffers();
     void initSyncStructures();
 
+    // Swapchain sized, multisampled when MSAA is on, destroyed along with the swapchain
+    void createAttachment(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect, AllocatedImage &image, VkImageView &view);
+
     void initDescriptors();
 
     void initMaterials();
@@ -43,7 +66,16 @@ private:
 
     void recreateSwapchain();
 
-    void executeImmediately(VkCommandPool pool, VkQueue queue, const std::function<void(VkCommandBuffer cb)> &fn);
+    // Destroy something mid-session : runs once every frame submitted so far, and the one being recorded, is done
+    template<typename F>
+    void retire(F &&fn)
+    {
+        mGraphicsTL.retire(mGraphicsTL.last() + 1, std::forward<F>(fn));
+    }
+
+    // One-shot command buffers, completion is tracked on the given queue's timeline
+    u64  executeAsync(VkCommandPool pool, VkQueue queue, Timeline &timeline, const std::function<void(VkCommandBuffer cb)> &fn);
+    void executeImmediately(VkCommandPool pool, VkQueue queue, Timeline &timeline, const std::function<void(VkCommandBuffer cb)> &fn);
 
     AllocatedBuffer createBuffer(
       u64                   byteSize,
@@ -51,26 +83,56 @@ private:
       VkMemoryPropertyFlags reqFlags,
       VkMemoryPropertyFlags prefFlags     = 0,
       bool                  addToDelQueue = true);
-    AllocatedBuffer createBufferStaging(void const *data, u64 bytes, VkBufferUsageFlags usage);
+    AllocatedBuffer createBufferStaging(void const *data, u64 bytes, VkBufferUsageFlags usage, bool addToDelQueue = true);
 
-    MeshGroup createMesh(bm::MeshGroup const &meshes);
-    Material *createMaterial(VkPipeline pipeline, VkPipelineLayout layout, std::string const &name);
+    inline void destroyMeshBuffers(AllocatedBuffer const &vertices, AllocatedBuffer const &indices)
+    {
+        vmaDestroyBuffer(mAllocator, vertices.buffer, vertices.allocation);
+        vmaDestroyBuffer(mAllocator, indices.buffer, indices.allocation);
+    }
+
+    MeshGroup      createMesh(bm::MeshGroup const &meshes);
+    MaterialHandle createMaterial(VkPipeline pipeline, VkPipelineLayout layout, std::string const &name);
 
-    void drawScene(std::string const &name, Camera const &cam);
+    // Registers the primitives of 'group' under 'name', replacing (and staling the handles of) a previous group
+    std::vector<MeshHandle> const &addMeshGroup(std::string const &name, MeshGroup group, std::string const &source = "");
+
+    VkPipeline variant(Mesh const *mesh, Material const *material);  // Pipeline of the material specialized for the object + scene
+
+    void   applyNodeEdits();  // Queued 'setNodeLocal' edits into their scenes' graphs
+    Scene *beginScene(FrameSnapshot const &snap);  // Resets the stats, answers the pick and uploads the camera
+    void   drawScene(FrameSnapshot const &snap, VkCommandBuffer cmd);
+    void   drawSceneBindless(Scene &scene, std::vector<u32> const &visible, VkCommandBuffer cmd);
+    void   drawSceneTwoPhase(FrameSnapshot const &snap, VkCommandBuffer cmd, VkRenderPassBeginInfo const &passBI);  // Own passes
+    void   uploadObjects(Scene &scene, FrameData &fd);
+    void   bindBindless(VkCommandBuffer cmd, FrameData const &fd);
+    void   reserveObjects(FrameData &fd, u32 count);
 
     //-------
 
-    inline Material  *material(std::string const &name) { return mMatMap.count(name) > 0 ? &mMatMap[name] : nullptr; }
-    inline MeshGroup *mesh(std::string const &name) { return mMeshMap.count(name) > 0 ? &mMeshMap[name] : nullptr; }
-    inline Mesh      *mesh0(std::string const &name) { return mMeshMap.count(name) > 0 ? &mMeshMap[name][0] : nullptr; }
+    // By name : one lookup each, for setup and loading. Hot paths keep the handles, invalid ones when missing
+    inline MaterialHandle material(StrId name) const { return mMaterials.find(name); }
+    inline std::vector<MeshHandle> const *mesh(StrId name) const
+    {
+        auto const it = mMeshGroups.find(name);
+        return it != mMeshGroups.end() ? &it->second.meshes : nullptr;
+    }
+    inline MeshHandle mesh0(StrId name) const
+    {
+        auto const *group = mesh(name);
+        return group && !group->empty() ? group->front() : MeshHandle {};
+    }
+
+    inline Scene     &makeScene(StrId name) { return mScenes.try_emplace(name, mMeshes).first->second; }  // Empty if new
     inline FrameData &frame() { return mFrames[mFrameNumber % sFlightFrames]; }
 
     //-------
 
-    inline VkExtent2D extent2D() { return VkExtent2D((u32)w(), (u32)h()); }
-    inline VkExtent3D extent3D() { return VkExtent3D((u32)w(), (u32)h(), 1); }
-    inline u32        extentW() { return (u32)w(); }
-    inline u32        extentH() { return (u32)h(); }
+    // Of the swapchain, lags behind the window size while a resize is debounced
+    inline VkExtent2D extent2D() { return mSwapchainExtent; }
+    inline VkExtent3D extent3D() { return VkExtent3D(mSwapchainExtent.width, mSwapchainExtent.height, 1); }
+    inline u32        extentW() { return mSwapchainExtent.width; }
+    inline u32        extentH() { return mSwapchainExtent.height; }
     inline u32        extentD() { return 1; }
 
     //-------
@@ -94,12 +156,22 @@ private:
     VkSurfaceKHR               mSurface        = VK_NULL_HANDLE;  // Vulkan window surface
     VkPhysicalDeviceProperties mProperties     = {};
 
+    // FEATURES : Only the optional ones we actually enable on the device
+    VkPhysicalDeviceVulkan12Features mFeatures12         = {};
+    bool                             mPipelineStatistics = false;
+
     // QUEUEs
     vk::Queue mGraphics = {};
     vk::Queue mPresent  = {};
     vk::Queue mCompute  = {};
     vk::Queue mTransfer = {};
 
+    // TIMELINEs : one per queue (signals must be monotonic), cross-queue sync = waiting on the other's value
+    Timeline mGraphicsTL   = {};
+    Timeline mComputeTL    = {};
+    Timeline mTransferTL   = {};
+    u64      mUploadsValue = 0;  // Transfer-timeline value the next graphics submit has to wait for
+
     // MEMORY
     bm::ds::DeletionQueue mDqSwapchain = {};
     bm::ds::DeletionQueue mDqMain      = {};
@@ -111,11 +183,28 @@ private:
     VkFormat                 mSwapchainImageFormat = VK_FORMAT_B8G8R8A8_UINT;  // Image format expected by window
     std::vector<VkImage>     mSwapchainImages      = {};                       // List of images from the swapchain
     std::vector<VkImageView> mSwapchainImageViews  = {};                       // List of image-views from the swapchain
+    VkExtent2D               mSwapchainExtent      = {};                       // What the driver gave, may differ from w/h
+    u32                      mLastTarget           = 0;                        // Headless : image the last frame drew into
+
+    // RESIZE
+    static constexpr auto sResizeDebounce = std::chrono::milliseconds(100);  // Size must be stable this long
+    bool                  mResizePending  = false;
+    Clock::time_point     mResizeAt       = {};  // Last time the window size changed
 
     // DEPTH
     VkImageView    mDepthImageView    = VK_NULL_HANDLE;
     AllocatedImage mDepthImage        = {};
     VkRenderPass   mDefaultRenderPass = VK_NULL_HANDLE;
+    VkRenderPass   mLoadRenderPass    = VK_NULL_HANDLE;  // Compatible with the default one, draws on top of what it left
+
+    // MSAA : color and depth are transient, they live for one pass and only the resolved color is stored. On tilers
+    // that keeps them on chip : lazily allocated memory is never actually backed
+    Samples        mSamples        = Samples::_1;  // Requested on settings, clamped to the device
+    bool           mLazyMemory     = false;        // The device has a lazily allocated memory type
+    VkImageView    mColorImageView = VK_NULL_HANDLE;
+    AllocatedImage mColorImage     = {};
+
+    inline bool msaa() const { return mSamples != Samples::_1; }
 
     // FBOs
     std::vector<VkFramebuffer> mFramebuffers = {};
@@ -126,15 +215,48 @@ private:
     // MATERIALs
     std::vector<VkPipelineLayout>             mPipelineLayouts = {};  // Bucket of pipeline-layouts
     std::vector<VkPipeline>                   mPipelines       = {};  // Bucket of pipelines
-    std::unordered_map<std::string, Material> mMatMap          = {};
+    ds::HandlePool<Material>                  mMaterials       = {};  // Addressable by name
+
+    // PERMUTATIONs
+    std::unordered_map<StrId, PermutationCache> mPermutations  = {};  // By material name
+    u32                                         mSceneFeatures = 0;   // ShaderFeature bits driven by SceneData
 
     // GEOMETRY
-    std::unordered_map<std::string, MeshGroup>                 mMeshMap = {};
-    std::unordered_map<std::string, std::vector<RenderObject>> mScenes  = {};
+    struct MeshGroupEntry
+    {
+        std::string             name   = "";  // What scene files refer to it by
+        std::string             source = "";  // glTF file it came from, if any
+        std::vector<MeshHandle> meshes = {};  // One per primitive
+    };
+
+    ds::HandlePool<Mesh>                      mMeshes     = {};  // One per primitive
+    std::unordered_map<StrId, MeshGroupEntry> mMeshGroups = {};
+    std::unordered_map<StrId, Scene>          mScenes     = {};
+    std::vector<u32>                          mVisible    = {};  // Scratch for the culled positions, render thread only
+    std::vector<NodeEdit>                     mEdits      = {};  // Scratch for the drained node edits, render thread only
+    std::vector<Scene::Entity>                mMoved      = {};  // Scratch for the drained moves, render thread only
+
+    // OCCLUSION
+    OcclusionBuffer mOcclusion {};  // Render thread only
+
+    // GPU CULLING
+    GpuCulling                     mGpuCulling        = {};
+    bool                           mUseGpuCulling     = false;  // Requested on settings AND bindless AND supported by the device
+    bool                           mMultiDrawIndirect = false;
+    std::vector<GpuCulling::Batch> mBatches           = {};     // Scratch, render thread only
+    u64                            mCulledVersion     = 0;      // Scene version the GPU visibility bits belong to
 
     // DESCRIPTORS
     VkDescriptorSetLayout mDescSetLayout;
     VkDescriptorPool      mDescPool;
+    LayoutCache           mLayouts = {};  // Reflection-derived set and pipeline layouts
+
+    // BINDLESS
+    Bindless mBindless    = {};
+    bool     mUseBindless = false;  // Requested on settings AND supported by the device
+
+    // PROFILING
+    GpuProfiler mGpuProfiler = {};
 
     // DATA
     SceneData       mSceneData;
@@ -0,0 +1,351 @@
+#include "scene.hpp"
+
+#include "../bm/profiler.hpp"
+
+#include <atomic>
+
+namespace bm::vk
+{
+
+//-----------------------------------------------------------------------------
+
+Scene::Scene(ds::HandlePool<Mesh> const &meshes) : mMeshes(meshes), mVersion(nextVersion())
+{
+    // Create the group before any component exists : it takes ownership of the pools and keeps them packed from then on
+    (void)drawables();
+}
+
+u64 Scene::nextVersion()
+{
+    static std::atomic<u64> sLast = 0;
+    return ++sLast;
+}
+
+//-----------------------------------------------------------------------------
+
+Scene::Entity Scene::add(MeshHandle mesh, MaterialHandle material, glm::mat4 const &world)
+{
+    BM_ASSERT(mMeshes.valid(mesh) && material);
+
+    auto const e = mRegistry.create();
+
+    mRegistry.emplace<cmp::Transform>(e, cmp::Transform::from(world));
+    mRegistry.emplace<cmp::Bounds>(e, mMeshes[mesh].bounds.transformed(world));
+    mRegistry.emplace<cmp::MeshRef>(e, mesh);
+    mRegistry.emplace<cmp::MaterialRef>(e, material);
+
+    u32 const id = item(e);
+    if (id >= mEntities.size())
+        mEntities.resize(id + 1, sNull);
+
+    mEntities[id] = e;
+    mBvh.insert(id, mRegistry.get<cmp::Bounds>(e).world);
+
+    ++mCount;
+    mVersion = nextVersion();
+    return e;
+}
+
+void Scene::add(ds::view<MeshHandle> meshes, ds::view<MaterialHandle> materials, ds::view<glm::mat4> worlds)
+{
+    BM_PROFILE_ZONE("SceneAddBulk");
+    BM_ASSERT(meshes.size() == worlds.size() && materials.size() == worlds.size());
+
+    size_t const count = worlds.size();
+
+    if (count == 0)
+        return;
+
+    std::vector<Entity> added(count);
+    mRegistry.create(added.begin(), added.end());
+
+    std::vector<cmp::Transform>   transforms(count);
+    std::vector<cmp::Bounds>      bounds(count);
+    std::vector<cmp::MeshRef>     meshRefs(count);
+    std::vector<cmp::MaterialRef> materialRefs(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        BM_ASSERT(mMeshes.valid(meshes[i]) && materials[i]);
+
+        transforms[i]   = cmp::Transform::from(worlds[i]);
+        bounds[i]       = { mMeshes[meshes[i]].bounds.transformed(worlds[i]) };
+        meshRefs[i]     = { meshes[i] };
+        materialRefs[i] = { materials[i] };
+    }
+
+    mRegistry.insert<cmp::Transform>(added.begin(), added.end(), transforms.begin());
+    mRegistry.insert<cmp::Bounds>(added.begin(), added.end(), bounds.begin());
+    mRegistry.insert<cmp::MeshRef>(added.begin(), added.end(), meshRefs.begin());
+    mRegistry.insert<cmp::MaterialRef>(added.begin(), added.end(), materialRefs.begin());
+
+    for (auto const e : added)
+    {
+        u32 const id = item(e);
+        if (id >= mEntities.size())
+            mEntities.resize(id + 1, sNull);
+
+        mEntities[id] = e;
+    }
+
+    mCount += (u32)count;
+    mVersion = nextVersion();
+
+    // One build over everything beats thousands of loose inserts, each tripping a background rebuild
+    std::vector<math::AABB> boxes(mEntities.size());
+    for (auto [e, transform, box, meshRef, materialRef] : drawables().each()) boxes[item(e)] = box.world;
+
+    mBvh.build(boxes);
+}
+
+//-----------------------------------------------------------------------------
+
+void Scene::remove(Entity e)
+{
+    if (!mRegistry.valid(e))
+        return;
+
+    mBvh.remove(item(e));
+    mEntities[item(e)] = sNull;
+
+    mRegistry.destroy(e);
+    --mCount;
+    mVersion = nextVersion();
+}
+
+//-----------------------------------------------------------------------------
+
+void Scene::move(Entity e, glm::mat4 const &world)
+{
+    auto [transform, bounds, meshRef] = drawables().get<cmp::Transform, cmp::Bounds, cmp::MeshRef>(e);
+
+    transform = cmp::Transform::from(world);
+
+    // A stale mesh keeps its last bounds, it isn't drawn anyway
+    if (auto const *mesh = this->mesh(meshRef.mesh))
+        bounds.world = mesh->bounds.transformed(world);
+
+    mBvh.update(item(e), bounds.world);
+
+    // Past one entry per drawable the list is no cheaper than copying them all
+    if (mMovedAll)
+        return;
+
+    if (mMoved.size() < mCount)
+    {
+        mMoved.push_back(e);
+        return;
+    }
+
+    mMoved.clear();
+    mMovedAll = true;
+}
+
+bool Scene::takeMoved(std::vector<Entity> &moved)
+{
+    moved.clear();
+    std::swap(moved, mMoved);
+
+    return !std::exchange(mMovedAll, false);
+}
+
+//-----------------------------------------------------------------------------
+
+void Scene::clear()
+{
+    mRegistry.clear();
+    mCount   = 0;
+    mVersion = nextVersion();
+    mBvh.clear();
+    mEntities.clear();
+    mMoved.clear();
+    mMovedAll = false;
+
+    mGraph.clear();
+    mNodeFirst.clear();
+    mNodeEntities.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+void Scene::setGraph(SceneGraph graph, std::vector<u32> nodeFirst, std::vector<Entity> nodeEntities)
+{
+    BM_ASSERT(nodeFirst.size() == graph.size() + 1 && nodeFirst.back() == nodeEntities.size());
+
+    mGraph        = std::move(graph);
+    mNodeFirst    = std::move(nodeFirst);
+    mNodeEntities = std::move(nodeEntities);
+}
+
+void Scene::setLocal(u32 node, glm::mat4 const &local)
+{
+    mGraph.setLocal(node, local);
+}
+
+u32 Scene::updateGraph()
+{
+    if (!mGraph.dirty())
+        return 0;
+
+    BM_PROFILE_ZONE("SceneUpdateGraph");
+
+    u32 moved = 0;
+
+    mGraph.update(
+      [&](u32 node, glm::mat4 const &world)
+      {
+          for (u32 i = mNodeFirst[node]; i < mNodeFirst[node + 1]; ++i)
+          {
+              // Removed since, its slot may belong to someone else by now (the version tells)
+              if (!mRegistry.valid(mNodeEntities[i]))
+                  continue;
+
+              move(mNodeEntities[i], world);
+              ++moved;
+          }
+      });
+
+    return moved;
+}
+
+//-----------------------------------------------------------------------------
+
+void Scene::sortForDraw()
+{
+    drawables().sort<cmp::MaterialRef, cmp::MeshRef>(
+      [](auto const &lhs, auto const &rhs)
+      {
+          auto const lMat = std::get<0>(lhs).material, rMat = std::get<0>(rhs).material;
+          return lMat != rMat ? lMat < rMat : std::get<1>(lhs).mesh < std::get<1>(rhs).mesh;
+      });
+
+    mVersion = nextVersion();
+}
+
+//-----------------------------------------------------------------------------
+
+std::vector<u32> const &Scene::cull(math::Frustum const &frustum, std::vector<u32> &visible)
+{
+    BM_PROFILE_ZONE("Cull");
+
+    mBvh.refit();
+
+    visible.clear();
+    visible.reserve(mCount);
+
+    auto const drawables = this->drawables();
+    auto const begin     = drawables.begin();
+
+    mBvh.queryFrustum(frustum, [&](u32 id) { visible.push_back((u32)(drawables.find(mEntities[id]) - begin)); });
+
+    std::sort(visible.begin(), visible.end());
+    return visible;
+}
+
+//-----------------------------------------------------------------------------
+
+u32 Scene::occlude(OcclusionBuffer &buffer, glm::mat4 const &viewproj, std::vector<u32> &visible)
+{
+    BM_PROFILE_ZONE("Occlusion");
+
+    buffer.begin(viewproj);
+
+    auto drawables = this->drawables();
+
+    //--- Occluders : the biggest on screen among meshes cheap enough to rasterize
+
+    float const minArea = sMinOccluderCoverage * float(buffer.width() * buffer.height());
+
+    mOccluders.clear();
+    for (u32 const i : visible)
+    {
+        auto const [bounds, meshRef] = drawables.get<cmp::Bounds, cmp::MeshRef>(drawables[i]);
+        auto const *mesh             = this->mesh(meshRef.mesh);
+        auto const *triangles        = mesh ? mesh->triangles.get() : nullptr;
+
+        if (!triangles || triangles->triangles() > sMaxOccluderTris)
+            continue;
+
+        if (float const area = buffer.screenArea(bounds.world); area >= minArea)
+            mOccluders.push_back({ area, i });
+    }
+
+    auto const count = std::min<size_t>(mOccluders.size(), sMaxOccluders);
+    std::partial_sort(mOccluders.begin(), mOccluders.begin() + count, mOccluders.end(), std::greater<> {});
+
+    u32 budget = sOccluderBudget;
+    for (size_t o = 0; o < count; ++o)
+    {
+        auto const [transform, meshRef] = drawables.get<cmp::Transform, cmp::MeshRef>(drawables[mOccluders[o].second]);
+        auto const &triangles           = *mesh(meshRef.mesh)->triangles;
+
+        if (triangles.triangles() > budget)
+            continue;
+
+        buffer.add(transform.world, triangles.positions(), triangles.indices());
+        budget -= triangles.triangles();
+    }
+
+    if (buffer.triangles() == 0)
+        return 0;
+
+    buffer.render();
+
+    //--- Test : occluders pass their own test, their boxes are never farther than their surface
+
+    auto const before = visible.size();
+    std::erase_if(visible, [&](u32 i) { return !buffer.visible(drawables.get<cmp::Bounds>(drawables[i]).world); });
+
+    return (u32)(before - visible.size());
+}
+
+//-----------------------------------------------------------------------------
+
+Scene::Hit Scene::pick(math::Ray const &ray, float tMax)
+{
+    BM_PROFILE_ZONE("Pick");
+
+    mBvh.refit();
+
+    Hit hit;
+
+    mBvh.queryRay(
+      ray,
+      tMax,
+      [&](u32 id, float tBox, float tLimit)
+      {
+          auto const e                    = mEntities[id];
+          auto const [transform, meshRef] = mRegistry.get<cmp::Transform, cmp::MeshRef>(e);
+          auto const *mesh                = this->mesh(meshRef.mesh);
+          auto const *triangles           = mesh ? mesh->triangles.get() : nullptr;
+
+          if (!triangles)
+          {
+              if (tBox < hit.t)
+                  hit = { e, tBox, ray.at(tBox) };
+
+              return std::min(tLimit, hit.t);
+          }
+
+          // Object space ray : its unnormalized direction scales distances by 'scale'
+          glm::mat4 const inv   = glm::transpose(transform.normal);  // Inverse transpose, transposed back
+          glm::vec3 const dir   = glm::vec3(inv * glm::vec4(ray.dir, 0.f));
+          float const     scale = glm::length(dir);
+
+          if (scale <= 0.f)
+              return tLimit;
+
+          math::Ray const local { glm::vec3(inv * glm::vec4(ray.origin, 1.f)), dir };
+
+          if (auto const h = triangles->raycast(local, tLimit * scale); h && h.t / scale < hit.t)
+              hit = { e, h.t / scale, ray.at(h.t / scale), h.triangle };
+
+          return std::min(tLimit, hit.t);
+      });
+
+    return hit;
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::vk
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "base.hpp"
+#include "types.hpp"
+
+#include "../bm/base.hpp"
+#include "../bm/bvh.hpp"
+#include "../bm/occlusion.hpp"
+#include "../bm/sceneGraph.hpp"
+#include "../bm/utils.hpp"
+
+#include <entt.hpp>
+
+namespace bm::vk
+{
+
+//-----------------------------------------------------------------------------
+
+// Components of a drawable object, plain data so the registry can keep them packed
+namespace cmp
+{
+
+struct Transform
+{
+    glm::mat4 world  = glm::mat4 { 1.f };
+    glm::mat4 normal = glm::mat4 { 1.f };  // Inverse transpose of 'world', computed when it changes, not per frame
+
+    static inline Transform from(glm::mat4 const &world) { return { world, glm::transpose(glm::inverse(world)) }; }
+};
+
+struct Bounds
+{
+    math::AABB world = {};  // Mesh bounds through 'Transform::world'
+};
+
+struct MeshRef
+{
+    MeshHandle mesh = {};
+};
+
+struct MaterialRef
+{
+    MaterialHandle material = {};
+};
+
+}  // namespace cmp
+
+//-----------------------------------------------------------------------------
+
+// Scene storage on an EnTT registry.
+// Every drawable belongs to one owning group, so its components live in parallel packed arrays sorted the same way :
+// position 'i' of the group is the same object on every array, extraction walks them linearly, and add / remove
+// (swap-and-pop) / move are O(1). Positions are only stable until the next add, remove or 'sortForDraw'.
+// World bounds are mirrored on a BVH keyed by entity index, kept in sync by add / remove / move.
+// Meshes and materials are held by handle : a drawable whose mesh was removed from the pool is skipped, not dangling.
+// Imported hierarchies keep their 'SceneGraph' : moving a node moves the drawables of its subtree, nothing else.
+class Scene
+{
+public:
+    using Entity = entt::entity;
+
+    static constexpr Entity sNull = entt::null;
+
+    struct Hit
+    {
+        Entity    entity   = sNull;
+        float     t        = INF;             // Along the world space ray
+        glm::vec3 point    = ZERO3;           // World space
+        u32       triangle = MeshBvh::sNone;  // Of the entity's mesh, none if it has no CPU triangles (box hit)
+
+        inline explicit operator bool() const { return entity != sNull; }
+    };
+
+    explicit Scene(ds::HandlePool<Mesh> const &meshes);
+
+    Scene(Scene const &)            = delete;
+    Scene &operator=(Scene const &) = delete;
+
+    Entity add(MeshHandle mesh, MaterialHandle material, glm::mat4 const &world = glm::mat4 { 1.f });
+    // Whole scenes at once (loading) : one insert per component array and a single BVH build, same size views.
+    // Packed positions follow the input order
+    void   add(ds::view<MeshHandle> meshes, ds::view<MaterialHandle> materials, ds::view<glm::mat4> worlds);
+    void   remove(Entity e);
+    void   move(Entity e, glm::mat4 const &world);  // Also refreshes the bounds
+    void   clear();
+
+    // Groups draws by material and mesh so consecutive ones share binds, worth it after big batches of adds
+    void sortForDraw();
+
+    // Node 'n' of 'graph' drives the drawables 'nodeEntities[nodeFirst[n], nodeFirst[n + 1])', already added at its
+    // world matrix. Replaces the previous graph, 'clear' drops it
+    void setGraph(SceneGraph graph, std::vector<u32> nodeFirst, std::vector<Entity> nodeEntities);
+    void setLocal(u32 node, glm::mat4 const &local);  // Applied by the next 'updateGraph'
+    // Moves the drawables of the subtrees whose local changed (transform, bounds and BVH), returns how many moved.
+    // Nothing to do when no node changed, call it once per frame before culling
+    u32  updateGraph();
+
+    inline SceneGraph const &graph() const { return mGraph; }
+
+    // Packed positions of the drawables touching 'frustum', ascending so draws keep the 'sortForDraw' grouping.
+    // Refits the BVH first, call it once per frame from the thread that owns the scene
+    std::vector<u32> const &cull(math::Frustum const &frustum, std::vector<u32> &visible);
+
+    // Drops from 'visible' the drawables hidden behind the biggest ones on screen, rasterized into 'buffer' first.
+    // Returns how many were dropped
+    u32 occlude(OcclusionBuffer &buffer, glm::mat4 const &viewproj, std::vector<u32> &visible);
+
+    // Closest drawable along 'ray' : scene BVH down to candidates, then their mesh triangles in object space
+    Hit pick(math::Ray const &ray, float tMax = INF);
+
+    inline bool valid(Entity e) const { return mRegistry.valid(e); }
+    inline u32  size() const { return mCount; }
+
+    // Changes on add, remove, clear and 'sortForDraw' : packed positions hold while it does. Unique across scenes, so
+    // data copied by position out of one scene never passes for another's
+    inline u64 version() const { return mVersion; }
+    // Swaps into 'moved' the drawables moved since the last call, for persistent copies of their transforms. They may
+    // repeat or be gone by now. False when they overflowed the list : take everything as moved
+    bool takeMoved(std::vector<Entity> &moved);
+
+    // Packed view of every drawable : 'for (auto [e, transform, bounds, meshRef, materialRef] : drawables().each())'
+    inline auto drawables() { return mRegistry.group<cmp::Transform, cmp::Bounds, cmp::MeshRef, cmp::MaterialRef>(); }
+
+    inline Bvh const &bvh() const { return mBvh; }
+    inline Entity     entity(u32 item) const { return item < mEntities.size() ? mEntities[item] : sNull; }
+
+    inline entt::registry       &registry() { return mRegistry; }
+    inline entt::registry const &registry() const { return mRegistry; }
+
+private:
+    static constexpr u32   sMaxOccluders        = 32;
+    static constexpr u32   sMaxOccluderTris     = 4'096;   // Per occluder, denser meshes are only tested
+    static constexpr u32   sOccluderBudget      = 16'384;  // Triangles rasterized per frame
+    static constexpr float sMinOccluderCoverage = 0.01f;   // Of the occlusion buffer
+
+    static inline u32  item(Entity e) { return (u32)entt::to_entity(e); }
+    static u64         nextVersion();
+    inline Mesh const *mesh(MeshHandle handle) const { return mMeshes.get(handle); }  // Null when stale
+
+    ds::HandlePool<Mesh> const &mMeshes;  // Owned by the renderer
+
+    entt::registry      mRegistry = {};
+    u32                 mCount    = 0;
+    u64                 mVersion  = 0;
+    Bvh                 mBvh      = {};
+    std::vector<Entity> mEntities = {};  // BVH item to entity, versions included
+
+    std::vector<Entity> mMoved    = {};     // Since the last 'takeMoved', up to one per drawable
+    bool                mMovedAll = false;  // 'mMoved' overflowed
+
+    SceneGraph          mGraph        = {};
+    std::vector<u32>    mNodeFirst    = {};  // Per node (plus one) : first of its drawables on 'mNodeEntities'
+    std::vector<Entity> mNodeEntities = {};
+
+    std::vector<std::pair<float, u32>> mOccluders = {};  // Scratch of 'occlude' : screen area, packed position
+};
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::vk
@@ -0,0 +1,148 @@
+#include "timeline.hpp"
+#include "init.hpp"
+#include "str.hpp"
+
+namespace bm::vk
+{
+
+//-----------------------------------------------------------------------------
+
+void Timeline::init(VkDevice device, u64 initialValue)
+{
+    mDevice = device;
+    mLast   = initialValue;
+
+    VkSemaphoreTypeCreateInfo typeCI = {};
+    typeCI.sType                     = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeCI.semaphoreType             = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeCI.initialValue              = initialValue;
+
+    auto const semaphoreCI = vk::CreateInfo::Semaphore(&typeCI);
+    BMVK_CHECK(vkCreateSemaphore(mDevice, &semaphoreCI, nullptr, &mSemaphore));
+}
+
+//-----------------------------------------------------------------------------
+
+void Timeline::cleanup()
+{
+    if (!mDevice)
+        return;
+
+    mRetired.flush();
+
+    vkDestroySemaphore(mDevice, mSemaphore, nullptr);
+
+    *this = {};
+}
+
+//-----------------------------------------------------------------------------
+
+u64 Timeline::completed() const
+{
+    u64 value = 0;
+    BMVK_CHECK(vkGetSemaphoreCounterValue(mDevice, mSemaphore, &value));
+    return value;
+}
+
+//-----------------------------------------------------------------------------
+
+bool Timeline::wait(u64 value, u64 timeout) const
+{
+    VkSemaphoreWaitInfo info = {};
+    info.sType               = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    info.semaphoreCount      = 1;
+    info.pSemaphores         = &mSemaphore;
+    info.pValues             = &value;
+
+    auto const res = vkWaitSemaphores(mDevice, &info, timeout);
+    if (res == VK_TIMEOUT)
+        return false;
+
+    BMVK_CHECK(res);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void Timeline::signal(u64 value)
+{
+    VkSemaphoreSignalInfo info = {};
+    info.sType                 = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO;
+    info.semaphore             = mSemaphore;
+    info.value                 = value;
+
+    BMVK_CHECK(vkSignalSemaphore(mDevice, &info));
+    mLast = std::max(mLast, value);
+}
+
+//-----------------------------------------------------------------------------
+
+void Timeline::collect()
+{
+    if (mRetired.empty())
+        return;
+
+    mRetired.collect(completed());
+}
+
+//-----------------------------------------------------------------------------
+
+Submission &Submission::cmd(VkCommandBuffer cmd)
+{
+    mCmds.push_back(cmd);
+    return *this;
+}
+
+Submission &Submission::wait(VkSemaphore semaphore, VkPipelineStageFlags stage, u64 value)
+{
+    mWaits.push_back(semaphore);
+    mWaitStages.push_back(stage);
+    mWaitValues.push_back(value);
+    return *this;
+}
+
+Submission &Submission::wait(Timeline const &timeline, u64 value, VkPipelineStageFlags stage)
+{
+    return wait(timeline.handle(), stage, value);
+}
+
+Submission &Submission::signal(VkSemaphore semaphore, u64 value)
+{
+    mSignals.push_back(semaphore);
+    mSignalValues.push_back(value);
+    return *this;
+}
+
+Submission &Submission::signal(Timeline const &timeline, u64 value)
+{
+    return signal(timeline.handle(), value);
+}
+
+//-----------------------------------------------------------------------------
+
+VkResult Submission::submit(VkQueue queue, VkFence fence) const
+{
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+    timelineInfo.sType                         = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount       = (u32)mWaitValues.size();
+    timelineInfo.pWaitSemaphoreValues          = mWaitValues.data();
+    timelineInfo.signalSemaphoreValueCount     = (u32)mSignalValues.size();
+    timelineInfo.pSignalSemaphoreValues        = mSignalValues.data();
+
+    VkSubmitInfo info         = {};
+    info.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    info.pNext                = &timelineInfo;
+    info.waitSemaphoreCount   = (u32)mWaits.size();
+    info.pWaitSemaphores      = mWaits.data();
+    info.pWaitDstStageMask    = mWaitStages.data();
+    info.signalSemaphoreCount = (u32)mSignals.size();
+    info.pSignalSemaphores    = mSignals.data();
+    info.commandBufferCount   = (u32)mCmds.size();
+    info.pCommandBuffers      = mCmds.data();
+
+    return vkQueueSubmit(queue, 1, &info, fence);
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::vk
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "base.hpp"
+#include "types.hpp"
+
+#include "../bm/base.hpp"
+#include "../bm/utils.hpp"
+
+#include <vector>
+
+namespace bm::vk
+{
+
+//-----------------------------------------------------------------------------
+
+// Timeline semaphore : a GPU-side counter that only moves forward.
+// Every submit signals a new value, the CPU (or another queue) waits for a value instead of juggling fences.
+// @note : Signals on one timeline must be issued in increasing order, so each queue owns its own timeline and
+//         cross-queue dependencies are expressed as waits on the other queue's timeline.
+class Timeline
+{
+public:
+    using fnType = bm::ds::RetireQueue::fnType;  // Inline storage, retiring never allocates per callback
+
+    void init(VkDevice device, u64 initialValue = 0);
+    void cleanup();  // Runs every pending retiree, the device must be idle
+
+    // Value reserved for the next signal, greater than every previous one
+    inline u64 next() { return ++mLast; }
+    // Last value handed out, reached once everything submitted so far has finished
+    inline u64 last() const { return mLast; }
+
+    u64  completed() const;
+    bool reached(u64 value) const { return value <= completed(); }
+    bool wait(u64 value, u64 timeout = UINT64_MAX) const;  // False on timeout
+    void signal(u64 value);                                // From the host
+
+    // Run 'fn' once the GPU reaches 'value' (checked on 'collect')
+    template<typename F>
+    void retire(u64 value, F &&fn)
+    {
+        mRetired.push(value, std::forward<F>(fn));
+    }
+    void collect();
+
+    inline VkSemaphore handle() const { return mSemaphore; }
+
+private:
+    VkDevice            mDevice    = VK_NULL_HANDLE;
+    VkSemaphore         mSemaphore = VK_NULL_HANDLE;
+    u64                 mLast      = 0;
+    bm::ds::RetireQueue mRetired   = {};
+};
+
+//-----------------------------------------------------------------------------
+
+// Builder for one 'vkQueueSubmit' mixing binary and timeline semaphores (binary ones ignore their value)
+class Submission
+{
+public:
+    Submission &cmd(VkCommandBuffer cmd);
+
+    Submission &wait(VkSemaphore semaphore, VkPipelineStageFlags stage, u64 value = 0);
+    Submission &wait(Timeline const &timeline, u64 value, VkPipelineStageFlags stage);
+
+    Submission &signal(VkSemaphore semaphore, u64 value = 0);
+    Submission &signal(Timeline const &timeline, u64 value);
+
+    VkResult submit(VkQueue queue, VkFence fence = VK_NULL_HANDLE) const;
+
+private:
+    std::vector<VkCommandBuffer>      mCmds         = {};
+    std::vector<VkSemaphore>          mWaits        = {};
+    std::vector<VkPipelineStageFlags> mWaitStages   = {};
+    std::vector<u64>                  mWaitValues   = {};
+    std::vector<VkSemaphore>          mSignals      = {};
+    std::vector<u64>                  mSignalValues = {};
+};
+
+//-----------------------------------------------------------------------------
+
+}  // namespace bm::vk
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "../bm/base.hpp"
+#include "../bm/handlePool.hpp"
+#include "../bm/meshBvh.hpp"
+#include "../bm/utils.hpp"
 #include "base.hpp"
 
 #include <vma/vk_mem_alloc.h>
@@ -91,21 +94,7 @@ struct VertexInputDescription
 
     VkPipelineVertexInputStateCreateFlags flags = 0;
 
-    static VertexInputDescription const &get()
-    {
-        static auto const desc = []()
-        {
-            VertexInputDescription D;
-            D.bindings.push_back({ 0, sizeof(float) * (3 + 2 + 3 + 4), VK_VERTEX_INPUT_RATE_VERTEX });
-            D.attributes.push_back({ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 });     // pos
-            D.attributes.push_back({ 1, 0, VK_FORMAT_R32G32_SFLOAT, 0 });        // uv0
-            D.attributes.push_back({ 2, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 });     // normal
-            D.attributes.push_back({ 3, 0, VK_FORMAT_R32G32B32A32_SFLOAT, 0 });  // tangent
-            return D;
-        }();
-
-        return desc;
-    }
+    // @note : Filled from the vertex shader by reflection (see ShaderReflection)
 };
 
 //-----------------------------------------------------------------------------
@@ -113,7 +102,8 @@ struct VertexInputDescription
 struct Queue
 {
     Queue() = default;
-    Queue(vkb::Device vkbDevice, vkb::QueueType aType)
+    // Not 'required' : the caller falls back to another queue (e.g. single-family devices like lavapipe)
+    Queue(vkb::Device vkbDevice, vkb::QueueType aType, bool required = true)
     {
         type         = aType;
         auto const q = vkbDevice.get_queue(aType);
@@ -123,7 +113,7 @@ struct Queue
             queue  = q.value();
             family = f.value();
         }
-        BM_ASSERT(valid);
+        BM_ASSERT(valid || !required);
     }
 
     VkQueue        queue  = {};
@@ -166,6 +156,10 @@ struct Mesh
     u32             indexCount = 0;
     AllocatedBuffer indices    = {};
     AllocatedBuffer vertices   = {};
+    u32             features   = 0;  // ShaderFeature bits this geometry can feed (e.g. HasTangent)
+    math::AABB      bounds     = {};  // Object space, of the vertex positions
+
+    sPtr<MeshBvh const> triangles = nullptr;  // CPU side copy for exact ray casts (picking)
 
     // ROOM TO IMPROVEMENT : https://developer.nvidia.com/vulkan-memory-management
 
@@ -185,9 +179,10 @@ struct Mesh
         vkCmdBindIndexBuffer(cmd, indices.buffer, 0, VK_INDEX_TYPE_UINT16);
     }
 
-    inline void draw(VkCommandBuffer cmd) const
+    // 'firstInstance' doubles as the object index on the bindless path (gl_InstanceIndex)
+    inline void draw(VkCommandBuffer cmd, u32 firstInstance = 0) const
     {  //
-        vkCmdDrawIndexed(cmd, indexCount, 1, 0, 0, 0);
+        vkCmdDrawIndexed(cmd, indexCount, 1, 0, 0, firstInstance);
     }
 
     inline void bindNdraw(VkCommandBuffer cmd) const
@@ -201,22 +196,22 @@ using MeshGroup = std::vector<Mesh>;
 
 //-----------------------------------------------------------------------------
 
+class PermutationCache;
+
 struct Material
 {
-    VkPipeline       pipeline;
-    VkPipelineLayout pipelineLayout;
+    VkPipeline        pipeline;
+    VkPipelineLayout  pipelineLayout;
+    PermutationCache *permutations = nullptr;  // When set, 'pipeline' is picked per draw from the specialized variants
 
     inline void bind(VkCommandBuffer cmd) { vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline); }
 };
 
 //-----------------------------------------------------------------------------
 
-struct RenderObject
-{
-    Mesh     *mesh;
-    Material *material;
-    glm::mat4 transform;
-};
+// What scenes hold instead of pointers, resolved through the renderer's pools
+using MeshHandle     = ds::Handle<Mesh>;
+using MaterialHandle = ds::Handle<Material>;
 
 //-----------------------------------------------------------------------------
 
@@ -243,26 +238,40 @@ struct FrameData
 
     VkSemaphore presentSemaphore = VK_NULL_HANDLE;
     VkSemaphore renderSemaphore  = VK_NULL_HANDLE;
-    VkFence     renderFence      = VK_NULL_HANDLE;
+    u64         renderValue      = 0;  // Graphics-timeline value signalled by the last submit of this slot
 
     vk::QueueCmd graphics = {};
     vk::QueueCmd present  = {};
     vk::QueueCmd compute  = {};
     vk::QueueCmd transfer = {};
 
+    VkCommandBuffer graphicsScene = VK_NULL_HANDLE;  // Secondary, low-latency mode records the scene here before acquire
+
     VkDescriptorSet descSet = VK_NULL_HANDLE;
     AllocatedBuffer camera  = {};
+
+    // Bindless only : per-object data of this frame, reached from the shaders through 'objectsIdx'. Persistent : only
+    // what moved since this slot last drew is written, unless the scene (its 'version') changed under it
+    AllocatedBuffer  objects         = {};
+    u32              objectsCapacity = 0;
+    u32              objectsIdx      = ~0u;
+    u64              objectsVersion  = 0;   // 'Scene::version' of the contents, 0 : rewrite everything
+    std::vector<u32> objectsMoved    = {};  // Entities moved since then, as 'entt::to_integral'
+
+    // GPU culling only : world bounds of the same objects, see 'GpuCulling::Object'
+    AllocatedBuffer bounds    = {};
+    u32             boundsIdx = ~0u;
 };
 
 //-----------------------------------------------------------------------------
 
 struct SceneData
 {
-    glm::vec4 fogColor;      // w is for exponent
-    glm::vec4 fogDistances;  // x for min, y for max, zw unused.
-    glm::vec4 ambientColor;
-    glm::vec4 sunlightDirection;  // w for sun power
-    glm::vec4 sunlightColor;
+    glm::vec4 fogColor          = { 0.05f, 0.07f, 0.09f, 1.f };  // w is for exponent
+    glm::vec4 fogDistances      = { 10.f, 40.f, 0.f, 0.f };      // x for min, y for max, zw unused. (max <= min : off)
+    glm::vec4 ambientColor      = {};
+    glm::vec4 sunlightDirection = { -0.5f, -1.f, 0.3f, 1.f };  // w for sun power (0 : off)
+    glm::vec4 sunlightColor     = { 1.f, 0.95f, 0.85f, 1.f };
 };
 
 //-----------------------------------------------------------------------------
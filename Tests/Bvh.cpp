@@ -0,0 +1,267 @@
+#include "Bretema/bm/bvh.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <random>
+#include <thread>
+
+using namespace bm;
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+struct World
+{
+    std::mt19937            rng { 1234 };
+    std::vector<math::AABB> boxes;
+    std::vector<u8>         alive;
+
+    math::AABB randomBox()
+    {
+        std::uniform_real_distribution<float> pos { -50.f, 50.f };
+        std::uniform_real_distribution<float> size { 0.5f, 3.f };
+
+        glm::vec3 const c { pos(rng), pos(rng), pos(rng) };
+        glm::vec3 const e { size(rng), size(rng), size(rng) };
+
+        math::AABB box;
+        box.expand(c - e);
+        box.expand(c + e);
+        return box;
+    }
+
+    u32 randomItem() { return std::uniform_int_distribution<u32> { 0, (u32)boxes.size() - 1 }(rng); }
+
+    void set(u32 item, math::AABB const &box)
+    {
+        if (item >= boxes.size())
+        {
+            boxes.resize(item + 1);
+            alive.resize(item + 1, 0);
+        }
+        boxes[item] = box;
+        alive[item] = 1;
+    }
+};
+
+std::vector<u32> sorted(std::vector<u32> v)
+{
+    std::sort(v.begin(), v.end());
+    return v;
+}
+
+// Every query against a linear scan of the same boxes, duplicates included
+void checkQueries(Bvh const &bvh, World &world)
+{
+    u32 expectedAlive = 0;
+    for (u8 const a : world.alive) expectedAlive += a;
+    REQUIRE(bvh.size() == expectedAlive);
+
+    for (int q = 0; q < 8; ++q)
+    {
+        // Overlap
+        math::AABB const area = world.randomBox().transformed(glm::scale(glm::mat4 { 1.f }, glm::vec3 { 4.f }));
+
+        std::vector<u32> got, expected;
+        bvh.queryOverlap(area, [&](u32 item) { got.push_back(item); });
+        for (u32 i = 0; i < world.boxes.size(); ++i)
+            if (world.alive[i] && world.boxes[i].overlaps(area))
+                expected.push_back(i);
+        CHECK(sorted(got) == expected);
+
+        // Frustum
+        glm::vec3 const eye  = world.randomBox().center();
+        glm::vec3 const at   = world.randomBox().center();
+        glm::mat4 const view = glm::lookAt(eye, at + glm::vec3 { 0.f, 0.f, 0.01f }, glm::vec3 { 0.f, 1.f, 0.f });
+
+        math::Frustum const frustum { glm::perspective(glm::radians(60.f), 1.5f, 0.1f, 60.f) * view };
+
+        got.clear();
+        expected.clear();
+        bvh.queryFrustum(frustum, [&](u32 item) { got.push_back(item); });
+        for (u32 i = 0; i < world.boxes.size(); ++i)
+            if (world.alive[i] && frustum.test(world.boxes[i]) != math::Frustum::Outside)
+                expected.push_back(i);
+        CHECK(sorted(got) == expected);
+
+        // Ray, every hit and then the closest one
+        math::Ray const ray { eye, at - eye };
+
+        got.clear();
+        expected.clear();
+        float nearest = INF;
+        bvh.queryRay(
+          ray,
+          INF,
+          [&](u32 item, float, float tMax)
+          {
+              got.push_back(item);
+              return tMax;
+          });
+        for (u32 i = 0; i < world.boxes.size(); ++i)
+            if (float const t = world.alive[i] ? ray.hit(world.boxes[i]) : INF; t < INF)
+            {
+                expected.push_back(i);
+                nearest = std::min(nearest, t);
+            }
+        CHECK(sorted(got) == expected);
+        CHECK(bvh.queryRay(ray, INF, [](u32, float t, float) { return t; }) == nearest);
+    }
+}
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+TEST_CASE("Queries on a built tree match a linear scan", "[bvh]")
+{
+    World world;
+    for (u32 i = 0; i < 1000; ++i) world.set(i, world.randomBox());
+
+    // Empty boxes are left out
+    world.boxes[10] = {};
+    world.alive[10] = 0;
+
+    Bvh bvh;
+    bvh.build(world.boxes);
+    CHECK_FALSE(bvh.rebuilding());
+    CHECK(bvh.quality() == 1.f);
+
+    checkQueries(bvh, world);
+}
+
+TEST_CASE("Queries stay exact through inserts, moves and removes", "[bvh]")
+{
+    World world;
+    for (u32 i = 0; i < 500; ++i) world.set(i, world.randomBox());
+
+    Bvh bvh;
+    bvh.build(world.boxes);
+
+    for (int round = 0; round < 20; ++round)
+    {
+        for (int op = 0; op < 30; ++op)
+        {
+            u32 const item = world.randomItem();
+
+            if (!world.alive[item])
+            {
+                world.set(item, world.randomBox());
+                bvh.insert(item, world.boxes[item]);
+            }
+            else if (op % 3 == 0)
+            {
+                world.alive[item] = 0;
+                bvh.remove(item);
+            }
+            else
+            {
+                world.set(item, world.randomBox());
+                bvh.update(item, world.boxes[item]);
+            }
+        }
+
+        // New ids past the end, loose until a rebuild takes them
+        u32 const next = (u32)world.boxes.size();
+        world.set(next, world.randomBox());
+        bvh.insert(next, world.boxes[next]);
+
+        bvh.refit();  // Moved leaves are stale until then
+        checkQueries(bvh, world);
+    }
+
+    // Let the last rebuild land
+    while (bvh.rebuilding())
+    {
+        std::this_thread::yield();
+        bvh.refit();
+    }
+    checkQueries(bvh, world);
+}
+
+TEST_CASE("A background rebuild is adopted with what changed meanwhile", "[bvh]")
+{
+    World world;
+    for (u32 i = 0; i < 200; ++i) world.set(i, world.randomBox());
+
+    Bvh bvh;
+    bvh.build(world.boxes);
+
+    // More loose items than allowed : the refit starts a rebuild from a snapshot of the boxes
+    for (u32 i = 0; i <= Bvh::sMaxLoose; ++i)
+    {
+        u32 const item = (u32)world.boxes.size();
+        world.set(item, world.randomBox());
+        bvh.insert(item, world.boxes[item]);
+    }
+    bvh.refit();
+    REQUIRE(bvh.rebuilding());
+
+    // Everything done now postdates the snapshot, whether the worker already finished or not
+    for (u32 i = 0; i < 20; ++i)
+    {
+        u32 const moved = world.randomItem();
+        if (world.alive[moved])
+        {
+            world.set(moved, world.randomBox());
+            bvh.update(moved, world.boxes[moved]);
+        }
+    }
+    for (u32 const removed : { 3u, 150u, 210u })
+    {
+        world.alive[removed] = 0;
+        bvh.remove(removed);
+    }
+    for (u32 i = 0; i < 5; ++i)
+    {
+        u32 const item = (u32)world.boxes.size();
+        world.set(item, world.randomBox());
+        bvh.insert(item, world.boxes[item]);
+    }
+    bvh.refit();  // Refits the old tree, or adopts the new one if it's already done
+    checkQueries(bvh, world);
+
+    // Adopting replays the moves and removes on the new tree, and keeps the new items loose
+    while (bvh.rebuilding())
+    {
+        std::this_thread::yield();
+        bvh.refit();
+    }
+    checkQueries(bvh, world);
+
+    // One more round of changes on the adopted tree
+    for (u32 i = 0; i < 20; ++i)
+    {
+        u32 const moved = world.randomItem();
+        if (world.alive[moved])
+        {
+            world.set(moved, world.randomBox());
+            bvh.update(moved, world.boxes[moved]);
+        }
+    }
+    bvh.refit();
+    checkQueries(bvh, world);
+}
+
+TEST_CASE("Clearing drops every item and any pending rebuild", "[bvh]")
+{
+    World world;
+    for (u32 i = 0; i < 100; ++i) world.set(i, world.randomBox());
+
+    Bvh bvh;
+    for (u32 i = 0; i < 100; ++i) bvh.insert(i, world.boxes[i]);
+    bvh.refit();  // An empty tree with loose items always rebuilds
+    CHECK(bvh.rebuilding());
+
+    bvh.clear();
+    CHECK(bvh.empty());
+    CHECK_FALSE(bvh.rebuilding());
+
+    math::AABB everything;
+    everything.expand(glm::vec3 { -100.f });
+    everything.expand(glm::vec3 { 100.f });
+
+    u32 hits = 0;
+    bvh.queryOverlap(everything, [&](u32) { ++hits; });
+    CHECK(hits == 0);
+}
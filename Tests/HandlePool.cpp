@@ -0,0 +1,103 @@
+#include "Bretema/bm/handlePool.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace bm;
+
+//-----------------------------------------------------------------------------
+
+TEST_CASE("A removed item's handle turns stale, also once its slot is reused", "[handlePool]")
+{
+    ds::HandlePool<int> pool;
+
+    auto const a = pool.add(1, ds::stableId("a"));
+    auto const b = pool.add(2, ds::stableId("b"));
+    REQUIRE(pool.size() == 2);
+    REQUIRE(pool.valid(a));
+    CHECK(pool[a] == 1);
+    CHECK(pool[b] == 2);
+
+    REQUIRE(pool.remove(a));
+    CHECK_FALSE(pool.valid(a));
+    CHECK(pool.get(a) == nullptr);
+    CHECK_FALSE(pool.remove(a));  // Already stale
+    CHECK(pool.size() == 1);
+
+    // Same slot, next generation : the old handle must not alias the new item
+    auto const c = pool.add(3, ds::stableId("c"));
+    CHECK(c.index == a.index);
+    CHECK(c.generation == a.generation + 1);
+    CHECK(c != a);
+    CHECK(pool.get(a) == nullptr);
+    REQUIRE(pool.get(c) != nullptr);
+    CHECK(*pool.get(c) == 3);
+
+    CHECK(pool.capacity() == 2);  // Reused, not grown
+    CHECK(pool[b] == 2);          // Untouched
+}
+
+TEST_CASE("Default handles are never valid", "[handlePool]")
+{
+    ds::HandlePool<int> pool;
+    pool.add(1, ds::stableId("a"));
+
+    ds::Handle<int> const none;
+    CHECK_FALSE(none);
+    CHECK_FALSE(pool.valid(none));
+    CHECK(pool.get(none) == nullptr);
+}
+
+TEST_CASE("Lookups by id and name follow adds and removes", "[handlePool]")
+{
+    ds::HandlePool<int> pool;
+
+    auto const id = ds::stableId("cube#0");
+    auto const h  = pool.add(7, id, "cube");
+
+    CHECK(pool.find(id) == h);
+    CHECK(pool.find(StrId("cube")) == h);
+    CHECK(pool.id(h) == id);
+    CHECK(pool.name(h) == "cube");
+
+    pool.remove(h);
+    CHECK_FALSE(pool.find(id));
+    CHECK_FALSE(pool.find(StrId("cube")));
+
+    // The name moves to whoever takes it next
+    auto const again = pool.add(8, ds::stableId("cube#1"), "cube");
+    CHECK(pool.find(StrId("cube")) == again);
+}
+
+TEST_CASE("Stable ids only depend on the key", "[handlePool]")
+{
+    CHECK(ds::stableId("mesh#0") == ds::stableId("mesh#0"));
+    CHECK(ds::stableId("mesh#0") != ds::stableId("mesh#1"));
+    CHECK(ds::stableId("") != ds::stableId("mesh#0"));
+}
+
+TEST_CASE("Each and clear only touch live items", "[handlePool]")
+{
+    ds::HandlePool<int> pool;
+
+    auto const a = pool.add(1, ds::stableId("a"));
+    auto const b = pool.add(2, ds::stableId("b"));
+    auto const c = pool.add(3, ds::stableId("c"));
+    pool.remove(b);
+
+    int sum   = 0;
+    int count = 0;
+    pool.each(
+      [&](ds::Handle<int> handle, int &item)
+      {
+          CHECK(pool.valid(handle));
+          sum += item;
+          ++count;
+      });
+    CHECK(count == 2);
+    CHECK(sum == 4);
+
+    pool.clear();
+    CHECK(pool.size() == 0);
+    CHECK_FALSE(pool.valid(a));
+    CHECK_FALSE(pool.valid(c));
+}
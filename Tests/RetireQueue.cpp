@@ -0,0 +1,151 @@
+#include "Bretema/bm/utils.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+
+using namespace bm;
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+// Counts how many copies of it are alive, so leaks and double destructions show up
+struct Tracked
+{
+    int *alive = nullptr;
+
+    explicit Tracked(int *alive) : alive(alive) { ++*alive; }
+    Tracked(Tracked &&other) noexcept : alive(other.alive) { ++*alive; }
+    ~Tracked() { --*alive; }
+};
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+TEST_CASE("InplaceFunction calls, moves and destroys its callable once", "[retireQueue]")
+{
+    int alive = 0;
+    int calls = 0;
+
+    {
+        ds::InplaceFunction<int(int)> fn = [t = Tracked(&alive), &calls](int x)
+        {
+            ++calls;
+            return x * 2;
+        };
+        REQUIRE(fn);
+        CHECK(alive == 1);
+        CHECK(fn(21) == 42);
+
+        auto moved = std::move(fn);
+        CHECK_FALSE(fn);
+        REQUIRE(moved);
+        CHECK(alive == 1);  // Relocated, not copied
+        CHECK(moved(1) == 2);
+
+        moved.reset();
+        CHECK_FALSE(moved);
+        CHECK(alive == 0);
+    }
+
+    CHECK(alive == 0);
+    CHECK(calls == 2);
+
+    ds::InplaceFunction<void()> empty = nullptr;
+    CHECK_FALSE(empty);
+}
+
+TEST_CASE("RetireQueue runs entries once their timeline value is reached", "[retireQueue]")
+{
+    ds::RetireQueue  queue;
+    std::vector<u64> ran;
+
+    for (u64 v : { 1, 2, 2, 3, 5 })
+        queue.push(v, [&ran, v] { ran.push_back(v); });
+    REQUIRE(queue.size() == 5);
+
+    CHECK(queue.collect(0) == 0);
+    CHECK(ran.empty());
+
+    CHECK(queue.collect(2) == 3);
+    CHECK(ran == std::vector<u64> { 1, 2, 2 });
+    CHECK(queue.size() == 2);
+
+    CHECK(queue.collect(2) == 0);  // Nothing new is done
+    CHECK(queue.collect(4) == 1);
+    CHECK(ran.back() == 3);
+
+    queue.flush();
+    CHECK(ran.back() == 5);
+    CHECK(queue.empty());
+}
+
+TEST_CASE("RetireQueue never runs an entry early", "[retireQueue]")
+{
+    ds::RetireQueue  queue;
+    std::vector<u64> ran;
+
+    // Out of order : the later value holds back the earlier one, never the other way around
+    queue.push(4, [&ran] { ran.push_back(4); });
+    queue.push(2, [&ran] { ran.push_back(2); });
+
+    CHECK(queue.collect(3) == 0);
+    CHECK(ran.empty());
+
+    CHECK(queue.collect(4) == 2);
+    CHECK(ran == std::vector<u64> { 4, 2 });
+}
+
+TEST_CASE("RetireQueue callbacks may push new entries", "[retireQueue]")
+{
+    ds::RetireQueue queue;
+    int             ran = 0;
+
+    queue.push(
+      1,
+      [&]
+      {
+          ++ran;
+          queue.push(1, [&] { ++ran; });  // Already due, runs within the same collect
+          queue.push(9, [&] { ++ran; });
+      });
+
+    CHECK(queue.collect(1) == 2);
+    CHECK(ran == 2);
+    CHECK(queue.size() == 1);
+
+    queue.flush();
+    CHECK(ran == 3);
+}
+
+TEST_CASE("RetireQueue releases what the callbacks captured", "[retireQueue]")
+{
+    int alive = 0;
+
+    {
+        ds::RetireQueue queue;
+        for (u64 v = 1; v <= 100; ++v)
+            queue.push(v, [t = Tracked(&alive)] {});
+        CHECK(alive == 100);
+
+        queue.collect(70);  // Runs and compacts the consumed prefix
+        CHECK(alive == 30);
+        CHECK(queue.size() == 30);
+    }
+
+    CHECK(alive == 0);  // Pending ones go with the queue
+}
+
+TEST_CASE("DeletionQueue flushes in reverse order", "[retireQueue]")
+{
+    ds::DeletionQueue queue;
+    std::vector<int>  order;
+
+    for (int i = 0; i < 3; ++i)
+        queue.add([&order, i] { order.push_back(i); });
+
+    queue.flush();
+    CHECK(order == std::vector<int> { 2, 1, 0 });
+    CHECK(queue.empty());
+}
@@ -0,0 +1,221 @@
+#include "Bretema/bm/sceneFile.hpp"
+#include "Bretema/bm/transform.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+
+using namespace bm;
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+std::string tempPath(std::string const &name)
+{
+    return (std::filesystem::temp_directory_path() / ("bm_test_" + name)).string();
+}
+
+std::vector<char> readBytes(std::string const &path)
+{
+    std::ifstream in { path, std::ios::binary };
+    return { std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+}
+
+void writeBytes(std::string const &path, std::vector<char> const &bytes)
+{
+    std::ofstream out { path, std::ios::binary | std::ios::trunc };
+    out.write(bytes.data(), (std::streamsize)bytes.size());
+}
+
+// Something of everything : ids and nil ids, an optional source, a TRS object and one that is not (sheared)
+SceneFile makeFile()
+{
+    SceneFile file;
+
+    file.meshes.push_back({ "cube", 0, "Assets/cube.gltf", ds::stableId("cube#0") });
+    file.meshes.push_back({ "helmet", 2, "", {} });
+    file.materials.push_back({ "default", ds::stableId("default") });
+    file.materials.push_back({ "glass", {} });
+    file.cameras.emplace_back("Main", glm::vec3 { 1.f, 2.f, 3.f }, glm::vec3 { 0.f, 1.f, 0.f }, Camera::Mode::Orb, 60.f);
+
+    glm::mat4 sheared { 1.f };
+    sheared[1][0] = 0.5f;
+
+    file.mesh     = { 0, 1, 1 };
+    file.material = { 1, 0, 1 };
+    file.world    = {
+        glm::mat4 { 1.f },
+        Transform::compose({ 1.f, -2.f, 3.f }, glm::angleAxis(0.7f, glm::normalize(glm::vec3 { 1.f, 1.f, 0.f })), { 2.f, 2.f, 2.f }),
+        sheared,
+    };
+    file.grouped = true;
+
+    REQUIRE(file.valid());
+    return file;
+}
+
+void checkSame(SceneFile const &a, SceneFile const &b, bool exactWorlds)
+{
+    REQUIRE(a.meshes.size() == b.meshes.size());
+    for (size_t i = 0; i < a.meshes.size(); ++i)
+    {
+        CHECK(a.meshes[i].name == b.meshes[i].name);
+        CHECK(a.meshes[i].primitive == b.meshes[i].primitive);
+        CHECK(a.meshes[i].source == b.meshes[i].source);
+        CHECK(a.meshes[i].id == b.meshes[i].id);
+    }
+
+    REQUIRE(a.materials.size() == b.materials.size());
+    for (size_t i = 0; i < a.materials.size(); ++i)
+    {
+        CHECK(a.materials[i].name == b.materials[i].name);
+        CHECK(a.materials[i].id == b.materials[i].id);
+    }
+
+    REQUIRE(a.cameras.size() == b.cameras.size());
+    for (size_t i = 0; i < a.cameras.size(); ++i)
+    {
+        CHECK(a.cameras[i].name() == b.cameras[i].name());
+        CHECK(a.cameras[i].eye() == b.cameras[i].eye());
+        CHECK(a.cameras[i].lookAt() == b.cameras[i].lookAt());
+        CHECK(a.cameras[i].fov() == b.cameras[i].fov());
+        CHECK(a.cameras[i].mode() == b.cameras[i].mode());
+    }
+
+    CHECK(a.mesh == b.mesh);
+    CHECK(a.material == b.material);
+    CHECK(a.grouped == b.grouped);
+
+    REQUIRE(a.size() == b.size());
+    for (u32 i = 0; i < a.size(); ++i)
+    {
+        if (exactWorlds)
+        {
+            CHECK(a.world[i] == b.world[i]);
+            continue;
+        }
+
+        // TRS objects go through a decompose and back on JSON
+        bool same = true;
+        for (i32 c = 0; c < 4; ++c) same &= math::fuzzyCmp(a.world[i][c], b.world[i][c], 1e-4f);
+        CHECK(same);
+    }
+}
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+TEST_CASE("JSON scene files round trip", "[sceneFile]")
+{
+    auto const path = tempPath("scene.json");
+    auto const file = makeFile();
+
+    REQUIRE(saveSceneFile(file, path));
+
+    SceneFile loaded;
+    REQUIRE(loadSceneFile(path, loaded));
+    checkSame(file, loaded, false);
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Binary scene files round trip exactly", "[sceneFile]")
+{
+    auto const path = tempPath("scene.bmscene");
+    auto const file = makeFile();
+
+    REQUIRE(saveSceneFile(file, path));
+
+    SceneFile loaded;
+    REQUIRE(loadSceneFile(path, loaded));
+    checkSame(file, loaded, true);
+
+    // And again from what was loaded, byte for byte
+    auto const again = tempPath("scene2.bmscene");
+    REQUIRE(writeSceneBinary(loaded, again));
+    CHECK(readBytes(path) == readBytes(again));
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(again);
+}
+
+TEST_CASE("Truncated binary scene files are rejected", "[sceneFile]")
+{
+    auto const path = tempPath("truncated.bmscene");
+    REQUIRE(writeSceneBinary(makeFile(), path));
+
+    auto const bytes = readBytes(path);
+    REQUIRE(bytes.size() > 16);
+
+    // Inside the header, inside the tables, and the last byte of the strings
+    for (size_t const size : { (size_t)8, bytes.size() / 2, bytes.size() - 1 })
+    {
+        writeBytes(path, { bytes.begin(), bytes.begin() + (std::ptrdiff_t)size });
+
+        SceneFile loaded;
+        CHECK_FALSE(readSceneBinary(path, loaded));
+        CHECK(loaded.size() == 0);
+        CHECK(loaded.meshes.empty());
+    }
+
+    std::filesystem::remove(path);
+
+    SceneFile missing;
+    CHECK_FALSE(readSceneBinary(tempPath("missing.bmscene"), missing));
+}
+
+TEST_CASE("Scene files of another version are rejected", "[sceneFile]")
+{
+    SECTION("Binary")
+    {
+        auto const path = tempPath("version.bmscene");
+        REQUIRE(writeSceneBinary(makeFile(), path));
+
+        // The version follows the 4 byte magic
+        auto      bytes   = readBytes(path);
+        u32 const version = SceneFile::sVersion + 1;
+        memcpy(bytes.data() + 4, &version, sizeof(u32));
+        writeBytes(path, bytes);
+
+        SceneFile loaded;
+        CHECK_FALSE(readSceneBinary(path, loaded));
+        CHECK(loaded.size() == 0);
+
+        std::filesystem::remove(path);
+    }
+
+    SECTION("JSON")
+    {
+        auto const path = tempPath("version.json");
+        auto const text = BM_FMT(R"({{ "version": {}, "meshes": [], "materials": [], "objects": [] }})", SceneFile::sVersion + 1);
+        writeBytes(path, { text.begin(), text.end() });
+
+        SceneFile loaded;
+        CHECK_FALSE(readSceneJson(path, loaded));
+
+        std::filesystem::remove(path);
+    }
+}
+
+TEST_CASE("Malformed JSON scene files are rejected", "[sceneFile]")
+{
+    auto const path = tempPath("malformed.json");
+
+    auto const check = [&](std::string const &text)
+    {
+        writeBytes(path, { text.begin(), text.end() });
+
+        SceneFile loaded;
+        CHECK_FALSE(readSceneJson(path, loaded));
+    };
+
+    auto const version = std::to_string(SceneFile::sVersion);
+
+    check(R"({ "version": )");                                                                   // Not JSON
+    check(R"({ "version": )" + version + " }");                                                  // No objects
+    check(R"({ "version": )" + version + R"(, "objects": [ { "mesh": 0, "material": 0 } ] })");  // Out of range
+    check(R"({ "version": )" + version + R"(, "meshes": [ {} ], "objects": [] })");              // Nameless mesh
+
+    std::filesystem::remove(path);
+}
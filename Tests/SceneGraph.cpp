@@ -0,0 +1,77 @@
+#include "Bretema/vk/scene.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace bm;
+
+//-----------------------------------------------------------------------------
+
+// root (0) -> arm (1) -> hand (2)
+//          -> leg (3)
+// Every node holds one drawable of a unit cube
+TEST_CASE("Moving a node only moves the drawables of its subtree", "[sceneGraph]")
+{
+    ds::HandlePool<vk::Mesh>     meshes;
+    ds::HandlePool<vk::Material> materials;
+
+    vk::Mesh cube;
+    cube.bounds.expand(glm::vec3 { -1.f });
+    cube.bounds.expand(glm::vec3 { 1.f });
+
+    auto const mesh     = meshes.add(cube, ds::stableId("cube"));
+    auto const material = materials.add({}, ds::stableId("default"));
+
+    auto const offset = [](float x) { return glm::translate(glm::mat4 { 1.f }, glm::vec3 { x, 0.f, 0.f }); };
+
+    SceneGraph graph;
+    u32 const  root = graph.add(SceneGraph::sNone, offset(1.f));
+    u32 const  arm  = graph.add(root, offset(2.f));
+    u32 const  hand = graph.add(arm, offset(3.f));
+    u32 const  leg  = graph.add(root, offset(4.f));
+
+    vk::Scene                      scene { meshes };
+    std::vector<u32>               nodeFirst;
+    std::vector<vk::Scene::Entity> nodeEntities;
+
+    for (u32 node = 0; node < graph.size(); ++node)
+    {
+        nodeFirst.push_back((u32)nodeEntities.size());
+        nodeEntities.push_back(scene.add(mesh, material, graph.world(node)));
+    }
+    nodeFirst.push_back((u32)nodeEntities.size());
+
+    auto const entities = nodeEntities;
+    scene.setGraph(std::move(graph), std::move(nodeFirst), std::move(nodeEntities));
+
+    auto const worldOf  = [&](u32 node) { return scene.registry().get<vk::cmp::Transform>(entities[node]).world; };
+    auto const boundsOf = [&](u32 node) { return scene.registry().get<vk::cmp::Bounds>(entities[node]).world; };
+
+    std::vector<glm::mat4>  worldsBefore;
+    std::vector<math::AABB> boundsBefore;
+    for (u32 node = 0; node < entities.size(); ++node)
+    {
+        worldsBefore.push_back(worldOf(node));
+        boundsBefore.push_back(boundsOf(node));
+    }
+
+    REQUIRE(scene.updateGraph() == 0);  // Nothing moved yet
+
+    scene.setLocal(arm, offset(10.f));
+    REQUIRE(scene.updateGraph() == 2);  // Arm and hand
+
+    // Outside the subtree : untouched
+    for (u32 const node : { root, leg })
+    {
+        CHECK(worldOf(node) == worldsBefore[node]);
+        CHECK(boundsOf(node).min == boundsBefore[node].min);
+        CHECK(boundsOf(node).max == boundsBefore[node].max);
+    }
+
+    // Inside : root (1) + arm (10) [+ hand (3)], bounds follow
+    CHECK(worldOf(arm) == offset(11.f));
+    CHECK(worldOf(hand) == offset(14.f));
+    CHECK(boundsOf(arm).min == glm::vec3 { 10.f, -1.f, -1.f });
+    CHECK(boundsOf(hand).max == glm::vec3 { 15.f, 1.f, 1.f });
+
+    REQUIRE(scene.updateGraph() == 0);  // Flags are consumed
+}
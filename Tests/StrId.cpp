@@ -0,0 +1,63 @@
+#include "Bretema/bm/strId.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <unordered_map>
+
+using namespace bm;
+
+//-----------------------------------------------------------------------------
+
+TEST_CASE("Compile time and runtime ids of a name are equal", "[strId]")
+{
+    static constexpr StrId sLiteral = "mesh/cube"_sid;
+    static_assert(sLiteral.value() == StrId::hash("mesh/cube"));
+
+    std::string const runtime = std::string("mesh/") + "cube";
+
+    CHECK(StrId(runtime) == sLiteral);
+    CHECK(StrId(std::string_view(runtime)) == sLiteral);
+    CHECK(StrId(runtime.c_str()) == sLiteral);
+    CHECK(StrId(runtime).value() == sLiteral.value());
+}
+
+TEST_CASE("Ids hash with 64-bit FNV-1a", "[strId]")
+{
+    // Reference values of the algorithm, not of this implementation
+    static_assert(StrId::hash("") == 0xcbf29ce484222325ull);
+    static_assert(StrId::hash("a") == 0xaf63dc4c8601ec8cull);
+    static_assert(StrId::hash("foobar") == 0x85944171f73967e8ull);
+
+    CHECK(StrId().empty());
+    CHECK(StrId("").empty());
+    CHECK_FALSE("a"_sid.empty());
+}
+
+TEST_CASE("Different names give different ids", "[strId]")
+{
+    CHECK("forward"_sid != "deferred"_sid);
+    CHECK("a"_sid != "A"_sid);
+    CHECK(StrId::hash("key") != StrId::hash("key", 0x84222325cbf29ce4ull));  // Seeded hashes are independent
+}
+
+TEST_CASE("Ids work as hash map keys", "[strId]")
+{
+    std::unordered_map<StrId, int> map;
+    map["scene"_sid]         = 1;
+    map[StrId("materials")] = 2;
+
+    CHECK(map.at(StrId(std::string("scene"))) == 1);
+    CHECK(map.at("materials"_sid) == 2);
+    CHECK(map.find("missing"_sid) == map.end());
+}
+
+TEST_CASE("Runtime ids print back their name", "[strId]")
+{
+    StrId const id { std::string("printable") };
+
+#ifndef NDEBUG
+    CHECK(id.str() == "printable");
+#else
+    CHECK(id.str() == fmt::format("#{:016x}", id.value()));
+#endif
+}
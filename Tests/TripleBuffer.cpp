@@ -0,0 +1,103 @@
+#include "Bretema/bm/tripleBuffer.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <thread>
+
+using namespace bm;
+
+//-----------------------------------------------------------------------------
+
+TEST_CASE("Fetch hands over the newest publish, once", "[tripleBuffer]")
+{
+    ds::TripleBuffer<u64> buffer { 0 };
+
+    REQUIRE_FALSE(buffer.fetch());  // Nothing published yet
+
+    buffer.back() = 1;
+    buffer.publish();
+    REQUIRE(buffer.fetch());
+    CHECK(buffer.front() == 1);
+    CHECK_FALSE(buffer.fetch());  // Already taken
+    CHECK(buffer.front() == 1);   // And still there
+
+    // Publishes nobody fetched are replaced, never queued
+    for (u64 v = 2; v <= 4; ++v)
+    {
+        buffer.back() = v;
+        buffer.publish();
+    }
+    REQUIRE(buffer.fetch());
+    CHECK(buffer.front() == 4);
+    CHECK_FALSE(buffer.fetch());
+}
+
+TEST_CASE("The producer never writes into the consumer's slot", "[tripleBuffer]")
+{
+    ds::TripleBuffer<u64> buffer { 0 };
+
+    buffer.back() = 1;
+    buffer.publish();
+    REQUIRE(buffer.fetch());
+
+    // Two publishes in a row cycle the other two slots, 'front' keeps its value
+    for (u64 v = 2; v <= 5; ++v)
+    {
+        buffer.back() = v;
+        buffer.publish();
+        CHECK(buffer.front() == 1);
+    }
+}
+
+TEST_CASE("Closing wakes the consumer for good", "[tripleBuffer]")
+{
+    ds::TripleBuffer<u64> buffer { 0 };
+
+    bool        fetched = true;
+    std::thread consumer([&] { fetched = buffer.waitFetch(); });
+    buffer.close();
+    consumer.join();
+
+    CHECK_FALSE(fetched);
+    CHECK(buffer.isClosed());
+    buffer.waitConsumed();  // Returns right away once closed
+}
+
+TEST_CASE("Across threads the consumer sees publishes in order", "[tripleBuffer]")
+{
+    static constexpr u64 sCount = 100'000;
+
+    ds::TripleBuffer<u64> buffer { 0 };
+
+    std::vector<u64> seen;
+    seen.reserve(sCount);
+
+    std::thread consumer(
+      [&]
+      {
+          while (buffer.waitFetch())
+              seen.push_back(buffer.front());
+      });
+
+    for (u64 v = 1; v <= sCount; ++v)
+    {
+        buffer.back() = v;
+        buffer.publish();
+
+        if (v % 1'000 == 0)
+            buffer.waitConsumed();  // Paced like the app, so the last publish is always taken
+    }
+
+    buffer.waitConsumed();
+    buffer.close();
+    consumer.join();
+
+    REQUIRE_FALSE(seen.empty());
+    CHECK(seen.back() == sCount);
+
+    // Skipping is fine, going back or repeating is not
+    bool increasing = true;
+    for (size_t i = 1; i < seen.size(); ++i)
+        increasing &= seen[i] > seen[i - 1];
+    CHECK(increasing);
+}
@@ -0,0 +1,276 @@
+#include "Bretema/bm/renderer.hpp"
+#include "Bretema/bm/frameStats.hpp"
+#include "Bretema/vk/renderer.hpp"
+
+#include <argparse.hpp>
+#include <json.hpp>
+
+#include <bit>
+#include <fstream>
+#include <iostream>
+
+BM_FORCE_DISCRETE_GPU;
+
+//-----------------------------------------------------------------------------
+
+// bench [--grid N] [--spacing S] [--path orbit|flyby|static] [--frames F] [--warmup W] [--occlusion] [--gpu-culling] [--msaa N] [--pick] [--scene file] [--save-scene file] [--out file.json] ...
+// Headless run over a synthetic grid scene with a scripted camera, writes the measurements as JSON.
+// The engine logs to stdout, so the report only goes there when asked for ('--out -')
+
+using json = nlohmann::json;
+
+struct Pose
+{
+    glm::vec3 eye    = {};
+    glm::vec3 lookAt = {};
+};
+
+// Camera position at 't' in [0, 1] of the path, 'extent' is half the side of the grid in world units
+static Pose cameraPath(std::string const &path, float t, float extent)
+{
+    float const r = std::max(extent, 1.f);
+
+    if (path == "orbit")  // Full turn around the grid, looking at its center
+    {
+        float const a = t * glm::two_pi<float>();
+        return { glm::vec3(glm::cos(a) * r * 1.5f, r * 0.5f, glm::sin(a) * r * 1.5f), ZERO3 };
+    }
+
+    if (path == "flyby")  // Low pass over the diagonal, looking ahead : most of the grid is behind or off-screen
+    {
+        auto const from = glm::vec3(-r * 1.2f, r * 0.15f, -r * 1.2f);
+        auto const to   = glm::vec3(r * 1.2f, r * 0.15f, r * 1.2f);
+        auto const eye  = glm::mix(from, to, t);
+        return { eye, eye + glm::normalize(to - from) };
+    }
+
+    // Static : the whole grid in view
+    return { glm::vec3(0.f, r * 1.2f, r * 1.5f), ZERO3 };
+}
+
+static json summaryJson(bm::FrameStats const &stats)
+{
+    auto const S = stats.summary();
+    return { { "count", S.count }, { "min", S.min }, { "avg", S.avg }, { "p50", S.p50 }, { "p95", S.p95 }, { "p99", S.p99 }, { "max", S.max } };
+}
+
+static u64 toNs(float ms)
+{
+    return (u64)(double(ms) * 1e6);
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    argparse::ArgumentParser args { "bench" };
+
+    args.add_argument("--grid").help("objects per side of the synthetic scene").default_value(100u).scan<'u', u32>();
+    args.add_argument("--spacing").help("distance between objects").default_value(1.f).scan<'g', float>();
+    args.add_argument("--path").help("camera path : orbit, flyby or static").default_value(std::string { "orbit" });
+    args.add_argument("--frames").help("measured frames").default_value(600u).scan<'u', u32>();
+    args.add_argument("--warmup").help("frames drawn before measuring").default_value(60u).scan<'u', u32>();
+    args.add_argument("--width").default_value(1920u).scan<'u', u32>();
+    args.add_argument("--height").default_value(1080u).scan<'u', u32>();
+    args.add_argument("--fov").help("vertical field of view in degrees").default_value(60.f).scan<'g', float>();
+    args.add_argument("--bindless").help("per-object data through the bindless table").default_value(false).implicit_value(true);
+    args.add_argument("--occlusion").help("CPU occlusion culling after frustum culling").default_value(false).implicit_value(true);
+    args.add_argument("--gpu-culling").help("two-phase occlusion culling on the GPU, implies --bindless").default_value(false).implicit_value(true);
+    args.add_argument("--msaa").help("samples per pixel : 1 (off), 2, 4 or 8, clamped to the device").default_value(1u).scan<'u', u32>();
+    args.add_argument("--pick").help("cast a pick ray through the center of the view every frame").default_value(false).implicit_value(true);
+    args.add_argument("--scene").help("scene file (.json or binary) drawn instead of the grid, the camera path still follows --grid").default_value(std::string {});
+    args.add_argument("--save-scene").help("write the benchmarked scene to this file, binary unless it ends in .json").default_value(std::string {});
+    args.add_argument("--out").help("JSON output file, '-' for stdout").default_value(std::string { "bench.json" });
+
+    try
+    {
+        args.parse_args(argc, argv);
+    }
+    catch (std::exception const &e)
+    {
+        std::cerr << e.what() << "\n" << args;
+        return 1;
+    }
+
+    auto const grid    = args.get<u32>("--grid");
+    auto const spacing = args.get<float>("--spacing");
+    auto const path    = args.get<std::string>("--path");
+    auto const frames  = args.get<u32>("--frames");
+    auto const warmup  = args.get<u32>("--warmup");
+    auto const fov     = args.get<float>("--fov");
+    auto const pick    = args.get<bool>("--pick");
+    auto const out     = args.get<std::string>("--out");
+    auto const scene   = args.get<std::string>("--scene");
+    auto const save    = args.get<std::string>("--save-scene");
+    auto const msaa    = args.get<u32>("--msaa");
+
+    if (msaa > 8 || !std::has_single_bit(msaa))
+    {
+        std::cerr << "MSAA must be 1, 2, 4 or 8, got " << msaa << "\n" << args;
+        return 1;
+    }
+
+    if (path != "orbit" && path != "flyby" && path != "static")
+    {
+        std::cerr << "Unknown camera path '" << path << "'\n" << args;
+        return 1;
+    }
+
+    //-----
+
+    bm::RendererSettings settings = {};
+    settings.headless             = true;
+    settings.headlessSize         = { args.get<u32>("--width"), args.get<u32>("--height") };
+    settings.bindless             = args.get<bool>("--bindless");
+    settings.occlusion            = args.get<bool>("--occlusion");
+    settings.gpuCulling           = args.get<bool>("--gpu-culling");
+    settings.bindless             = settings.bindless || settings.gpuCulling;
+    settings.msaa                 = static_cast<bm::Samples>(std::countr_zero(msaa));
+
+    bm::vk::Renderer renderer { nullptr, settings };
+
+    auto const loadBegin = std::chrono::steady_clock::now();
+
+    if (scene.empty())
+        renderer.buildGridScene("bench", grid, spacing);
+    else if (!renderer.loadScene("bench", scene))
+        return 1;
+
+    float const loadMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - loadBegin).count();
+
+    if (!save.empty() && !renderer.saveScene("bench", save))
+        return 1;
+
+    // What is actually drawn : a loaded scene has nothing to do with '--grid'
+    u32 const sceneObjects = [&]
+    {
+        bm::SceneFile drawn;
+        return renderer.exportScene("bench", drawn) ? drawn.size() : 0u;
+    }();
+
+    bm::FrameSnapshot snap = {};
+    snap.scene             = "bench";
+    snap.size              = glm::vec2(settings.headlessSize);
+    snap.proj              = glm::perspective(-glm::radians(fov), snap.size.x / snap.size.y, 0.1f, 1'000.f);
+    snap.pick              = pick;
+
+    float const extent = float(grid > 0 ? grid - 1 : 0) * spacing * 0.5f;
+
+    //-----
+
+    bm::FrameStats frameTimes = {};  // Whole frame, including the wait on the GPU
+    bm::FrameStats cpuTimes   = {};  // Recording and submission only
+    bm::FrameStats gpuTimes   = {};
+    bm::FrameStats pickTimes  = {};
+    u32            pickHits   = 0;
+
+    u64 draws = 0, objects = 0, occluded = 0, pipelineBinds = 0, meshBinds = 0;
+    u32 minDraws = ~0u, maxDraws = 0;
+
+    for (u32 i = 0; i < warmup + frames; ++i)
+    {
+        bool const  measured = i >= warmup;
+        float const t       = measured && frames > 1 ? float(i - warmup) / float(frames - 1) : 0.f;
+
+        auto const pose = cameraPath(path, t, extent);
+        snap.frame      = i;
+        snap.view       = glm::lookAt(pose.eye, pose.lookAt, UP);
+        snap.pickRay    = bm::math::unproject(snap.size * 0.5f, snap.size, snap.viewproj());
+
+        renderer.beginFrame();
+
+        auto const cpuBegin = bm::FrameStats::Clock::now();
+        renderer.update(snap);
+        renderer.draw(snap);
+        auto const cpuEnd = bm::FrameStats::Clock::now();
+
+        if (!measured)
+        {
+            frameTimes.restart(cpuEnd);
+            continue;
+        }
+
+        frameTimes.tick(cpuEnd);
+        cpuTimes.push((u64)std::chrono::duration_cast<std::chrono::nanoseconds>(cpuEnd - cpuBegin).count());
+
+        // Lags a few frames behind, 0 until the first results arrive or when timestamps aren't supported
+        if (float const gpu = renderer.gpuTime(); gpu > 0.f)
+            gpuTimes.push(toNs(gpu));
+
+        if (auto const P = renderer.picked(); pick && P.frame == snap.frame)
+        {
+            pickTimes.push(toNs(P.ms));
+            pickHits += P.hit();
+        }
+
+        auto const &D = renderer.drawStats();
+        draws += D.draws;
+        objects += D.objects;
+        occluded += D.occluded;
+        pipelineBinds += D.pipelineBinds;
+        meshBinds += D.meshBinds;
+        minDraws = std::min(minDraws, D.draws);
+        maxDraws = std::max(maxDraws, D.draws);
+    }
+
+    auto const samples = renderer.sampleCount();  // What the device allowed, not what was asked
+    renderer.cleanup();
+
+    //-----
+
+    double const n = std::max(frames, 1u);
+
+    json report = {
+        { "config",
+          {
+            { "grid", grid },
+            { "objects", sceneObjects },
+            { "spacing", spacing },
+            { "path", path },
+            { "frames", frames },
+            { "warmup", warmup },
+            { "resolution", { settings.headlessSize.x, settings.headlessSize.y } },
+            { "bindless", settings.bindless },
+            { "occlusion", settings.occlusion },
+            { "gpu_culling", settings.gpuCulling },
+            { "msaa", samples },
+            { "msaa_requested", msaa },
+            { "pick", pick },
+            { "scene", scene },
+          } },
+        { "scene_load_ms", loadMs },
+        { "frame_ms", summaryJson(frameTimes) },
+        { "cpu_ms", summaryJson(cpuTimes) },
+        { "gpu_ms", summaryJson(gpuTimes) },
+        { "pick_ms", summaryJson(pickTimes) },
+        { "pick_hits", pickHits },
+        { "draws",
+          {
+            { "avg", double(draws) / n },
+            { "min", frames > 0 ? minDraws : 0u },
+            { "max", maxDraws },
+            { "objects_avg", double(objects) / n },
+            { "occluded_avg", double(occluded) / n },
+            { "pipeline_binds_avg", double(pipelineBinds) / n },
+            { "mesh_binds_avg", double(meshBinds) / n },
+          } },
+    };
+
+    if (out == "-")
+    {
+        std::cout << report.dump(2) << "\n";
+        return 0;
+    }
+
+    auto file = std::ofstream { out };
+    if (!file.is_open())
+    {
+        std::cerr << "Couldn't open " << out << "\n";
+        return 1;
+    }
+
+    file << report.dump(2) << "\n";
+    BM_INFOF("Bench : report written to {}", out);
+
+    return 0;
+}
@@ -1,11 +1,25 @@
 #include "Bretema/bm/app.hpp"
 
+#include <string_view>
+
 BM_FORCE_DISCRETE_GPU;
 
 int main(int argc, char *argv[])
 {
+    // main --headless [frames] [out.png] : offscreen run without window (CI, GPU-less servers)
+    if (argc > 1 && std::string_view(argv[1]) == "--headless")
+    {
+        bm::RendererSettings settings = {};
+        settings.headless             = true;
+
+        bm::App app { "Bretema Engine", bm::RenderAPI::Vulkan, settings };
+        app.runHeadless(argc > 2 ? (u32)std::stoul(argv[2]) : 1u, argc > 3 ? argv[3] : "");
+
+        return 0;
+    }
+
     bm::App app { "Bretema Engine", bm::RenderAPI::Vulkan };
     app.runLoop();
 
     return 0;
-}
\ No newline at end of file
+}